@@ -1,117 +1,178 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *  
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#ifndef __APPLET_H__
-#define __APPLET_H__
-
-#include "SEInterface.h"
-
-#ifdef __cplusplus
-
-class Applet {
-	public:
-		// Create an instance of Applet and settings its corresponding AID.
-		Applet(uint8_t* aid, uint16_t aidLen);
-		~Applet(void);
-		
-		// Configure Applet instance with Secure Element access interface to use
-		// to access the targetted applet.
-		void init(SEInterface* se);
-
-		// Returns true in case applet is selected, false otherwise.
-		bool isSelected(void);
-	
-		// Select the applet using basic or logical channel.
-		// Returns true in case select was successful, false otherwise.
-		bool select(bool isBasic=true);
-		
-		// Deselect the applet by closing the channel opened during the
-		// select phase.
-		// Returns true in case deselect was successful, false otherwise.
-		bool deselect(void);
-		
-		// Transmit an APDU case 1 to the applet through the corresponding 
-		// channel.
-		// Returns true in case transmit was successful, false otherwise.
-		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2);
-		
-		// Transmit an APDU case 2 to the applet through the corresponding 
-		// channel.
-		// Returns true in case transmit was successful, false otherwise.
-		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le);
-		
-		// Transmit an APDU case 3 to the applet through the corresponding 
-		// channel.
-		// Returns true in case transmit was successful, false otherwise.
-		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen);
-		
-		// Transmit an APDU case 4 to the applet through the corresponding
-		// channel.
-		// Returns true in case transmit was successful, false otherwise.
-		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint8_t le);
-
-		// Returns the status word received after the last successful transmit, 
-		// 0 otherwise.
-		uint16_t getStatusWord(void);
-		
-		// Copy the data response received after the last successful transmit and
-		// returns its length, 0 otherwise.
-		uint16_t getResponse(uint8_t* data);
-		
-		// Returns the length of the data response received after the last 
-		// successful transmit, 0 otherwise.
-		uint16_t getResponseLength(void);
-		
-	protected:
-		SEInterface* _seiface;	// Secure Element on which is installed the targetted applet.
-		uint8_t _channel;		// channel value
-		bool _isSelected;   	// flag to indicate if the applet is currently selected.
-		bool _isBasic;   		// flag to indicate if the applet has been selected through basic channel.
-		uint8_t* _aid;      	// Applet's AID
-		uint16_t _aidLen;   	// Applet's AID length
-};
-
-#else 
-	
-typedef struct Applet Applet;
-
-Applet* Applet_create(uint8_t* aid, uint16_t aid_len);
-void Applet_destroy(Applet* applet);
-
-void Applet_init(Applet* applet, SEInterface* seiface);
-bool Applet_is_selected(Applet* applet);
-bool Applet_select(Applet* applet, bool is_basic);
-bool Applet_deselect(Applet* applet);
-		
-bool Applet_transmit_case1(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2);
-bool Applet_transmit_case2(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le);
-bool Applet_transmit_case3(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len);
-bool Applet_transmit_case4(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint8_t le);
-
-uint16_t Applet_get_status_word(Applet* applet);
-uint16_t Applet_get_response(Applet* applet, uint8_t* data);
-uint16_t Applet_get_response_length(Applet* applet);
-		
-#endif
-
-#endif /* __APPLET_H__ */
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __APPLET_H__
+#define __APPLET_H__
+
+#include "SEInterface.h"
+
+// Number of bytes, taken at the end of an object, used to compute its fingerprint.
+#define APPLET_FINGERPRINT_LENGTH 32
+
+#ifdef __cplusplus
+
+class Applet {
+	public:
+		// Create an instance of Applet and settings its corresponding AID.
+		Applet(uint8_t* aid, uint16_t aidLen);
+		virtual ~Applet(void);
+		
+		// Configure Applet instance with Secure Element access interface to use
+		// to access the targetted applet.
+		void init(SEInterface* se);
+
+		// Returns true in case applet is selected, false otherwise.
+		bool isSelected(void);
+	
+		// Select the applet using basic or logical channel.
+		// Logical channels come from the SE channel pool: in case the applet is still selected
+		// on the channel assigned to it, nothing is sent.
+		// Returns true in case select was successful, false otherwise.
+		bool select(bool isBasic=true);
+		
+		// Deselect the applet by closing the channel opened during the
+		// select phase, or by giving it back to the SE channel pool.
+		// Returns true in case deselect was successful, false otherwise.
+		bool deselect(void);
+
+		// Deselect the applet and close its pooled channel, so that next select
+		// selects it again on a new channel.
+		void close(void);
+		
+		// Transmit an APDU case 1 to the applet through the corresponding 
+		// channel.
+		// Returns true in case transmit was successful, false otherwise.
+		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2);
+		
+		// Transmit an APDU case 2 to the applet through the corresponding 
+		// channel.
+		// Returns true in case transmit was successful, false otherwise.
+		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le);
+		
+		// Transmit an APDU case 3 to the applet through the corresponding 
+		// channel.
+		// Returns true in case transmit was successful, false otherwise.
+		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen);
+		
+		// Transmit an APDU case 4 to the applet through the corresponding
+		// channel.
+		// Returns true in case transmit was successful, false otherwise.
+		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint8_t le);
+
+		// Transmit an APDU of any case to the applet through the corresponding
+		// channel, using extended length when needed and supported.
+		// Ne parameter is the expected response length, 0 if no response data is expected.
+		// Returns true in case transmit was successful, false otherwise.
+		bool transmitExtended(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint16_t ne);
+
+		// Same as above, but the whole response data, including 61xx continuations, is
+		// assembled directly into the response buffer.
+		// ResponseLen parameter is the response buffer size on input, including 2 bytes
+		// for the status word, and the received data length on output.
+		// Returns true in case transmit was successful, false otherwise.
+		bool transmitExtended(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint16_t ne, uint8_t* response, uint16_t* responseLen);
+
+		// Returns the maximum response data length that can be received within a
+		// single APDU, SE_SHORT_MAX_DATA_LENGTH if extended length is not used.
+		uint16_t getMaxResponseLength(void);
+
+		// Read data from the currently selected EF, using the longest READ BINARY allowed.
+		// Offset parameter is the position of the first byte to read within the EF.
+		// Data parameter must have room for 2 more bytes as the status word is received
+		// right after the data.
+		// Returns true in case all requested bytes were read, false otherwise.
+		bool readBinary(uint16_t offset, uint8_t* data, uint16_t len);
+
+		// Read and inflate the zlib stream of size bytes located at offset in the currently
+		// selected EF. Compressed data is read by chunks, only the uncompressed data is held.
+		// Data parameter receives the len bytes of uncompressed data.
+		// Returns true in case exactly len bytes were inflated and their checksum matched, false otherwise.
+		bool readInflatedBinary(uint16_t offset, uint16_t size, uint8_t* data, uint16_t len);
+
+		// Returns the status word received after the last successful transmit, 
+		// 0 otherwise.
+		uint16_t getStatusWord(void);
+		
+		// Copy the data response received after the last successful transmit and
+		// returns its length, 0 otherwise.
+		uint16_t getResponse(uint8_t* data);
+		
+		// Returns the length of the data response received after the last 
+		// successful transmit, 0 otherwise.
+		uint16_t getResponseLength(void);
+		
+	protected:
+		// Returns the length to request on each READ BINARY.
+		virtual uint16_t getReadBinaryLength(void);
+
+		// Compute a fingerprint (FNV-1a) of the extent and of the last APPLET_FINGERPRINT_LENGTH bytes
+		// of the DER objects located at offset within size bytes in the currently selected EF,
+		// padding after them is ignored.
+		// Returns true in case reading was successful, false otherwise.
+		bool readFingerprint(uint16_t offset, uint16_t size, uint32_t* fingerprint);
+
+		// Select the applet again on a new pooled channel in case the SE reported its channel is
+		// not open anymore (6881, e.g. SE was reset), so that the last command can be sent again.
+		// Returns true in case the command has to be sent again, false otherwise.
+		bool recoverChannel(void);
+
+		SEInterface* _seiface;	// Secure Element on which is installed the targetted applet.
+		uint8_t _channel;		// channel value
+		bool _isSelected;   	// flag to indicate if the applet is currently selected.
+		bool _isBasic;   		// flag to indicate if the applet has been selected through basic channel.
+		bool _isPooled;   		// flag to indicate if a channel of the SE channel pool is assigned to the applet.
+		uint32_t _selections;	// Number of SELECT sent, applet state on the SE is lost each time
+		uint8_t* _aid;      	// Applet's AID
+		uint16_t _aidLen;   	// Applet's AID length
+};
+
+#else 
+	
+typedef struct Applet Applet;
+
+Applet* Applet_create(uint8_t* aid, uint16_t aid_len);
+void Applet_destroy(Applet* applet);
+
+void Applet_init(Applet* applet, SEInterface* seiface);
+bool Applet_is_selected(Applet* applet);
+bool Applet_select(Applet* applet, bool is_basic);
+bool Applet_deselect(Applet* applet);
+void Applet_close(Applet* applet);
+		
+bool Applet_transmit_case1(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2);
+bool Applet_transmit_case2(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le);
+bool Applet_transmit_case3(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len);
+bool Applet_transmit_case4(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint8_t le);
+bool Applet_transmit_extended(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint16_t ne);
+bool Applet_transmit_extended_to(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint16_t ne, uint8_t* response, uint16_t* response_len);
+uint16_t Applet_get_max_response_length(Applet* applet);
+bool Applet_read_binary(Applet* applet, uint16_t offset, uint8_t* data, uint16_t len);
+bool Applet_read_inflated_binary(Applet* applet, uint16_t offset, uint16_t size, uint8_t* data, uint16_t len);
+
+uint16_t Applet_get_status_word(Applet* applet);
+uint16_t Applet_get_response(Applet* applet, uint8_t* data);
+uint16_t Applet_get_response_length(Applet* applet);
+		
+#endif
+
+#endif /* __APPLET_H__ */
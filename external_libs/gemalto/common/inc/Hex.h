@@ -0,0 +1,47 @@
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __HEX_H__
+#define __HEX_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Table driven hex codec, used to frame APDU over AT+CSIM and to decode SE paths.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Encode len bytes into 2 * len upper case hex digits, hex is not NUL terminated.
+void hex_encode(const uint8_t* bytes, uint16_t len, char* hex);
+
+// Decode hexLen lower or upper case hex digits into hexLen / 2 bytes, bytes may be hex itself.
+// Returns true in case hexLen is even and all characters are hex digits, false otherwise.
+bool hex_decode(const char* hex, uint16_t hexLen, uint8_t* bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEX_H__ */
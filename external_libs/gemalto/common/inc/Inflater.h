@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __INFLATER_H__
+#define __INFLATER_H__
+
+#include "Applet.h"
+
+// Size of the buffer holding compressed data read from the SE.
+#ifndef INFLATER_INPUT_BUFFER_SIZE
+#define INFLATER_INPUT_BUFFER_SIZE SE_SHORT_MAX_DATA_LENGTH
+#endif
+
+#ifdef __cplusplus
+
+// Canonical Huffman tree, codes are ordered by length then by symbol.
+typedef struct {
+	uint16_t counts[16];	// number of codes of each length
+	uint16_t symbols[288];	// symbols ordered by code
+} inflater_tree_t;
+
+// Streaming zlib (RFC 1950/1951) decoder reading its input from an EF by chunks.
+// The output buffer is used as history window, so only the input buffer and the
+// trees are needed on top of it, whatever the stream window size.
+class Inflater {
+	public:
+		// Create an instance of Inflater reading the compressed stream of size bytes
+		// located at offset in the EF currently selected on applet, chunkLen bytes at a time.
+		Inflater(Applet* applet, uint16_t offset, uint16_t size, uint16_t chunkLen);
+		~Inflater(void);
+
+		// Inflate the stream into data.
+		// Len parameter is the expected uncompressed length.
+		// Returns true in case exactly len bytes were inflated and their checksum matched, false otherwise.
+		bool inflate(uint8_t* data, uint16_t len);
+
+	private:
+		bool getByte(uint8_t* value);
+		bool getBits(uint8_t count, uint16_t* value);
+		bool buildTree(inflater_tree_t* tree, uint8_t* lengths, uint16_t count);
+		bool decodeSymbol(inflater_tree_t* tree, uint16_t* symbol);
+		bool decodeTrees(void);
+		void buildFixedTrees(void);
+		bool inflateStored(void);
+		bool inflateCompressed(void);
+
+		Applet* _applet;		// Applet on which the EF is selected
+		uint16_t _offset;		// Offset of the next chunk to read
+		uint16_t _end;			// End of the compressed stream
+		uint16_t _chunkLen;		// Length of each chunk to read
+		uint8_t _input[INFLATER_INPUT_BUFFER_SIZE + 2];
+		uint16_t _inputPos;
+		uint16_t _inputLen;
+		uint32_t _bits;			// Bits read but not yet consumed, LSB first
+		uint8_t _bitCount;
+		uint8_t* _out;
+		uint16_t _outPos;
+		uint16_t _outLen;
+		inflater_tree_t _lt;	// Literal/length tree
+		inflater_tree_t _dt;	// Distance tree
+};
+
+#endif
+
+#endif /* __INFLATER_H__ */
@@ -1,116 +1,415 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *  
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#ifndef __SE_INTERFACE_H__
-#define __SE_INTERFACE_H__
-
-#include <stdbool.h>
-#include <stdint.h>
-#include <string.h>
-
-#define APDU_CLA_OFFSET                0
-#define APDU_INS_OFFSET                1
-#define APDU_P1_OFFSET                 2
-#define APDU_P2_OFFSET                 3
-#define APDU_LE_OFFSET                 4
-#define APDU_LC_OFFSET                 4
-#define APDU_DATA_OFFSET               5
-
-//#define APDU_DEBUG
-
-#ifdef __cplusplus
-
-class SEInterface {
-	public:
-		
-		SEInterface(void);
-		virtual ~SEInterface(void);
-		
-		// Transmit an APDU case 1
-		// Returns true in case transmit was successful, false otherwise.
-		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2);
-		
-		// Transmit an APDU case 2
-		// Returns true in case transmit was successful, false otherwise.
-		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le);
-		
-		// Transmit an APDU case 3
-		// Returns true in case transmit was successful, false otherwise.
-		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen);
-		
-		// Transmit an APDU case 4
-		// Returns true in case transmit was successful, false otherwise.
-		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint8_t le);
-
-		// Returns the status word received after the last successful transmit, 0 otherwise.
-		uint16_t getStatusWord(void);
-		
-		// Copy the data response received after the last successful transmit and returns its length, 0 otherwise.
-		uint16_t getResponse(uint8_t* data);
-		
-		// Returns the length of the data response received after the last successful transmit, 0 otherwise.
-		uint16_t getResponseLength(void);
-
-		// Internal buffers
-		uint8_t  _apdu[5 + 256 + 1];
-		uint16_t _apduLen;
-		uint8_t  _apduResponse[2 + 256];
-		uint16_t _apduResponseLen;
-
-	protected:
-		
-		// Low layer implementation to transmit an APDU and retrieve the corresponding APDU Response
-		// Returns true in case transmit was successful, false otherwise
-		virtual bool transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen) = 0;
-	
-	private:
-		
-		// 'In between' layer implementation which auto handle 6Cxx and 61xx response
-		// Stack:
-		//  - transmitApdu 
-		//  - transmit	
-		//  - transmit (case 1 ... 4)
-		// Returns true in case transmit was successful, false otherwise
-		bool transmit(void);
-
-};
-
-#else 
-
-typedef struct SEInterface SEInterface; 
-
-bool SEInterface_lock(SEInterface* seiface);
-bool SEInterface_unlock(SEInterface* seiface);
-		
-bool SEInterface_transmit_case1(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2);
-bool SEInterface_transmit_case2(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le);
-bool SEInterface_transmit_case3(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len);
-bool SEInterface_transmit_case4(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint8_t le);
-
-uint16_t SEInterface_get_status_word(SEInterface* seiface);
-uint16_t SEInterface_get_response(SEInterface* seiface, uint8_t* data);
-uint16_t SEInterface_get_response_length(SEInterface* seiface);
-
-#endif
-
-#endif /* __SE_INTERFACE_H__ */
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __SE_INTERFACE_H__
+#define __SE_INTERFACE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define APDU_CLA_OFFSET                0
+#define APDU_INS_OFFSET                1
+#define APDU_P1_OFFSET                 2
+#define APDU_P2_OFFSET                 3
+#define APDU_LE_OFFSET                 4
+#define APDU_LC_OFFSET                 4
+#define APDU_DATA_OFFSET               5
+#define APDU_EXT_LC_OFFSET             5
+#define APDU_EXT_DATA_OFFSET           7
+
+// Maximum command or response data length handled by a single APDU. Lengths above
+// SE_SHORT_MAX_DATA_LENGTH require extended length support from both SE and transport.
+#ifndef SE_MAX_DATA_LENGTH
+#define SE_MAX_DATA_LENGTH             1024
+#endif
+#define SE_SHORT_MAX_DATA_LENGTH       256
+
+//#define APDU_DEBUG
+
+// Serialize secure element transactions between threads, define SE_NO_THREAD_SUPPORT on
+// single threaded targets.
+#if defined(__unix__) && !defined(SE_NO_THREAD_SUPPORT)
+#define SE_THREAD_SUPPORT
+#endif
+
+// Transaction priorities: when the secure element is released, highest priority waiter gets it first.
+#define SE_PRIORITY_LOW                0 // Background reads (certificates, objects)
+#define SE_PRIORITY_NORMAL             1
+#define SE_PRIORITY_HIGH               2 // Private key operations during handshake
+#define SE_PRIORITY_LEVELS             3
+
+// No deadline, exchanges wait for the SE as long as the low layer does.
+#define SE_WAIT_FOREVER                0xFFFFFFFF
+
+// Number of logical channels kept open by the channel pool between applet selections, 0 to open
+// and close a channel on each selection. Default leaves one of the 3 basic logical channels free
+// for other users of the SE.
+#ifndef SE_CHANNEL_POOL_SIZE
+#define SE_CHANNEL_POOL_SIZE           2
+#endif
+
+// Logical channel of the channel pool.
+typedef struct {
+	uint8_t     channel;       // Channel number, 0 when entry is free
+	const void* owner;         // Applet the channel is assigned to
+	bool        busy;          // Owner is currently selected on the channel
+	uint32_t    last_use;
+} se_channel_t;
+
+// APDU metrics: number of distinct INS tracked and latency histogram size.
+// Histogram bucket i counts exchanges which took less than 2^i ms, last bucket counts the others.
+#ifndef SE_STATS_MAX_INS
+#define SE_STATS_MAX_INS               16
+#endif
+#define SE_STATS_LATENCY_BUCKETS       12
+
+// Metrics of the commands sharing the same INS. GET RESPONSE and 6Cxx resends are
+// accounted to the command they belong to.
+typedef struct {
+	uint8_t  ins;
+	uint32_t commands;         // Commands issued by upper layers
+	uint32_t exchanges;        // Low layer exchanges, including GET RESPONSE and resends
+	uint32_t errors;           // Low layer failures
+	uint32_t bytes_sent;
+	uint32_t bytes_received;
+	uint32_t retries_61xx;
+	uint32_t retries_6cxx;
+	uint64_t latency_total_us;
+	uint32_t latency_max_us;
+	uint32_t latency_histogram[SE_STATS_LATENCY_BUCKETS];
+} se_ins_stats_t;
+
+typedef struct {
+	se_ins_stats_t total;
+	uint16_t       count;      // Number of INS entries in use
+	uint32_t       untracked;  // Commands not tracked per INS because all entries are in use
+	se_ins_stats_t ins[SE_STATS_MAX_INS];
+} se_stats_t;
+
+// Low layer exchange, as reported to the APDU hook.
+typedef struct {
+	uint8_t        ins;        // INS of the command issued by upper layers
+	const uint8_t* apdu;
+	uint16_t       apdu_len;
+	const uint8_t* response;
+	uint16_t       response_len;
+	uint32_t       latency_us;
+	bool           success;    // False in case of low layer failure, response is then empty
+} se_apdu_event_t;
+
+typedef void (*se_apdu_hook_t)(void* ctx, const se_apdu_event_t* event);
+
+// Deadline of the exchanges issued by a thread, see SEInterface::setDeadline.
+typedef struct {
+	bool     bounded;
+	uint32_t deadline;         // Timestamp in us, when bounded
+	bool     timedOut;         // An exchange failed because the deadline expired
+} se_deadline_t;
+
+#ifdef __cplusplus
+
+#ifdef SE_THREAD_SUPPORT
+#include <pthread.h>
+#endif
+
+class SEInterface {
+	public:
+		
+		SEInterface(void);
+		virtual ~SEInterface(void);
+
+		// Lock the secure element interface to prevent other threads to access the secure element,
+		// waiting for it to be released if needed. A whole applet transaction (select, verify,
+		// operation, deselect) is expected to run between lock and unlock. Lock can be nested.
+		// The outermost lock starts the low layer transaction, in case it fails the interface is
+		// locked anyway and must be unlocked as usual.
+		// Returns true in case locking was successful, false otherwise.
+		bool lock(void);
+		bool lock(uint8_t priority);
+
+		// Unlock the secure element interface to allow other threads to access the secure element.
+		// The outermost unlock ends the low layer transaction.
+		// Returns true in case unlocking was successful, false otherwise.
+		bool unlock(void);
+		
+		// Transmit an APDU case 1
+		// Returns true in case transmit was successful, false otherwise.
+		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2);
+		
+		// Transmit an APDU case 2
+		// Returns true in case transmit was successful, false otherwise.
+		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le);
+		
+		// Transmit an APDU case 3
+		// Returns true in case transmit was successful, false otherwise.
+		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen);
+		
+		// Transmit an APDU case 4
+		// Returns true in case transmit was successful, false otherwise.
+		bool transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint8_t le);
+
+		// Transmit an APDU of any case, using extended Lc/Le fields when needed and supported.
+		// Ne parameter is the expected response length, 0 if no response data is expected.
+		// When extended length is not available, data is sent using command chaining and
+		// Ne is limited to SE_SHORT_MAX_DATA_LENGTH.
+		// Returns true in case transmit was successful, false otherwise.
+		bool transmitExtended(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint16_t ne);
+
+		// Same as above, but the whole response data, including 61xx continuations, is assembled
+		// directly into the response buffer instead of the internal one.
+		// ResponseLen parameter is the response buffer size on input, which must leave room for the
+		// status word, and the received data length on output. Status word is retrieved with getStatusWord.
+		// Returns true in case transmit was successful, false otherwise.
+		bool transmitExtended(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint16_t ne, uint8_t* response, uint16_t* responseLen);
+
+		// Get the logical channel assigned to owner from the channel pool. In case owner has none,
+		// a channel is opened, or the least recently used one which is not busy is reassigned.
+		// Reused parameter tells whether the channel was already assigned to owner, in which case
+		// owner is still selected on it and nothing was sent.
+		// Returns true in case a channel was acquired, false otherwise (all channels busy or MANAGE CHANNEL failed).
+		bool acquireChannel(const void* owner, uint8_t* channel, bool* reused);
+
+		// Give the channel of owner back to the pool. It stays open and assigned to owner, so that
+		// owner can be selected again without any APDU.
+		void releaseChannel(const void* owner);
+
+		// Close the channel of owner and remove it from the pool.
+		void closeChannel(const void* owner);
+
+		// Close all channels of the pool.
+		void closeChannels(void);
+
+		// Forget all channels of the pool without closing them, e.g. once the SE was reset.
+		// A channel the SE reports as not open (6881) is forgotten on its own.
+		void resetChannels(void);
+
+		// Detect extended length support from the SE ATR or, if not available from the
+		// transport layer, from EF.ATR (2F01).
+		// Returns true in case extended length APDU are supported, false otherwise.
+		bool detectExtendedLength(void);
+
+		// Returns true in case extended length APDU are used, false otherwise.
+		bool isExtendedLength(void);
+
+		// Returns the maximum command data length that can be sent within a single APDU.
+		uint16_t getMaxCommandLength(void);
+
+		// Returns the maximum response data length that can be received within a single APDU.
+		uint16_t getMaxResponseLength(void);
+
+		// Returns the status word received after the last successful transmit, 0 otherwise.
+		uint16_t getStatusWord(void);
+		
+		// Copy the data response received after the last successful transmit and returns its length, 0 otherwise.
+		uint16_t getResponse(uint8_t* data);
+		
+		// Returns the length of the data response received after the last successful transmit, 0 otherwise.
+		uint16_t getResponseLength(void);
+
+		// Set a hook called after each low layer exchange, NULL to remove it.
+		void setApduHook(se_apdu_hook_t hook, void* ctx);
+
+		// Start or stop collecting APDU metrics. Metrics are kept when collection is stopped.
+		// Returns true in case metrics are collected, false otherwise.
+		bool enableStats(bool enable);
+
+		// Returns the metrics collected so far, NULL in case collection was never started.
+		const se_stats_t* getStats(void);
+
+		// Returns the metrics of the given INS, NULL in case none were collected.
+		const se_ins_stats_t* getStats(uint8_t ins);
+
+		// Clear the metrics collected so far.
+		void resetStats(void);
+
+		// Bound the exchanges issued by the calling thread from now on to timeout ms, e.g. the time
+		// left to establish a connection, SE_WAIT_FOREVER to remove the bound. Each low layer exchange
+		// is given the time left, and none is started once it expired. Other threads keep their own
+		// deadline.
+		void setDeadline(uint32_t timeout);
+
+		// Save the deadline of the calling thread, to restore it once a nested operation is done.
+		void saveDeadline(se_deadline_t* deadline);
+
+		// Restore the deadline of the calling thread saved with saveDeadline.
+		void restoreDeadline(const se_deadline_t* deadline);
+
+		// Returns the time left to the deadline of the calling thread in ms, 0 once it expired,
+		// SE_WAIT_FOREVER if none is set.
+		uint32_t getTimeLeft(void);
+
+		// Returns true in case an exchange of the calling thread failed because its deadline expired
+		// since it was set, false otherwise.
+		bool isTimedOut(void);
+
+		// Internal buffers
+		uint8_t  _apdu[APDU_EXT_DATA_OFFSET + SE_MAX_DATA_LENGTH + 2];
+		uint16_t _apduLen;
+		bool     _apduHasLe; // Short APDU ending with Le (case 2 or 4), which a 6Cxx status word corrects
+		uint8_t  _apduResponse[SE_MAX_DATA_LENGTH + 2];
+		uint16_t _apduResponseLen;
+
+	protected:
+
+		// Trace recorder forwards low layer calls to the interface it wraps.
+		friend class SETraceRecorder;
+		
+		// Low layer implementation to transmit an APDU and retrieve the corresponding APDU Response
+		// ResponseLen parameter is the room left in response buffer on input, the response length on output.
+		// Timeout parameter is the time left to the deadline in ms, SE_WAIT_FOREVER if none is set.
+		// Returns true in case transmit was successful, false otherwise
+		virtual bool transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t timeout) = 0;
+
+		// Retrieve the SE ATR in case it is known by the low layer.
+		// Returns true in case ATR is available, false otherwise.
+		virtual bool getATR(uint8_t* /* atr */, uint16_t* /* atrLen */) {
+			return false;
+		}
+
+		// Returns the maximum command or response data length the low layer is able to carry.
+		virtual uint16_t getMaxTransportLength(void) {
+			return SE_MAX_DATA_LENGTH;
+		}
+
+		// Returns a monotonic timestamp in microseconds, used for APDU latency metrics.
+		virtual uint32_t getTimestamp(void);
+
+		// Start the low layer transaction once the SE is locked by this interface, e.g. to get
+		// exclusive access to a reader shared with other processes.
+		// Returns true in case transaction was started, false otherwise.
+		virtual bool beginTransaction(void) {
+			return true;
+		}
+
+		// End the low layer transaction before the SE is unlocked. Pending parameter tells
+		// whether other threads are waiting for the SE.
+		virtual void endTransaction(bool /* pending */) {
+		}
+	
+	private:
+		uint16_t _depth;
+		#ifdef SE_THREAD_SUPPORT
+		pthread_mutex_t _mutex;
+		pthread_cond_t _cond;
+		pthread_t _owner;
+		uint32_t _waiting[SE_PRIORITY_LEVELS];
+		uint32_t _tickets[SE_PRIORITY_LEVELS];
+		uint32_t _serving[SE_PRIORITY_LEVELS];
+		#endif
+
+		bool _isExtended;
+		uint16_t _maxCommandLength;
+		uint16_t _maxResponseLength;
+
+		#if SE_CHANNEL_POOL_SIZE > 0
+		se_channel_t _channels[SE_CHANNEL_POOL_SIZE];
+		uint32_t _channelClock;
+		#endif
+
+		se_apdu_hook_t _hook;
+		void* _hookCtx;
+		se_stats_t* _stats;
+		bool _statsEnabled;
+
+		#ifdef SE_THREAD_SUPPORT
+		pthread_key_t _deadlineKey; // se_deadline_t of each thread, allocated once it sets a bound
+		struct se_thread_deadline_s* _deadlines; // Deadlines allocated so far, freed with the interface
+		#else
+		se_deadline_t _deadline;
+		#endif
+
+		// Returns the deadline of the calling thread, NULL in case it never set a bound and create
+		// is false, or in case it can not be allocated.
+		se_deadline_t* threadDeadline(bool create);
+
+		#ifdef SE_THREAD_SUPPORT
+		// Release the deadline of a thread once it exits.
+		static void freeDeadline(void* deadline);
+		#endif
+
+		// Remove channel from the pool without closing it.
+		void forgetChannel(uint8_t channel);
+
+		// Account a low layer exchange of the command with the given INS.
+		// Kind parameter tells whether it is the command itself, a GET RESPONSE or a 6Cxx resend.
+		void record(uint8_t ins, uint8_t kind, uint8_t* response, uint16_t responseLen, uint32_t latency, bool success);
+		
+		// 'In between' layer implementation which auto handle 6Cxx and 61xx response
+		// Stack:
+		//  - transmitApdu 
+		//  - transmit	
+		//  - transmit (case 1 ... 4)
+		// Returns true in case transmit was successful, false otherwise
+		bool transmit(void);
+
+		// Transmit the APDU and assemble its response into response buffer: each 61xx
+		// continuation is received right after the previous chunk, status word last.
+		// ResponseSize parameter is the response buffer size, responseLen the received data length.
+		// Returns true in case transmit was successful, false otherwise
+		bool transmit(uint8_t* response, uint16_t responseSize, uint16_t* responseLen);
+
+};
+
+#else 
+
+typedef struct SEInterface SEInterface; 
+
+bool SEInterface_lock(SEInterface* seiface);
+bool SEInterface_lock_priority(SEInterface* seiface, uint8_t priority);
+bool SEInterface_unlock(SEInterface* seiface);
+		
+void SEInterface_close_channels(SEInterface* seiface);
+void SEInterface_reset_channels(SEInterface* seiface);
+
+bool SEInterface_transmit_case1(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2);
+bool SEInterface_transmit_case2(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le);
+bool SEInterface_transmit_case3(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len);
+bool SEInterface_transmit_case4(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint8_t le);
+bool SEInterface_transmit_extended(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint16_t ne);
+bool SEInterface_transmit_extended_to(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint16_t ne, uint8_t* response, uint16_t* response_len);
+
+bool SEInterface_detect_extended_length(SEInterface* seiface);
+bool SEInterface_is_extended_length(SEInterface* seiface);
+uint16_t SEInterface_get_max_command_length(SEInterface* seiface);
+uint16_t SEInterface_get_max_response_length(SEInterface* seiface);
+
+uint16_t SEInterface_get_status_word(SEInterface* seiface);
+uint16_t SEInterface_get_response(SEInterface* seiface, uint8_t* data);
+uint16_t SEInterface_get_response_length(SEInterface* seiface);
+
+void SEInterface_set_apdu_hook(SEInterface* seiface, se_apdu_hook_t hook, void* ctx);
+bool SEInterface_enable_stats(SEInterface* seiface, bool enable);
+const se_stats_t* SEInterface_get_stats(SEInterface* seiface);
+const se_ins_stats_t* SEInterface_get_ins_stats(SEInterface* seiface, uint8_t ins);
+void SEInterface_reset_stats(SEInterface* seiface);
+
+void SEInterface_set_deadline(SEInterface* seiface, uint32_t timeout);
+void SEInterface_save_deadline(SEInterface* seiface, se_deadline_t* deadline);
+void SEInterface_restore_deadline(SEInterface* seiface, const se_deadline_t* deadline);
+uint32_t SEInterface_get_time_left(SEInterface* seiface);
+bool SEInterface_is_timed_out(SEInterface* seiface);
+
+#endif
+
+#endif /* __SE_INTERFACE_H__ */
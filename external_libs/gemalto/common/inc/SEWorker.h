@@ -0,0 +1,114 @@
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __SE_WORKER_H__
+#define __SE_WORKER_H__
+
+#include "SEInterface.h"
+
+#define SE_JOB_PENDING                 0
+#define SE_JOB_RUNNING                 1
+#define SE_JOB_DONE                    2
+
+// Job operation, run with the secure element locked. Returns the job result.
+typedef bool (*se_job_run_t)(void* ctx);
+
+// Job completion callback, called from the worker thread once the operation returned.
+typedef void (*se_job_done_t)(void* ctx, bool result);
+
+// Secure element transaction run by the worker. Job is owned by the caller and must stay
+// valid until it is done, run, done (may be NULL), ctx and priority are set by the caller.
+// The worker does not touch the job once its completion callback is called, the callback
+// may free or resubmit it.
+typedef struct se_job_s {
+	se_job_run_t     run;
+	se_job_done_t    done;
+	void*            ctx;
+	uint8_t          priority;   // SE_PRIORITY_LOW ... SE_PRIORITY_HIGH
+	volatile uint8_t state;
+	bool             result;
+	se_deadline_t    deadline;   // Deadline of the submitting thread, which bounds the job
+	struct se_job_s* next;
+} se_job_t;
+
+#ifdef __cplusplus
+
+class SEWorker {
+	public:
+		SEWorker(void);
+		~SEWorker(void);
+
+		// Start the worker thread running jobs on the secure element.
+		// Returns true in case the worker is running, false otherwise.
+		bool start(SEInterface* se);
+
+		// Stop the worker thread once all queued jobs are done.
+		void stop(void);
+
+		// Queue a job. Jobs of higher priority run first, jobs of the same priority in submission order.
+		// The job is bounded by the deadline the calling thread set on the secure element interface.
+		// Without thread support, the job is run right away and is done on return.
+		// Returns true in case the job was queued, false otherwise (worker not running).
+		bool submit(se_job_t* job);
+
+		// Returns true in case the job is done, false otherwise.
+		bool isDone(se_job_t* job);
+
+		// Wait for the job to be done, its completion callback included.
+		// Returns the job result.
+		bool wait(se_job_t* job);
+
+	private:
+		// Run a job with the secure element locked.
+		void execute(se_job_t* job);
+
+		SEInterface* _se;
+		se_job_t* _queue;
+		bool _running;
+
+		#ifdef SE_THREAD_SUPPORT
+		static void* serve(void* arg);
+
+		se_job_t* _calling; // Job whose completion callback is running
+		pthread_t _thread;
+		pthread_mutex_t _mutex;
+		pthread_cond_t _cond;
+		#endif
+};
+
+#else
+
+typedef struct SEWorker SEWorker;
+
+SEWorker* SEWorker_create(void);
+void SEWorker_destroy(SEWorker* worker);
+
+bool SEWorker_start(SEWorker* worker, SEInterface* se);
+void SEWorker_stop(SEWorker* worker);
+bool SEWorker_submit(SEWorker* worker, se_job_t* job);
+bool SEWorker_is_done(SEWorker* worker, se_job_t* job);
+bool SEWorker_wait(SEWorker* worker, se_job_t* job);
+
+#endif
+
+#endif /* __SE_WORKER_H__ */
@@ -1,213 +1,465 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *  
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#include "Applet.h"
-
-Applet::Applet(uint8_t* aid, uint16_t aidLen) {
-	_seiface = NULL;
-	_aid = aid;
-	_aidLen = aidLen;
-	_seiface = NULL;
-	_isBasic = false;
-	_isSelected = false;
-	_channel = 0;
-}
-  
-Applet::~Applet(void) {
-	if(isSelected()) {
-		deselect();
-	}
-}  
-  
-void Applet::init(SEInterface* seiface) {
-	_seiface = seiface;
-}
-
-bool Applet::isSelected(void) {
-	return _isSelected;
-}
-
-bool Applet::select(bool isBasic) {	
-	if(_seiface != NULL) {
-		deselect();
-		
-		if(isBasic) {
-			_channel = 0;
-			
-			if(_seiface->transmit(0x00, 0xA4, 0x04, 0x00, _aid, _aidLen)) {
-				if((_seiface->getStatusWord() == 0x9000) || ((_seiface->getStatusWord() & 0xFF00) == 0x6100)) {
-					_isSelected = true;
-					_isBasic = true;
-					return true;
-				}
-			}
-		}
-		else {
-			if(_seiface->transmit(0x00, 0x70, 0x00, 0x00, 0x01)) {
-				if(_seiface->getStatusWord() == 0x9000) {
-					_seiface->getResponse(&_channel);
-					
-					if(_seiface->transmit(0x00 | _channel, 0xA4, 0x04, 0x00, _aid, _aidLen)) {
-						if((_seiface->getStatusWord() == 0x9000) || ((_seiface->getStatusWord() & 0xFF00) == 0x6100)) {
-							_isSelected = true;
-							_isBasic = false;
-							return true;
-						}
-					}
-					
-					_seiface->transmit(0x00, 0x70, 0x80, _channel);
-				}
-			}
-		}	
-	}
-	
-	return false;
-}
-
-bool Applet::deselect(void) {
-	if(_seiface != NULL) {
-		if(_isSelected && !_isBasic) {
-			if(_seiface->transmit(0x00, 0x70, 0x80, _channel)) {
-				if(_seiface->getStatusWord() == 0x9000) {
-					_isSelected = false;
-				}
-			}
-		}
-		else if(_isSelected && _isBasic) {
-			_isSelected = false;
-		}
-	}
-	return _isSelected;
-}
-
-bool Applet::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2) {
-	if(_isSelected) {
-		return _seiface->transmit(cla | _channel, ins, p1, p2);
-	}
-	return false;
-}
-
-bool Applet::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le) {
-	if(_isSelected) {
-		return _seiface->transmit(cla | _channel, ins, p1, p2, le);
-	}
-	return false;
-}
-
-bool Applet::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen) {
-	if(_isSelected) {
-		return _seiface->transmit(cla | _channel, ins, p1, p2, data, dataLen);
-	}
-	return false;
-}
-
-bool Applet::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint8_t le) {
-	if(_isSelected) {
-		return _seiface->transmit(cla | _channel, ins, p1, p2, data, dataLen, le);
-	}
-	return false;
-}
-
-uint16_t Applet::getStatusWord(void) {
-	uint16_t sw = 0;
-	
-	if(_isSelected) {
-		sw = _seiface->getStatusWord();
-	}
-	
-	return sw;
-}
-
-uint16_t Applet::getResponse(uint8_t* data) {
-	uint16_t len = 0;
-	
-	if(_isSelected) {
-		len = _seiface->getResponse(data);
-	}
-
-	return len;
-}
-
-uint16_t Applet::getResponseLength(void) {
-	uint16_t len = 0;
-	
-	if(_isSelected) {
-		len = _seiface->getResponseLength();
-	}
-
-	return len;	
-}
-
-/** C Accessors	***************************************************************/
-
-extern "C" Applet* Applet_create(uint8_t* aid, uint16_t aid_len) {
-	return new Applet(aid, aid_len);
-}
-
-extern "C" void Applet_destroy(Applet* applet) {
-	delete applet;
-}
-
-extern "C" void Applet_init(Applet* applet, SEInterface* seiface) {
-	applet->init(seiface);
-}
-
-extern "C" bool Applet_is_selected(Applet* applet) {
-	return applet->isSelected();
-}
-
-extern "C" bool Applet_select(Applet* applet, bool is_basic) {
-	return applet->select(is_basic);
-}
-
-extern "C" bool Applet_deselect(Applet* applet) {
-	return applet->deselect();
-}
-		
-extern "C" bool Applet_transmit_case1(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2) {
-	return applet->transmit(cla, ins, p1, p2);
-}
-
-extern "C" bool Applet_transmit_case2(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le) {
-	return applet->transmit(cla, ins, p1, p2, le);
-}
-
-extern "C" bool Applet_transmit_case3(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len) {
-	return applet->transmit(cla, ins, p1, p2, data, data_len);
-}
-
-extern "C" bool Applet_transmit_case4(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint8_t le) {
-	return applet->transmit(cla, ins, p1, p2, data, data_len, le);
-}
-
-extern "C" uint16_t Applet_get_status_word(Applet* applet) {
-	return applet->getStatusWord();
-}
-
-extern "C" uint16_t Applet_get_response(Applet* applet, uint8_t* data) {
-	return applet->getResponse(data);
-}
-
-extern "C" uint16_t Applet_get_response_length(Applet* applet) {
-	return applet->getResponseLength();
-}
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#include "Applet.h"
+#include "Inflater.h"
+
+Applet::Applet(uint8_t* aid, uint16_t aidLen) {
+	_seiface = NULL;
+	_aid = aid;
+	_aidLen = aidLen;
+	_seiface = NULL;
+	_isBasic = false;
+	_isSelected = false;
+	_isPooled = false;
+	_selections = 0;
+	_channel = 0;
+}
+  
+Applet::~Applet(void) {
+	close();
+}  
+  
+void Applet::init(SEInterface* seiface) {
+	_seiface = seiface;
+}
+
+bool Applet::isSelected(void) {
+	return _isSelected;
+}
+
+bool Applet::select(bool isBasic) {	
+	bool reused;
+
+	if(_seiface != NULL) {
+		deselect();
+		
+		if(isBasic) {
+			_channel = 0;
+			
+			if(_seiface->transmit(0x00, 0xA4, 0x04, 0x00, _aid, _aidLen)) {
+				if((_seiface->getStatusWord() == 0x9000) || ((_seiface->getStatusWord() & 0xFF00) == 0x6100)) {
+					_isSelected = true;
+					_selections++;
+					_isBasic = true;
+					return true;
+				}
+			}
+		}
+		else {
+			// Channel kept open by the pool, applet is still selected on it when it was already assigned to it
+			_isPooled = _seiface->acquireChannel(this, &_channel, &reused);
+			if(_isPooled) {
+				if(reused || (_seiface->transmit(0x00 | _channel, 0xA4, 0x04, 0x00, _aid, _aidLen) && ((_seiface->getStatusWord() == 0x9000) || ((_seiface->getStatusWord() & 0xFF00) == 0x6100)))) {
+					_isSelected = true;
+					_selections += reused ? 0 : 1;
+					_isBasic = false;
+					return true;
+				}
+
+				close();
+				return false;
+			}
+
+			// All pooled channels are busy
+			if(_seiface->transmit(0x00, 0x70, 0x00, 0x00, 0x01)) {
+				if(_seiface->getStatusWord() == 0x9000) {
+					_seiface->getResponse(&_channel);
+					
+					if(_seiface->transmit(0x00 | _channel, 0xA4, 0x04, 0x00, _aid, _aidLen)) {
+						if((_seiface->getStatusWord() == 0x9000) || ((_seiface->getStatusWord() & 0xFF00) == 0x6100)) {
+							_isSelected = true;
+							_selections++;
+							_isBasic = false;
+							return true;
+						}
+					}
+					
+					_seiface->transmit(0x00, 0x70, 0x80, _channel);
+				}
+			}
+		}	
+	}
+	
+	return false;
+}
+
+bool Applet::deselect(void) {
+	if(_seiface != NULL) {
+		if(_isSelected && !_isBasic && _isPooled) {
+			_seiface->releaseChannel(this);
+			_isSelected = false;
+		}
+		else if(_isSelected && !_isBasic) {
+			if(_seiface->transmit(0x00, 0x70, 0x80, _channel)) {
+				if(_seiface->getStatusWord() == 0x9000) {
+					_isSelected = false;
+				}
+			}
+		}
+		else if(_isSelected && _isBasic) {
+			_isSelected = false;
+		}
+	}
+	return _isSelected;
+}
+
+void Applet::close(void) {
+	deselect();
+
+	if(_isPooled) {
+		_seiface->closeChannel(this);
+		_isPooled = false;
+	}
+}
+
+bool Applet::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2) {
+	bool ret = false;
+
+	if(_isSelected) {
+		ret = _seiface->transmit(cla | _channel, ins, p1, p2);
+		if(ret && recoverChannel()) {
+			ret = _seiface->transmit(cla | _channel, ins, p1, p2);
+		}
+	}
+	return ret;
+}
+
+bool Applet::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le) {
+	bool ret = false;
+
+	if(_isSelected) {
+		ret = _seiface->transmit(cla | _channel, ins, p1, p2, le);
+		if(ret && recoverChannel()) {
+			ret = _seiface->transmit(cla | _channel, ins, p1, p2, le);
+		}
+	}
+	return ret;
+}
+
+bool Applet::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen) {
+	bool ret = false;
+
+	if(_isSelected) {
+		ret = _seiface->transmit(cla | _channel, ins, p1, p2, data, dataLen);
+		if(ret && recoverChannel()) {
+			ret = _seiface->transmit(cla | _channel, ins, p1, p2, data, dataLen);
+		}
+	}
+	return ret;
+}
+
+bool Applet::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint8_t le) {
+	bool ret = false;
+
+	if(_isSelected) {
+		ret = _seiface->transmit(cla | _channel, ins, p1, p2, data, dataLen, le);
+		if(ret && recoverChannel()) {
+			ret = _seiface->transmit(cla | _channel, ins, p1, p2, data, dataLen, le);
+		}
+	}
+	return ret;
+}
+
+bool Applet::transmitExtended(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint16_t ne) {
+	bool ret = false;
+
+	if(_isSelected) {
+		ret = _seiface->transmitExtended(cla | _channel, ins, p1, p2, data, dataLen, ne);
+		if(ret && recoverChannel()) {
+			ret = _seiface->transmitExtended(cla | _channel, ins, p1, p2, data, dataLen, ne);
+		}
+	}
+	return ret;
+}
+
+bool Applet::transmitExtended(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint16_t ne, uint8_t* response, uint16_t* responseLen) {
+	uint16_t responseSize = *responseLen;
+	bool ret = false;
+
+	if(_isSelected) {
+		ret = _seiface->transmitExtended(cla | _channel, ins, p1, p2, data, dataLen, ne, response, responseLen);
+		if(ret && recoverChannel()) {
+			*responseLen = responseSize;
+			ret = _seiface->transmitExtended(cla | _channel, ins, p1, p2, data, dataLen, ne, response, responseLen);
+		}
+		return ret;
+	}
+	*responseLen = 0;
+	return false;
+}
+
+bool Applet::recoverChannel(void) {
+	if(!_isPooled || (_seiface->getStatusWord() != 0x6881)) {
+		return false;
+	}
+
+	// Channel was already forgotten by the pool
+	_isSelected = false;
+	_isPooled = false;
+
+	return select(false);
+}
+
+uint16_t Applet::getMaxResponseLength(void) {
+	uint16_t len = SE_SHORT_MAX_DATA_LENGTH;
+
+	if(_seiface != NULL) {
+		len = _seiface->getMaxResponseLength();
+	}
+
+	return len;
+}
+
+uint16_t Applet::getReadBinaryLength(void) {
+	uint16_t len;
+
+	// Whole EF in a single READ BINARY when extended length is available
+	len = getMaxResponseLength();
+	if(len <= SE_SHORT_MAX_DATA_LENGTH) {
+		len = 255;
+	}
+
+	return len;
+}
+
+bool Applet::readBinary(uint16_t offset, uint8_t* data, uint16_t len) {
+	uint16_t i, toread, rlen;
+
+	for(i = 0; i < len; i += rlen) {
+		toread = getReadBinaryLength();
+		if(toread > (len - i)) {
+			toread = len - i;
+		}
+
+		// Chunk is received in place
+		rlen = toread + 2;
+		if(!transmitExtended(0x00, 0xB0, (offset + i) >> 8, offset + i, NULL, 0, toread, &data[i], &rlen) || (getStatusWord() != 0x9000) || (rlen == 0)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Applet::readInflatedBinary(uint16_t offset, uint16_t size, uint8_t* data, uint16_t len) {
+	Inflater* inflater;
+	bool ret;
+
+	inflater = new Inflater(this, offset, size, getReadBinaryLength());
+	ret = inflater->inflate(data, len);
+	delete inflater;
+
+	return ret;
+}
+
+uint16_t Applet::getStatusWord(void) {
+	uint16_t sw = 0;
+	
+	if(_isSelected) {
+		sw = _seiface->getStatusWord();
+	}
+	
+	return sw;
+}
+
+uint16_t Applet::getResponse(uint8_t* data) {
+	uint16_t len = 0;
+	
+	if(_isSelected) {
+		len = _seiface->getResponse(data);
+	}
+
+	return len;
+}
+
+uint16_t Applet::getResponseLength(void) {
+	uint16_t len = 0;
+	
+	if(_isSelected) {
+		len = _seiface->getResponseLength();
+	}
+
+	return len;	
+}
+
+bool Applet::readFingerprint(uint16_t offset, uint16_t size, uint32_t* fingerprint) {
+	uint8_t data[APPLET_FINGERPRINT_LENGTH + 2];
+	uint32_t pos, end, len, headerLen;
+	uint16_t i;
+
+	*fingerprint = 0x811C9DC5;
+
+	// Files are padded, their last bytes may not change with the object. The DER objects stored one after
+	// the other from offset are walked through their length headers, so that their own extent and last
+	// bytes are fingerprinted. A compressed object is fingerprinted from its header and first bytes,
+	// the end of the zlib stream is only known once inflated. Other encodings use the whole size.
+	end = (uint32_t) offset + size;
+	pos = offset;
+	while((pos + 2) <= end) {
+		headerLen = ((end - pos) < 4) ? (end - pos) : 4;
+		if(!readBinary(pos, data, headerLen)) {
+			return false;
+		}
+
+		if((data[0] == 0x01) && (data[1] == 0x00) && (headerLen == 4) && (pos == offset)) {
+			size = ((end - pos) < APPLET_FINGERPRINT_LENGTH) ? (end - pos) : APPLET_FINGERPRINT_LENGTH;
+			end = offset + size;
+			pos = end;
+			break;
+		}
+		else if(data[0] != 0x30) {
+			break;
+		}
+		else if(data[1] < 0x80) {
+			len = data[1];
+			headerLen = 2;
+		}
+		else if((data[1] == 0x81) && (headerLen >= 3)) {
+			len = data[2];
+			headerLen = 3;
+		}
+		else if((data[1] == 0x82) && (headerLen >= 4)) {
+			len = (data[2] << 8) | data[3];
+			headerLen = 4;
+		}
+		else {
+			break;
+		}
+
+		if((pos + headerLen + len) > end) {
+			break;
+		}
+		pos += headerLen + len;
+	}
+
+	if(pos > offset) {
+		size = pos - offset;
+	}
+
+	for(i=0; i<2; i++) {
+		*fingerprint ^= (uint8_t)(size >> (8 * i));
+		*fingerprint *= 0x01000193;
+	}
+
+	if(size > APPLET_FINGERPRINT_LENGTH) {
+		offset += size - APPLET_FINGERPRINT_LENGTH;
+		size = APPLET_FINGERPRINT_LENGTH;
+	}
+
+	// Nothing to read, Le=0 would request 256 bytes
+	if(size == 0) {
+		return true;
+	}
+
+	if(transmit(0x00, 0xB0, offset >> 8, offset, size)) {
+		if((getStatusWord() == 0x9000) && (getResponseLength() == size)) {
+			getResponse(data);
+			for(i=0; i<size; i++) {
+				*fingerprint ^= data[i];
+				*fingerprint *= 0x01000193;
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** C Accessors	***************************************************************/
+
+extern "C" Applet* Applet_create(uint8_t* aid, uint16_t aid_len) {
+	return new Applet(aid, aid_len);
+}
+
+extern "C" void Applet_destroy(Applet* applet) {
+	delete applet;
+}
+
+extern "C" void Applet_init(Applet* applet, SEInterface* seiface) {
+	applet->init(seiface);
+}
+
+extern "C" bool Applet_is_selected(Applet* applet) {
+	return applet->isSelected();
+}
+
+extern "C" bool Applet_select(Applet* applet, bool is_basic) {
+	return applet->select(is_basic);
+}
+
+extern "C" bool Applet_deselect(Applet* applet) {
+	return applet->deselect();
+}
+		
+extern "C" void Applet_close(Applet* applet) {
+	applet->close();
+}
+
+extern "C" bool Applet_transmit_case1(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2) {
+	return applet->transmit(cla, ins, p1, p2);
+}
+
+extern "C" bool Applet_transmit_case2(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le) {
+	return applet->transmit(cla, ins, p1, p2, le);
+}
+
+extern "C" bool Applet_transmit_case3(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len) {
+	return applet->transmit(cla, ins, p1, p2, data, data_len);
+}
+
+extern "C" bool Applet_transmit_case4(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint8_t le) {
+	return applet->transmit(cla, ins, p1, p2, data, data_len, le);
+}
+
+extern "C" bool Applet_transmit_extended(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint16_t ne) {
+	return applet->transmitExtended(cla, ins, p1, p2, data, data_len, ne);
+}
+
+extern "C" bool Applet_transmit_extended_to(Applet* applet, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint16_t ne, uint8_t* response, uint16_t* response_len) {
+	return applet->transmitExtended(cla, ins, p1, p2, data, data_len, ne, response, response_len);
+}
+
+extern "C" uint16_t Applet_get_max_response_length(Applet* applet) {
+	return applet->getMaxResponseLength();
+}
+
+extern "C" bool Applet_read_binary(Applet* applet, uint16_t offset, uint8_t* data, uint16_t len) {
+	return applet->readBinary(offset, data, len);
+}
+
+extern "C" bool Applet_read_inflated_binary(Applet* applet, uint16_t offset, uint16_t size, uint8_t* data, uint16_t len) {
+	return applet->readInflatedBinary(offset, size, data, len);
+}
+
+extern "C" uint16_t Applet_get_status_word(Applet* applet) {
+	return applet->getStatusWord();
+}
+
+extern "C" uint16_t Applet_get_response(Applet* applet, uint8_t* data) {
+	return applet->getResponse(data);
+}
+
+extern "C" uint16_t Applet_get_response_length(Applet* applet) {
+	return applet->getResponseLength();
+}
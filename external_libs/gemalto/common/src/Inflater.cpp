@@ -0,0 +1,375 @@
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#include "Inflater.h"
+#include <string.h>
+
+static const uint16_t LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+static const uint8_t CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+Inflater::Inflater(Applet* applet, uint16_t offset, uint16_t size, uint16_t chunkLen) {
+	_applet = applet;
+	_offset = offset;
+	_end = offset + size;
+	_chunkLen = (chunkLen > INFLATER_INPUT_BUFFER_SIZE) ? INFLATER_INPUT_BUFFER_SIZE : chunkLen;
+	_inputPos = 0;
+	_inputLen = 0;
+	_bits = 0;
+	_bitCount = 0;
+	_out = NULL;
+	_outPos = 0;
+	_outLen = 0;
+}
+
+Inflater::~Inflater(void) {
+}
+
+bool Inflater::getByte(uint8_t* value) {
+	uint16_t toread;
+
+	if(_inputPos == _inputLen) {
+		if((_offset >= _end) || (_chunkLen == 0)) {
+			return false;
+		}
+
+		toread = _end - _offset;
+		if(toread > _chunkLen) {
+			toread = _chunkLen;
+		}
+
+		if(!_applet->readBinary(_offset, _input, toread)) {
+			return false;
+		}
+		_offset += toread;
+		_inputPos = 0;
+		_inputLen = toread;
+	}
+
+	*value = _input[_inputPos++];
+	return true;
+}
+
+bool Inflater::getBits(uint8_t count, uint16_t* value) {
+	uint8_t b;
+
+	while(_bitCount < count) {
+		if(!getByte(&b)) {
+			return false;
+		}
+		_bits |= ((uint32_t) b) << _bitCount;
+		_bitCount += 8;
+	}
+
+	*value = _bits & ((1UL << count) - 1);
+	_bits >>= count;
+	_bitCount -= count;
+
+	return true;
+}
+
+bool Inflater::buildTree(inflater_tree_t* tree, uint8_t* lengths, uint16_t count) {
+	uint16_t offsets[16];
+	uint16_t i;
+	int32_t left;
+
+	memset(tree->counts, 0, sizeof(tree->counts));
+	for(i = 0; i < count; i++) {
+		tree->counts[lengths[i]]++;
+	}
+	tree->counts[0] = 0;
+
+	// Reject over-subscribed code sets
+	left = 1;
+	for(i = 1; i < 16; i++) {
+		left <<= 1;
+		left -= tree->counts[i];
+		if(left < 0) {
+			return false;
+		}
+	}
+
+	offsets[1] = 0;
+	for(i = 1; i < 15; i++) {
+		offsets[i + 1] = offsets[i] + tree->counts[i];
+	}
+
+	for(i = 0; i < count; i++) {
+		if(lengths[i]) {
+			tree->symbols[offsets[lengths[i]]++] = i;
+		}
+	}
+
+	return true;
+}
+
+bool Inflater::decodeSymbol(inflater_tree_t* tree, uint16_t* symbol) {
+	int32_t code, first, index, count;
+	uint16_t bit;
+	uint8_t len;
+
+	code = first = index = 0;
+	for(len = 1; len < 16; len++) {
+		if(!getBits(1, &bit)) {
+			return false;
+		}
+		code |= bit;
+		count = tree->counts[len];
+
+		if((code - count) < first) {
+			*symbol = tree->symbols[index + (code - first)];
+			return true;
+		}
+
+		index += count;
+		first = (first + count) << 1;
+		code <<= 1;
+	}
+
+	return false;
+}
+
+void Inflater::buildFixedTrees(void) {
+	uint8_t lengths[288];
+
+	memset(&lengths[0], 8, 144);
+	memset(&lengths[144], 9, 112);
+	memset(&lengths[256], 7, 24);
+	memset(&lengths[280], 8, 8);
+	buildTree(&_lt, lengths, 288);
+
+	memset(lengths, 5, 30);
+	buildTree(&_dt, lengths, 30);
+}
+
+bool Inflater::decodeTrees(void) {
+	uint8_t lengths[286 + 30];
+	uint16_t hlit, hdist, hclen;
+	uint16_t i, symbol, repeat;
+	uint8_t previous;
+
+	if(!getBits(5, &hlit) || !getBits(5, &hdist) || !getBits(4, &hclen)) {
+		return false;
+	}
+	hlit += 257;
+	hdist += 1;
+	hclen += 4;
+
+	if((hlit > 286) || (hdist > 30)) {
+		return false;
+	}
+
+	// Code length codes, temporarily held in the literal/length tree
+	memset(lengths, 0, 19);
+	for(i = 0; i < hclen; i++) {
+		if(!getBits(3, &symbol)) {
+			return false;
+		}
+		lengths[CODE_LENGTH_ORDER[i]] = symbol;
+	}
+
+	if(!buildTree(&_lt, lengths, 19)) {
+		return false;
+	}
+
+	for(i = 0; i < (hlit + hdist);) {
+		if(!decodeSymbol(&_lt, &symbol)) {
+			return false;
+		}
+
+		if(symbol < 16) {
+			lengths[i++] = symbol;
+			continue;
+		}
+
+		previous = 0;
+		if(symbol == 16) {
+			if((i == 0) || !getBits(2, &repeat)) {
+				return false;
+			}
+			previous = lengths[i - 1];
+			repeat += 3;
+		}
+		else if(symbol == 17) {
+			if(!getBits(3, &repeat)) {
+				return false;
+			}
+			repeat += 3;
+		}
+		else {
+			if(!getBits(7, &repeat)) {
+				return false;
+			}
+			repeat += 11;
+		}
+
+		if((i + repeat) > (hlit + hdist)) {
+			return false;
+		}
+		memset(&lengths[i], previous, repeat);
+		i += repeat;
+	}
+
+	// End of block code is mandatory
+	if(lengths[256] == 0) {
+		return false;
+	}
+
+	return buildTree(&_lt, lengths, hlit) && buildTree(&_dt, &lengths[hlit], hdist);
+}
+
+bool Inflater::inflateStored(void) {
+	uint8_t header[4];
+	uint16_t len, i;
+
+	// Stored blocks start on a byte boundary, less than 8 bits can be pending
+	_bits = 0;
+	_bitCount = 0;
+
+	for(i = 0; i < 4; i++) {
+		if(!getByte(&header[i])) {
+			return false;
+		}
+	}
+
+	len = header[0] | (header[1] << 8);
+	if((len != (uint16_t) ~(header[2] | (header[3] << 8))) || (len > (_outLen - _outPos))) {
+		return false;
+	}
+
+	for(i = 0; i < len; i++) {
+		if(!getByte(&_out[_outPos++])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool Inflater::inflateCompressed(void) {
+	uint16_t symbol, extra, len, dist;
+
+	for(;;) {
+		if(!decodeSymbol(&_lt, &symbol)) {
+			return false;
+		}
+
+		if(symbol < 256) {
+			if(_outPos >= _outLen) {
+				return false;
+			}
+			_out[_outPos++] = symbol;
+		}
+		else if(symbol == 256) {
+			return true;
+		}
+		else {
+			symbol -= 257;
+			if((symbol >= 29) || !getBits(LENGTH_EXTRA[symbol], &extra)) {
+				return false;
+			}
+			len = LENGTH_BASE[symbol] + extra;
+
+			if(!decodeSymbol(&_dt, &symbol) || (symbol >= 30) || !getBits(DIST_EXTRA[symbol], &extra)) {
+				return false;
+			}
+			dist = DIST_BASE[symbol] + extra;
+
+			// Output is the window, references cannot go before its start
+			if((dist > _outPos) || (len > (_outLen - _outPos))) {
+				return false;
+			}
+
+			for(; len; len--, _outPos++) {
+				_out[_outPos] = _out[_outPos - dist];
+			}
+		}
+	}
+}
+
+bool Inflater::inflate(uint8_t* data, uint16_t len) {
+	uint8_t cmf, flg, b;
+	uint16_t final, type, i;
+	uint32_t a, s, adler;
+
+	_out = data;
+	_outPos = 0;
+	_outLen = len;
+
+	// zlib header, deflate method without preset dictionary
+	if(!getByte(&cmf) || !getByte(&flg)) {
+		return false;
+	}
+	if(((cmf & 0x0F) != 8) || (flg & 0x20) || ((((uint16_t) cmf << 8) | flg) % 31)) {
+		return false;
+	}
+
+	do {
+		if(!getBits(1, &final) || !getBits(2, &type)) {
+			return false;
+		}
+
+		if(type == 0) {
+			if(!inflateStored()) {
+				return false;
+			}
+		}
+		else if(type == 1) {
+			buildFixedTrees();
+			if(!inflateCompressed()) {
+				return false;
+			}
+		}
+		else if(type == 2) {
+			if(!decodeTrees() || !inflateCompressed()) {
+				return false;
+			}
+		}
+		else {
+			return false;
+		}
+	} while(!final);
+
+	if(_outPos != _outLen) {
+		return false;
+	}
+
+	// Adler-32 of the uncompressed data follows, big endian, on a byte boundary
+	_bits = 0;
+	_bitCount = 0;
+	for(i = 0, adler = 0; i < 4; i++) {
+		if(!getByte(&b)) {
+			return false;
+		}
+		adler = (adler << 8) | b;
+	}
+
+	for(i = 0, a = 1, s = 0; i < _outLen; i++) {
+		a = (a + _out[i]) % 65521;
+		s = (s + a) % 65521;
+	}
+
+	return adler == ((s << 16) | a);
+}
@@ -1,862 +1,1418 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *  
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#include "MIAS.h"
-#include <string.h>
-#include <stdlib.h>
-#include <stdio.h>
-
-//#define USE_GAT_RESPONSE
-
-static uint8_t AID[] = { 0xA0, 0x00, 0x00, 0x00, 0x18, 0x80, 0x00, 0x00, 0x00, 0x06, 0x62, 0x41, 0x51 };
-
-MIAS::MIAS(void) : Applet(AID, sizeof(AID)) {
-	_keypairs = NULL;
-	
-	_hashAlgo = 0;
-
-	_signAlgo = 0;
-	_signKey = 0;
-
-	_decryptKey = 0;
-	_decryptAlgo = 0;
-}
-  
-MIAS::~MIAS(void) {
-	void* ptr;
-	
-	while(_keypairs != NULL) {
-		ptr = _keypairs->next;
-		free(_keypairs);
-		_keypairs = (mias_key_pair_t*) ptr;
-	}
-}
-
-/** PRIVATE *******************************************************************/
-
-bool MIAS::mseSetBeforeHash(uint8_t algorithm) {
-	uint8_t data[3];
-		
-	data[0] = 0x80;
-	data[1] = 0x01;
-	data[2] = algorithm;
-	
-	if(transmit(0x00, 0x22, 0x41, 0xAA, data, sizeof(data))) {
-		if(getStatusWord() == 0x9000) {
-			return true;
-		}
-	}
-	
-	return false;
-}
-
-bool MIAS::psoHashInternally(uint8_t algorithm, uint8_t* data, uint16_t dataLen) {
-	uint8_t block_size;
-	uint16_t i, l;
-	
-	if((algorithm == ALGO_SHA1) || (algorithm == ALGO_SHA224) || (algorithm == ALGO_SHA256)) {
-		block_size = 64;
-	}
-	else if((algorithm == ALGO_SHA384) || (algorithm == ALGO_SHA512)) {
-		block_size = 128;
-	}
-	else {
-		return false;
-	}
-	
-	for(i=0; i<dataLen; i += l) {
-		if((l = dataLen - i) > block_size) {
-			l = block_size;
-		}
-
-		if(!transmit(0x00, 0x2A, 0x90, 0x80, &data[i], l)) {
-			return false;
-		}
-			
-		if(getStatusWord() != 0x9000) {
-			return false;
-		}
-	}
-	
-	return true;
-}
-
-bool MIAS::psoHashInternallyFinal(uint8_t* hash, uint16_t* hashLen) {
-	uint8_t data[2];
-	
-	data[0] = 0x80;
-	data[1] = 0x00;
-	
-	*hashLen = 0;
-	
-	if(transmit(0x00, 0x2A, 0x90, 0xA0, data, sizeof(data), 0x00)) {
-		if(getStatusWord() == 0x9000) {
-			*hashLen = getResponse(hash);
-			return true;
-		}
-	}
-	
-	return false;
-}
-
-bool MIAS::psoHashExternally(uint8_t algorithm, uint8_t* hash, uint16_t hashLen) {
-	uint8_t data[66];
-	
-	data[0] = 0x90;
-	switch(algorithm) {
-		case ALGO_SHA1:
-			data[1] = 20;
-			break;
-		
-		case ALGO_SHA224:
-			data[1] = 28;
-		
-			break;
-		case ALGO_SHA256:
-			data[1] = 32;
-		
-			break;
-		case ALGO_SHA384:
-			data[1] = 48;
-		
-			break;
-		case ALGO_SHA512:
-			data[1] = 64;
-			break;
-		
-		default:
-			return false;
-	}
-	memcpy(&data[2], hash, data[1]);
-	
-	if(transmit(0x00, 0x2A, 0x90, 0xA0, data, 2 + data[1], 0x00)) {
-		if(getStatusWord() == 0x9000) {
-			return true;
-		}
-	}
-	
-	return false;
-}
-
-bool MIAS::mseSetBeforeSignature(uint8_t algorithm, uint8_t key) {
-	uint8_t data[6];
-	
-	data[0] = 0x80;
-	data[1] = 0x01;
-	data[2] = algorithm;
-	data[3] = 0x84;
-	data[4] = 0x01;
-	data[5] = key;
-	
-	if(transmit(0x00, 0x22, 0x41, 0xB6, data, sizeof(data))) {
-		if(getStatusWord() == 0x9000) {
-			return true;
-		}
-	}
-	
-	return false;
-}
-
-bool MIAS::psoComputeDigitalSignature(uint8_t* signature, uint16_t* signatureLen) {
-	uint16_t len;
-	
-	*signatureLen = 0;
-	
-	if(transmit(0x00, 0x2A, 0x9E, 0x9A, 0x00)) {
-		#ifdef USE_GAT_RESPONSE
-		if(_isBasic) {
-		#endif
-			while(getResponseLength()) {
-				len = getResponse(signature);
-				signature += len;
-				*signatureLen += len;
-				if((getStatusWord() & 0xFF00) == 0x6100) {
-					// Transmit GET Response
-					if(transmit(0x00, 0xC0, 0x00, 0x00, getStatusWord() & 0x00FF)) {
-						continue;
-					}
-				}
-				else if(getStatusWord() == 0x9000) {
-					return true;
-				}
-				return false;
-			}
-		#ifdef USE_GAT_RESPONSE
-		}
-		else {
-			// GAT format: [DATA1 DATA2 ... ][GAT SW1 SW2][90 00]
-			while((getStatusWord() == 0x9000) && (_seiface->_apduResponseLen >= 4)) {
-				// Convert ApduResponse in order to have GAT status word as regular status word
-				_seiface->_apduResponseLen -= 2;
-				
-				len = getResponse(signature);
-				signature += len;
-				*signatureLen += len;
-				if((getStatusWord() & 0xFF00) == 0x6100) {
-					// Transmit GAT Response
-					if(transmit(0x00, 0xC2, 0x00, 0x00, getStatusWord() & 0x00FF)) {
-						continue;
-					}
-				}
-				else if(getStatusWord() == 0x9000) {
-					return true;
-				}
-				return false;
-			}
-		}
-		#endif
-	}
-	
-	return false;
-}
-
-bool MIAS::mseSetBeforeDecrypt(uint8_t algorithm, uint8_t key) {
-	uint8_t data[6];
-	
-	data[0] = 0x80;
-	data[1] = 0x01;
-	data[2] = algorithm;
-	data[3] = 0x84;
-	data[4] = 0x01;
-	data[5] = key;
-	
-	if(transmit(0x00, 0x22, 0x41, 0xB8, data, sizeof(data))) {
-		if(getStatusWord() == 0x9000) {
-			return true;
-		}
-	}
-	
-	return false;
-}
-
-bool MIAS::psoDecipher(uint8_t* data, uint16_t dataLen, uint8_t* plain, uint16_t* plainLen) {	
-	uint8_t buf[255];
-	
-	if(dataLen < 255) {
-		buf[0] = 0x81;
-		memcpy(&buf[1], data, dataLen);
-		
-		if(!transmit(0x00, 0x2A, 0x80, 0x86, buf, dataLen + 1)) {
-			return false;
-		}
-	}
-	else {
-		buf[0] = 0x81;
-		memcpy(&buf[1], data, 0xFE);
-		data += 0xFE;
-		dataLen -= 0xFE;
-		
-		if(!transmit(0x10, 0x2A, 0x80, 0x86, buf, 0xFF)) {
-			return false;
-		}
-		
-		if(getStatusWord() != 0x9000) {
-			return false;
-		}
-		
-		if(!transmit(0x00, 0x2A, 0x80, 0x86, data, dataLen)) {
-			return false;
-		}
-	}
-	
-	if(getStatusWord() == 0x9000) {
-		*plainLen = getResponse(plain);
-		return true;
-	}
-	
-	return false;
-}
-
-#define TAG_FILE_SIZE   0x81
-#define TAG_FDB         0x82
-#define TAG_FILE_ID     0x83
-#define TAG_LCS         0x8A
-#define TAG_CT_SEC_ATTR 0x8C
-
-bool MIAS::listKeyPairs(void) {
-	uint8_t CONTAINERS_INFO_EF[] = { 0x00, 0x02 };
-	uint8_t FILE_DIR_EF[] = { 0x01, 0x01 };
-	uint16_t size = 0;
-	mias_key_pair_t* ptr;
-	
-	if(_keypairs != NULL) {
-		return true;
-	}
-	
-	if(transmit(0x00, 0xA4, 0x08, 0x04, CONTAINERS_INFO_EF, sizeof(CONTAINERS_INFO_EF), 0x15)) {
-		if(getStatusWord() == 0x9000) {
-			if(getResponseLength() > 2) {
-				if(_seiface->_apduResponse[0] == 0x62) {
-					uint8_t i, len;
-					uint8_t t, l;
-					uint16_t offset;
-					
-					len = _seiface->_apduResponse[1];
-					
-					for(i = 2, len += 2; i < len;) {
-						t = _seiface->_apduResponse[i];
-						l = _seiface->_apduResponse[i + 1];
-
-						switch(t) {
-							case TAG_FILE_SIZE:
-								size = (_seiface->_apduResponse[i + 2] << 8) | _seiface->_apduResponse[i + 3];
-								break;
-						}
-						
-						i += 2 + l;
-					}
-					
-					for(i = 0, offset = 0; offset < size; i++, offset += 0x0B) {
-						if(transmit(0x00, 0xB0, (offset >> 8) & 0xFF, offset & 0xFF, 0x0B)) {
-							if(getStatusWord() == 0x9000) {
-								if(_seiface->_apduResponse[0]) {	
-									ptr = (mias_key_pair_t*) malloc(sizeof(mias_key_pair_t));
-									ptr->pub_file_id[0] = 0;
-									ptr->pub_file_id[1] = 0;
-									
-									ptr->flags = SIGNATURE_KEY_PAIR_FLAG;									
-									if((ptr->size_in_bits = (_seiface->_apduResponse[4] << 8) | _seiface->_apduResponse[5]) == 0) {
-										ptr->flags |= DECRYPTION_KEY_PAIR_FLAG;
-										ptr->size_in_bits = (_seiface->_apduResponse[6] << 8) | _seiface->_apduResponse[7];
-									}
-									
-									// RSA 1024-bits exchange keys
-									if((ptr->size_in_bits == 0x400) && ((ptr->flags & (SIGNATURE_KEY_PAIR_FLAG | DECRYPTION_KEY_PAIR_FLAG)) ==  (SIGNATURE_KEY_PAIR_FLAG | DECRYPTION_KEY_PAIR_FLAG))) {
-										ptr->kid = 0x10 | (i + 1);
-										ptr->flags |= RSA_KEY_PAIR_FLAG;
-									}
-									
-									// RSA 1024-bits signature keys
-									else if((ptr->size_in_bits == 0x400) && ((ptr->flags & (SIGNATURE_KEY_PAIR_FLAG | DECRYPTION_KEY_PAIR_FLAG)) ==  SIGNATURE_KEY_PAIR_FLAG)) {
-										ptr->kid = 0x20 | (i + 1);
-										ptr->flags |= RSA_KEY_PAIR_FLAG;
-									}
-									
-									// RSA 2048-bits exchange keys
-									else if((ptr->size_in_bits == 0x800) && ((ptr->flags & (SIGNATURE_KEY_PAIR_FLAG | DECRYPTION_KEY_PAIR_FLAG)) ==  (SIGNATURE_KEY_PAIR_FLAG | DECRYPTION_KEY_PAIR_FLAG))) {
-										ptr->kid = 0x30 | (i + 1);
-										ptr->flags |= RSA_KEY_PAIR_FLAG;
-									}
-									
-									// RSA 2048-bits signature keys
-									else if((ptr->size_in_bits == 0x800) && ((ptr->flags & (SIGNATURE_KEY_PAIR_FLAG | DECRYPTION_KEY_PAIR_FLAG)) ==  SIGNATURE_KEY_PAIR_FLAG)) {
-										ptr->kid = 0x40 | (i + 1);
-										ptr->flags |= RSA_KEY_PAIR_FLAG;
-									}
-									
-									ptr->has_cert = false;
-									
-									ptr->next = _keypairs;
-									_keypairs = ptr;
-								}
-							}
-							else {
-								break;
-							}
-						}
-					}
-									
-					if(transmit(0x00, 0xA4, 0x08, 0x04, FILE_DIR_EF, sizeof(FILE_DIR_EF), 0x15)) {
-						if(getStatusWord() == 0x9000) {
-							if(transmit(0x00, 0xB0, 0x00, 0x00, 0x01)) {
-								if(getStatusWord() == 0x9000) {
-									size = _seiface->_apduResponse[0];
-									
-									for(i = 0, offset = 1; i < size; i++, offset += 0x15) {
-										if(transmit(0x00, 0xB0, (offset >> 8) & 0xFF, offset & 0xFF, 0x15)) {
-											if(getStatusWord() == 0x9000) {
-												if((_seiface->_apduResponse[12] == 'm') && (_seiface->_apduResponse[13] == 's') && (_seiface->_apduResponse[14] == 'c') && (_seiface->_apduResponse[15] == 'p')) {
-													/*
-													{
-														uint16_t j;
-														
-														printf("\r\nFile: ");
-														for(j=4; (j<12) && _seiface->_apduResponse[j]; j++) {
-															printf("%c", _seiface->_apduResponse[j]);
-														}
-														printf(" (%02d%02d) size = %dbytes\r\n\r\n", _seiface->_apduResponse[0], _seiface->_apduResponse[1], (_seiface->_apduResponse[2] << 8) | _seiface->_apduResponse[3]);
-													}
-													*/
-													
-													// priprk is for key pair only (no certificate)
-													/*
-													if((_seiface->_apduResponse[4] == 'p') && (_seiface->_apduResponse[5] == 'r') && (_seiface->_apduResponse[6] == 'i') && 
-														(_seiface->_apduResponse[7] == 'p') && (_seiface->_apduResponse[8] == 'r') && (_seiface->_apduResponse[9] == 'k')) {
-
-														ptr = _keypairs;
-													
-														while(ptr != NULL) {
-															if(((ptr->kid & 0x0F) - 1) == (((_seiface->_apduResponse[10] - '0') * 10) + (_seiface->_apduResponse[11] - '0'))) {
-																ptr->pub_file_id[0] = _seiface->_apduResponse[0];
-																ptr->pub_file_id[1] = _seiface->_apduResponse[1];
-																ptr->has_cert = false;
-																break;
-															}
-															ptr = ptr->next;
-														}
-													}
-													*/
-
-													// kxc file is for exchange keys
-													/*else*/ if((_seiface->_apduResponse[4] == 'k') && (_seiface->_apduResponse[5] == 'x') && (_seiface->_apduResponse[6] == 'c')) {
-														ptr = _keypairs;
-													
-														while(ptr != NULL) {
-															if(((ptr->kid & 0x0F) - 1) == (((_seiface->_apduResponse[7] - '0') * 10) + (_seiface->_apduResponse[8] - '0'))) {
-																ptr->pub_file_id[0] = _seiface->_apduResponse[0];
-																ptr->pub_file_id[1] = _seiface->_apduResponse[1];
-																ptr->has_cert = true;
-																break;
-															}
-															ptr = ptr->next;
-														}
-													}
-													// ksc file is for signature keys
-													else if((_seiface->_apduResponse[4] == 'k') && (_seiface->_apduResponse[5] == 's') && (_seiface->_apduResponse[6] == 'c')) {
-														ptr = _keypairs;
-													
-														while(ptr != NULL) {
-															if(((ptr->kid & 0x0F) - 1) == (((_seiface->_apduResponse[7] - '0') * 10) + (_seiface->_apduResponse[8] - '0'))) {
-																ptr->pub_file_id[0] = _seiface->_apduResponse[0];
-																ptr->pub_file_id[1] = _seiface->_apduResponse[1];
-																ptr->has_cert = true;
-																break;
-															}
-															ptr = ptr->next;
-														}
-													}
-												}
-											}
-										}
-									}
-								}
-							}
-						}
-					}
-					
-					// DEBUG
-					/*
-					{
-						ptr = _keypairs;
-											
-						printf("\r\n---\r\n");
-						while(ptr != NULL) {
-							printf("KID: %02X %d\r\n", ptr->kid,  ptr->has_cert);
-							ptr = ptr->next;
-						}
-						printf("---\r\n\r\n");
-					}
-					*/
-					// -----
-					return true;
-				}
-			}
-		}
-	}
-	
-	return false;
-}
-
-bool MIAS::getKeyPairByContainerId(uint8_t containter_id, mias_key_pair_t** kp) {												
-	listKeyPairs();
-	
-	*kp = _keypairs;
-	
-	while(*kp != NULL) {
-		if((((*kp)->kid & 0x0F) - 1) == containter_id) {
-			return true;
-		}
-		*kp = (*kp)->next;
-	}
-	
-	return false;
-}
-
-bool MIAS::getCertificateByContainerId(uint8_t container_id, uint8_t** cert, uint16_t* certLen) {
-	uint8_t i, len;
-	uint8_t t, l;
-	uint16_t offset;
-	uint16_t ef_size;
-	mias_key_pair_t* kp;
-	
-	if(getKeyPairByContainerId(container_id, &kp)) {
-		if(kp->has_cert) {
-			if(transmit(0x00, 0xA4, 0x08, 0x04, kp->pub_file_id, sizeof(kp->pub_file_id), 0x1C)) {
-				if(getStatusWord() == 0x9000) {
-					if(_seiface->_apduResponse[0] == 0x62) {
-						len = _seiface->_apduResponse[1];
-						
-						for(i = 2, len += 2; i < len;) {
-							t = _seiface->_apduResponse[i];
-							l = _seiface->_apduResponse[i + 1];
-
-							switch(t) {
-								case TAG_FILE_SIZE:
-									ef_size = (_seiface->_apduResponse[i + 2] << 8) | _seiface->_apduResponse[i + 3];
-									break;
-							}
-							
-							i += 2 + l;
-						}
-					}
-					
-					if(ef_size) {
-						*certLen = ef_size + 1;
-						*cert = (uint8_t*) malloc((*certLen) * sizeof(uint8_t));
-						
-						for(offset = 0; offset < ef_size;) {
-							len = 0xEE;
-							if((offset + len) > ef_size) {
-								len = ef_size - offset;
-							}
-							
-							if(transmit(0x00, 0xB0, (offset >> 8) & 0xFF, offset & 0xFF, len)) {
-								if(getStatusWord() == 0x9000) {
-									len = getResponse(&((*cert)[offset]));
-								}
-							}
-							
-							offset += len;
-						}
-						(*cert)[offset] = '\0';
-						
-						if(((*cert)[0] == 0x01) && ((*cert)[1] == 0x00)) {
-							// Compressed
-							// ToDo: uncompressed using zlib
-							//printf("ERROR: Compressed certificate!");
-							free(*cert);
-							return false;
-						}
-
-						return true;
-					}
-				}
-			}
-		}
-	}
-	
-	return false;
-}
-
-/** PUBLIC ********************************************************************/
-
-bool MIAS::verifyPin(uint8_t* pin, uint16_t pinLen) {	
-	if(transmit(0x00, 0x20, 0x00, 0x81, pin, pinLen)) {
-		if(getStatusWord() == 0x9000) {
-			return true;
-		}
-	}
-	return false;
-}
-
-bool MIAS::changePin(uint8_t* oldPin, uint16_t oldPinLen, uint8_t* newPin, uint16_t newPinLen) {
-	uint8_t data[1 + (8 * 2)];
-	uint16_t dataLen;
-	
-	dataLen = 1 + oldPinLen + newPinLen;
-	
-	if(dataLen > sizeof(data)) {
-		return false;
-	}
-	
-	data[0] = (uint8_t) oldPinLen;
-	memcpy(&data[1], oldPin, oldPinLen);
-	memcpy(&data[oldPinLen], newPin, newPinLen);
-	
-	if(transmit(0x80, 0x24, 0x00, 0x81, data, dataLen)) {
-		if(getStatusWord() == 0x9000) {
-			return true;
-		}
-	}
-	return false;
-}
-
-bool MIAS::p11GetObjectByLabel(uint8_t* label, uint16_t labelLen, uint8_t** object, uint16_t* objectLen) {
-	uint8_t  data[2];
-	uint8_t  record[0x15];
-	uint16_t i, offset, len, size;
-	mias_file_t* file = NULL;
-	mias_file_t* nfile = NULL;
-
-	*objectLen = 0;
-
-	// FILE_DIR_EF
-	data[0] = 0x01;
-	data[1] = 0x01;
-
-	if(transmit(0x00, 0xA4, 0x08, 0x04, data, sizeof(data))) {
-		if(getStatusWord() == 0x9000) {
-			uint8_t nbOfFiles;
-
-			if(transmit(0x00, 0xB0, 0x00, 0x00, 0x01)) {
-				if(getStatusWord() == 0x9000) {
-					if(getResponse(&nbOfFiles) == 1) {
-
-						for(i = 0; i < nbOfFiles; i++) {
-							offset =  1 + (i * 0x15);
-
-							if(transmit(0x00, 0xB0, offset >> 8, offset, 0x15)) {
-								if(getStatusWord() == 0x9000) {
-									if(getResponse(record) == 0x15) {
-										nfile = (mias_file_t*) calloc(1, sizeof(mias_file_t));
-										nfile->efid = (record[0] << 8) | record[1];
-										nfile->size = (record[2] << 8) | record[3];
-										memcpy(nfile->dir, &record[12], 8);
-										memcpy(nfile->name, &record[4], 8);
-
-										/*
-										printf("dir: ");
-										for(int ii=0; ii<8; ii++) {
-											printf("%c", nfile->dir[ii]);
-										}
-										printf("    ");
-
-										printf("name: ");
-										for(int ii=0; ii<8; ii++) {
-											printf("%c", nfile->name[ii]);
-										}
-										printf("    ");
-
-										printf("efid: %04X\n", nfile->efid);
-										fflush(stdout);
-										*/
-										nfile->next = file;
-										file = nfile;
-									}
-								}
-							}
-						}
-
-						while(file != NULL) {
-							if((strcmp((const char*) file->dir, "p11") == 0) && ((memcmp((const char*) file->name, "pubdat", 6) == 0) || ((memcmp((const char*) file->name, "pridat", 6) == 0)))) {
-								//printf("name: %s\n", file->name);
-								//printf("efid: %04X\n", file->efid);
-
-								data[0] = file->efid >> 8;
-								data[1] = file->efid;
-
-								if(transmit(0x00, 0xA4, 0x08, 0x04, data, sizeof(data))) {
-									if(getStatusWord() == 0x9000) {
-
-										offset = 16;
-
-										if(transmit(0x00, 0xB0, offset >> 8, offset, 0x01)) {
-											if(getStatusWord() == 0x9000) {
-												if(getResponse(record) == 0x01) {
-													offset++;
-													if(transmit(0x00, 0xB0, offset >> 8, offset, record[0])) {
-														if(getStatusWord() == 0x9000) {
-															if(getResponseLength() == record[0]) {
-																getResponse(record);
-																record[getResponseLength()] = '\0';
-																//printf("%s\n", record);
-																if((labelLen == getResponseLength()) && (memcmp((void*) label, (void*) record, labelLen) == 0)) {
-
-																	offset += labelLen;
-
-																	// Skip CKA_APPLICATION
-																	if(transmit(0x00, 0xB0, offset >> 8, offset, 0x01)) {
-																		if(getStatusWord() == 0x9000) {
-																			if(getResponse(record) == 0x01) {
-																				offset += 1 + record[0];
-
-																				// Skip CKA_OBJECT_ID
-																				if(transmit(0x00, 0xB0, offset >> 8, offset, 0x01)) {
-																					if(getStatusWord() == 0x9000) {
-																						if(getResponse(record) == 0x01) {
-																							offset += 1 + record[0];
-
-																							// Read CKA_VALUE
-																							if(transmit(0x00, 0xB0, offset >> 8, offset, 0x05)) {
-																								if(getStatusWord() == 0x9000) {
-																									if(getResponse(record) == 0x05) {
-																										if(record[0] < 0x80) {
-																											size = record[0];
-																										}
-																										else {
-																											for(i=0; i<(record[0] & 0x0F); i++, offset++) {
-																												size <<= 8;
-																												size |= record[1 + i];
-																											}
-																										}
-
-																										offset++;
-
-																										//printf("CKA_VALUE size = %02X\n", size);
-
-																										// Clear the files to free some space
-																										while(file != NULL) {
-																											nfile = file->next;
-																											free(file);
-																											file = nfile;
-																										}
-																										// ----
-
-																										*objectLen = size + 1;
-																										*object = (uint8_t*) malloc((*objectLen) * sizeof(uint8_t));
-																										for(i=0; i<size;) {
-																											len = 0xEE;
-																											if((i + len) > size) {
-																												len = size - i;
-																											}
-
-																											if(transmit(0x00, 0xB0, offset >> 8, offset, len)) {
-																												if(getStatusWord() == 0x9000) {
-																													len = getResponse(&(*object)[i]);
-																												}
-																											}
-
-																											offset += len;
-																											i += len;
-																										}
-																										(*object)[i] = '\0';
-
-																										return true;
-																									}
-																								}
-																							}
-																						}
-																					}
-																				}
-																			}
-																		}
-																	}
-
-																}
-															}
-														}
-													}
-												}
-											}
-										}
-									}
-								}
-							}
-							nfile = file->next;
-							free(file);
-							file = nfile;
-						}
-					}
-				}
-			}
-		}
-	}
-
-	return false;
-}
-
-bool MIAS::hashInit(uint8_t algorithm) {
-	_hashAlgo = algorithm;
-	return mseSetBeforeHash(_hashAlgo);
-}
-
-bool MIAS::hashUpdate(uint8_t* data, uint16_t dataLen) {
-	return psoHashInternally(_hashAlgo, data, dataLen);
-}
-
-bool MIAS::hashFinal(uint8_t* hash, uint16_t* hashLen) {
-	return psoHashInternallyFinal(hash, hashLen);
-}
-
-bool MIAS::signInit(uint8_t algorithm, uint8_t key) {
-	_signAlgo = algorithm;
-	_signKey = key;
-	return mseSetBeforeSignature(_signAlgo, _signKey);
-}
-
-bool MIAS::signFinal(uint8_t* hash, uint16_t hashLen, uint8_t* signature, uint16_t* signatureLen) {
-	if(psoHashExternally(_signAlgo & 0xF0, hash, hashLen)) {
-		if(psoComputeDigitalSignature(signature, signatureLen)) {
-			return true;
-		}
-	}	
-	return false;
-}
-
-bool MIAS::decryptInit(uint8_t algorithm, uint8_t key) {
-	_decryptAlgo = algorithm;
-	_decryptKey = key;
-	return mseSetBeforeDecrypt(_decryptAlgo, _decryptKey);
-}
-
-bool MIAS::decryptFinal(uint8_t* data, uint16_t dataLen, uint8_t* plain, uint16_t* plainLen) {
-	return psoDecipher(data, dataLen, plain, plainLen);
-}
-
-/** C Accessors	***************************************************************/
-
-extern "C" MIAS* MIAS_create(void) {
-	return new MIAS();
-}
-
-extern "C" void MIAS_destroy(MIAS* mias) {
-	delete mias;
-}
-
-extern "C" bool MIAS_verify_pin(MIAS* mias, uint8_t* pin, uint16_t pin_len) {
-	return mias->verifyPin(pin, pin_len);
-}
-
-extern "C" bool MIAS_change_pin(MIAS* mias, uint8_t* old_pin, uint16_t old_pin_len, uint8_t* new_pin, uint16_t new_pin_len) {
-	return mias->changePin(old_pin, old_pin_len, new_pin, new_pin_len);
-}
-
-extern "C" bool MIAS_get_key_pair_by_container_id(MIAS* mias, uint8_t container_id, mias_key_pair_t** kp) {
-	return mias->getKeyPairByContainerId(container_id, kp);
-}
-
-extern "C" bool MIAS_get_certificate_by_container_id(MIAS* mias, uint8_t container_id, uint8_t** cert, uint16_t* cert_len) {
-	return mias->getCertificateByContainerId(container_id, cert, cert_len);
-}
-
-extern "C" bool MIAS_p11_get_object_by_label(MIAS* mias, uint8_t* label, uint16_t label_len, uint8_t** object, uint16_t* object_len) {
-	return mias->p11GetObjectByLabel(label, label_len, object, object_len);
-}
-		
-extern "C" bool MIAS_hash_init(MIAS* mias, uint8_t algorithm) {
-	return mias->hashInit(algorithm);
-}
-
-extern "C" bool MIAS_hash_update(MIAS* mias, uint8_t* data, uint16_t data_len) {
-	return mias->hashUpdate(data, data_len);
-}
-
-extern "C" bool MIAS_hash_final(MIAS* mias, uint8_t* hash, uint16_t* hash_len) {
-	return mias->hashFinal(hash, hash_len);
-}
-
-extern "C" bool MIAS_sign_init(MIAS* mias, uint8_t algorithm, uint8_t key) {
-	return mias->signInit(algorithm, key);
-}
-
-extern "C" bool MIAS_sign_final(MIAS* mias, uint8_t* hash, uint16_t hash_len, uint8_t* signature, uint16_t* signature_len) {
-	return mias->signFinal(hash, hash_len, signature, signature_len);
-}
-
-extern "C" bool MIAS_decrypt_init(MIAS* mias, uint8_t algorithm, uint8_t key) {
-	return mias->decryptInit(algorithm, key);
-}
-
-extern "C" bool MIAS_decrypt_final(MIAS* mias, uint8_t* data, uint16_t data_len, uint8_t* plain, uint16_t* plain_len) {
-	return mias->decryptFinal(data, data_len, plain, plain_len);
-}
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#include "MIAS.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+//#define USE_GAT_RESPONSE
+
+// Largest supported key is RSA 2048-bits
+#define MIAS_MAX_SIGNATURE_LENGTH 256
+
+static uint8_t AID[] = { 0xA0, 0x00, 0x00, 0x00, 0x18, 0x80, 0x00, 0x00, 0x00, 0x06, 0x62, 0x41, 0x51 };
+
+MIAS::MIAS(void) : Applet(AID, sizeof(AID)) {
+	_keypairs = NULL;
+	_files = NULL;
+	_p11count = 0;
+	memset(_p11index, 0, sizeof(_p11index));
+	_p11complete = false;
+	_cacheModified = false;
+	
+	_hashAlgo = 0;
+
+	_signAlgo = 0;
+	_signKey = 0;
+	_signReady = false;
+	_signSelection = 0;
+
+	_decryptKey = 0;
+
+	resetBufferedEF();
+	_decryptAlgo = 0;
+}
+  
+MIAS::~MIAS(void) {
+	clearCache();
+}
+
+/** PRIVATE *******************************************************************/
+
+bool MIAS::mseSetBeforeHash(uint8_t algorithm) {
+	uint8_t data[3];
+
+	_signReady = false;
+		
+	data[0] = 0x80;
+	data[1] = 0x01;
+	data[2] = algorithm;
+	
+	if(transmit(0x00, 0x22, 0x41, 0xAA, data, sizeof(data))) {
+		if(getStatusWord() == 0x9000) {
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+bool MIAS::psoHashInternally(uint8_t algorithm, uint8_t* data, uint16_t dataLen) {
+	uint8_t block_size;
+	uint16_t i, l;
+	
+	if((algorithm == ALGO_SHA1) || (algorithm == ALGO_SHA224) || (algorithm == ALGO_SHA256)) {
+		block_size = 64;
+	}
+	else if((algorithm == ALGO_SHA384) || (algorithm == ALGO_SHA512)) {
+		block_size = 128;
+	}
+	else {
+		return false;
+	}
+	
+	for(i=0; i<dataLen; i += l) {
+		if((l = dataLen - i) > block_size) {
+			l = block_size;
+		}
+
+		if(!transmit(0x00, 0x2A, 0x90, 0x80, &data[i], l)) {
+			return false;
+		}
+			
+		if(getStatusWord() != 0x9000) {
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+bool MIAS::psoHashInternallyFinal(uint8_t* hash, uint16_t* hashLen) {
+	uint8_t data[2];
+	
+	data[0] = 0x80;
+	data[1] = 0x00;
+	
+	*hashLen = 0;
+	
+	if(transmit(0x00, 0x2A, 0x90, 0xA0, data, sizeof(data), 0x00)) {
+		if(getStatusWord() == 0x9000) {
+			*hashLen = getResponse(hash);
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+bool MIAS::psoHashExternally(uint8_t algorithm, uint8_t* hash, uint16_t hashLen) {
+	uint8_t data[66];
+	
+	data[0] = 0x90;
+	switch(algorithm) {
+		case ALGO_SHA1:
+			data[1] = 20;
+			break;
+		
+		case ALGO_SHA224:
+			data[1] = 28;
+		
+			break;
+		case ALGO_SHA256:
+			data[1] = 32;
+		
+			break;
+		case ALGO_SHA384:
+			data[1] = 48;
+		
+			break;
+		case ALGO_SHA512:
+			data[1] = 64;
+			break;
+		
+		default:
+			return false;
+	}
+
+	// Hash shorter than the algorithm digest would be read past its end
+	if(hashLen < data[1]) {
+		return false;
+	}
+	memcpy(&data[2], hash, data[1]);
+	
+	if(transmit(0x00, 0x2A, 0x90, 0xA0, data, 2 + data[1], 0x00)) {
+		if(getStatusWord() == 0x9000) {
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+bool MIAS::mseSetBeforeSignature(uint8_t algorithm, uint8_t key) {
+	uint8_t data[6];
+	
+	data[0] = 0x80;
+	data[1] = 0x01;
+	data[2] = algorithm;
+	data[3] = 0x84;
+	data[4] = 0x01;
+	data[5] = key;
+	
+	if(transmit(0x00, 0x22, 0x41, 0xB6, data, sizeof(data))) {
+		if(getStatusWord() == 0x9000) {
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+bool MIAS::psoComputeDigitalSignature(uint8_t* signature, uint16_t* signatureLen) {
+	#ifdef USE_GAT_RESPONSE
+	uint16_t len;
+	
+	if(!_isBasic) {
+		*signatureLen = 0;
+		
+		if(transmit(0x00, 0x2A, 0x9E, 0x9A, 0x00)) {
+			// GAT format: [DATA1 DATA2 ... ][GAT SW1 SW2][90 00]
+			while((getStatusWord() == 0x9000) && (_seiface->_apduResponseLen >= 4)) {
+				// Convert ApduResponse in order to have GAT status word as regular status word
+				_seiface->_apduResponseLen -= 2;
+				
+				len = getResponse(signature);
+				signature += len;
+				*signatureLen += len;
+				if((getStatusWord() & 0xFF00) == 0x6100) {
+					// Transmit GAT Response
+					if(transmit(0x00, 0xC2, 0x00, 0x00, getStatusWord() & 0x00FF)) {
+						continue;
+					}
+				}
+				else if(getStatusWord() == 0x9000) {
+					return true;
+				}
+				return false;
+			}
+		}
+		
+		return false;
+	}
+	#endif
+	
+	// 61xx continuations are received straight into signature
+	*signatureLen = MIAS_MAX_SIGNATURE_LENGTH + 2;
+	
+	if(transmitExtended(0x00, 0x2A, 0x9E, 0x9A, NULL, 0, SE_SHORT_MAX_DATA_LENGTH, signature, signatureLen)) {
+		if(getStatusWord() == 0x9000) {
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+bool MIAS::mseSetBeforeDecrypt(uint8_t algorithm, uint8_t key) {
+	uint8_t data[6];
+
+	_signReady = false;
+	
+	data[0] = 0x80;
+	data[1] = 0x01;
+	data[2] = algorithm;
+	data[3] = 0x84;
+	data[4] = 0x01;
+	data[5] = key;
+	
+	if(transmit(0x00, 0x22, 0x41, 0xB8, data, sizeof(data))) {
+		if(getStatusWord() == 0x9000) {
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+bool MIAS::psoDecipher(uint8_t* data, uint16_t dataLen, uint8_t* plain, uint16_t* plainLen) {	
+	uint8_t buf[1 + 512];
+	
+	if(dataLen >= sizeof(buf)) {
+		return false;
+	}
+	
+	buf[0] = 0x81;
+	memcpy(&buf[1], data, dataLen);
+	
+	// Sent within a single extended APDU when supported, using command chaining otherwise
+	if(!transmitExtended(0x00, 0x2A, 0x80, 0x86, buf, dataLen + 1, 0)) {
+		return false;
+	}
+	
+	if(getStatusWord() == 0x9000) {
+		*plainLen = getResponse(plain);
+		return true;
+	}
+	
+	return false;
+}
+
+uint16_t MIAS::getReadBinaryLength(void) {
+	uint16_t len;
+
+	// Short READ BINARY are kept to 0xEE bytes
+	len = getMaxResponseLength();
+	if(len <= SE_SHORT_MAX_DATA_LENGTH) {
+		len = 0xEE;
+	}
+
+	return len;
+}
+
+#define TAG_FILE_SIZE   0x81
+#define TAG_FDB         0x82
+#define TAG_FILE_ID     0x83
+#define TAG_LCS         0x8A
+#define TAG_CT_SEC_ATTR 0x8C
+
+bool MIAS::listKeyPairs(void) {
+	uint8_t CONTAINERS_INFO_EF[] = { 0x00, 0x02 };
+	uint16_t size = 0;
+	mias_key_pair_t* ptr;
+	
+	if(_keypairs != NULL) {
+		return true;
+	}
+	
+	if(transmit(0x00, 0xA4, 0x08, 0x04, CONTAINERS_INFO_EF, sizeof(CONTAINERS_INFO_EF), 0x15)) {
+		if(getStatusWord() == 0x9000) {
+			if(getResponseLength() > 2) {
+				if(_seiface->_apduResponse[0] == 0x62) {
+					uint8_t i, len;
+					uint8_t t, l;
+					uint16_t offset;
+					
+					len = _seiface->_apduResponse[1];
+					
+					for(i = 2, len += 2; i < len;) {
+						t = _seiface->_apduResponse[i];
+						l = _seiface->_apduResponse[i + 1];
+
+						switch(t) {
+							case TAG_FILE_SIZE:
+								size = (_seiface->_apduResponse[i + 2] << 8) | _seiface->_apduResponse[i + 3];
+								break;
+						}
+						
+						i += 2 + l;
+					}
+					
+					for(i = 0, offset = 0; offset < size; i++, offset += 0x0B) {
+						if(transmit(0x00, 0xB0, (offset >> 8) & 0xFF, offset & 0xFF, 0x0B)) {
+							if(getStatusWord() == 0x9000) {
+								if(_seiface->_apduResponse[0]) {	
+									ptr = (mias_key_pair_t*) malloc(sizeof(mias_key_pair_t));
+									ptr->kid = 0;
+									ptr->pub_file_id[0] = 0;
+									ptr->pub_file_id[1] = 0;
+									
+									ptr->flags = SIGNATURE_KEY_PAIR_FLAG;									
+									if((ptr->size_in_bits = (_seiface->_apduResponse[4] << 8) | _seiface->_apduResponse[5]) == 0) {
+										ptr->flags |= DECRYPTION_KEY_PAIR_FLAG;
+										ptr->size_in_bits = (_seiface->_apduResponse[6] << 8) | _seiface->_apduResponse[7];
+									}
+									
+									// RSA 1024-bits exchange keys
+									if((ptr->size_in_bits == 0x400) && ((ptr->flags & (SIGNATURE_KEY_PAIR_FLAG | DECRYPTION_KEY_PAIR_FLAG)) ==  (SIGNATURE_KEY_PAIR_FLAG | DECRYPTION_KEY_PAIR_FLAG))) {
+										ptr->kid = 0x10 | (i + 1);
+										ptr->flags |= RSA_KEY_PAIR_FLAG;
+									}
+									
+									// RSA 1024-bits signature keys
+									else if((ptr->size_in_bits == 0x400) && ((ptr->flags & (SIGNATURE_KEY_PAIR_FLAG | DECRYPTION_KEY_PAIR_FLAG)) ==  SIGNATURE_KEY_PAIR_FLAG)) {
+										ptr->kid = 0x20 | (i + 1);
+										ptr->flags |= RSA_KEY_PAIR_FLAG;
+									}
+									
+									// RSA 2048-bits exchange keys
+									else if((ptr->size_in_bits == 0x800) && ((ptr->flags & (SIGNATURE_KEY_PAIR_FLAG | DECRYPTION_KEY_PAIR_FLAG)) ==  (SIGNATURE_KEY_PAIR_FLAG | DECRYPTION_KEY_PAIR_FLAG))) {
+										ptr->kid = 0x30 | (i + 1);
+										ptr->flags |= RSA_KEY_PAIR_FLAG;
+									}
+									
+									// RSA 2048-bits signature keys
+									else if((ptr->size_in_bits == 0x800) && ((ptr->flags & (SIGNATURE_KEY_PAIR_FLAG | DECRYPTION_KEY_PAIR_FLAG)) ==  SIGNATURE_KEY_PAIR_FLAG)) {
+										ptr->kid = 0x40 | (i + 1);
+										ptr->flags |= RSA_KEY_PAIR_FLAG;
+									}
+									
+									// ECC P-256, P-384 and P-521 keys: exchange keys from 0x50, 0x70 and 0x90,
+									// signature keys from 0x60, 0x80 and 0xA0
+									else if((ptr->size_in_bits == 256) || (ptr->size_in_bits == 384) || (ptr->size_in_bits == 521)) {
+										ptr->kid = (ptr->size_in_bits == 256) ? 0x50 : ((ptr->size_in_bits == 384) ? 0x70 : 0x90);
+										if(!(ptr->flags & DECRYPTION_KEY_PAIR_FLAG)) {
+											ptr->kid += 0x10;
+										}
+										ptr->kid |= i + 1;
+										ptr->flags |= ECC_KEY_PAIR_FLAG;
+									}
+									
+									ptr->has_cert = false;
+									
+									ptr->next = _keypairs;
+									_keypairs = ptr;
+								}
+							}
+							else {
+								break;
+							}
+						}
+					}
+									
+					if(listFiles()) {
+						mias_file_t* file;
+
+						for(file = _files; file != NULL; file = file->next) {
+							if(memcmp(file->dir, "mscp", 4) != 0) {
+								continue;
+							}
+
+							// kxc file is for exchange keys, ksc file is for signature keys
+							if((memcmp(file->name, "kxc", 3) == 0) || (memcmp(file->name, "ksc", 3) == 0)) {
+								for(ptr = _keypairs; ptr != NULL; ptr = ptr->next) {
+									if(((ptr->kid & 0x0F) - 1) == (((file->name[3] - '0') * 10) + (file->name[4] - '0'))) {
+										ptr->pub_file_id[0] = file->efid >> 8;
+										ptr->pub_file_id[1] = file->efid;
+										ptr->has_cert = true;
+										break;
+									}
+								}
+							}
+						}
+					}
+					
+					_cacheModified = true;
+					
+					// DEBUG
+					/*
+					{
+						ptr = _keypairs;
+											
+						printf("\r\n---\r\n");
+						while(ptr != NULL) {
+							printf("KID: %02X %d\r\n", ptr->kid,  ptr->has_cert);
+							ptr = ptr->next;
+						}
+						printf("---\r\n\r\n");
+					}
+					*/
+					// -----
+					return true;
+				}
+			}
+		}
+	}
+	
+	return false;
+}
+
+bool MIAS::getKeyPairByContainerId(uint8_t containter_id, mias_key_pair_t** kp) {												
+	listKeyPairs();
+	
+	*kp = _keypairs;
+	
+	while(*kp != NULL) {
+		if((((*kp)->kid & 0x0F) - 1) == containter_id) {
+			return true;
+		}
+		*kp = (*kp)->next;
+	}
+	
+	return false;
+}
+
+bool MIAS::selectCertificateByContainerId(uint8_t container_id, uint16_t* size) {
+	mias_key_pair_t* kp;
+
+	if(getKeyPairByContainerId(container_id, &kp)) {
+		if(kp->has_cert) {
+			return selectEF(kp->pub_file_id, size);
+		}
+	}
+
+	return false;
+}
+
+bool MIAS::getCertificateByContainerId(uint8_t container_id, uint8_t** cert, uint16_t* certLen) {
+	uint16_t ef_size, first;
+
+	if(selectCertificateByContainerId(container_id, &ef_size) && ef_size) {
+		*certLen = ef_size + 1;
+		// Room for the status word of the last chunk, replaced by the final '\0'
+		*cert = (uint8_t*) malloc((*certLen + 1) * sizeof(uint8_t));
+
+		// First chunk tells whether the certificate is compressed
+		first = getReadBinaryLength();
+		if(first > ef_size) {
+			first = ef_size;
+		}
+
+		if(!readBinary(0, *cert, first)) {
+			free(*cert);
+			*cert = NULL;
+			*certLen = 0;
+			return false;
+		}
+
+		if((first >= MIAS_COMPRESSED_HEADER_LENGTH) && ((*cert)[0] == 0x01) && ((*cert)[1] == 0x00)) {
+			// Compressed, followed by the uncompressed length (little endian) and a zlib stream
+			*certLen = (*cert)[2] | ((*cert)[3] << 8);
+			free(*cert);
+
+			*cert = (uint8_t*) malloc((*certLen + 1) * sizeof(uint8_t));
+			if(!readInflatedBinary(MIAS_COMPRESSED_HEADER_LENGTH, ef_size - MIAS_COMPRESSED_HEADER_LENGTH, *cert, *certLen)) {
+				free(*cert);
+				*cert = NULL;
+				*certLen = 0;
+				return false;
+			}
+			(*cert)[*certLen] = '\0';
+			(*certLen)++;
+
+			return true;
+		}
+
+		if(!readBinary(first, &(*cert)[first], ef_size - first)) {
+			free(*cert);
+			*cert = NULL;
+			*certLen = 0;
+			return false;
+		}
+		(*cert)[ef_size] = '\0';
+
+		return true;
+	}
+	
+	return false;
+}
+
+bool MIAS::selectEF(uint8_t* fid, uint16_t* size) {
+	uint8_t i, len;
+	uint8_t t, l;
+
+	*size = 0;
+
+	if(transmit(0x00, 0xA4, 0x08, 0x04, fid, 2, 0x1C)) {
+		if(getStatusWord() == 0x9000) {
+			if(_seiface->_apduResponse[0] == 0x62) {
+				len = _seiface->_apduResponse[1];
+
+				for(i = 2, len += 2; i < len;) {
+					t = _seiface->_apduResponse[i];
+					l = _seiface->_apduResponse[i + 1];
+
+					if(t == TAG_FILE_SIZE) {
+						*size = (_seiface->_apduResponse[i + 2] << 8) | _seiface->_apduResponse[i + 3];
+					}
+
+					i += 2 + l;
+				}
+			}
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void MIAS::resetBufferedEF(void) {
+	_efId = 0;
+	_efSize = 0;
+	_efOffset = 0;
+	_efLength = 0;
+}
+
+bool MIAS::selectBufferedEF(uint16_t efid, uint16_t size) {
+	uint8_t fid[2];
+
+	if((_efId != 0) && (_efId == efid)) {
+		if(size) {
+			_efSize = size;
+		}
+		return true;
+	}
+
+	resetBufferedEF();
+
+	fid[0] = efid >> 8;
+	fid[1] = efid;
+
+	if(transmit(0x00, 0xA4, 0x08, 0x04, fid, sizeof(fid))) {
+		if(getStatusWord() == 0x9000) {
+			_efId = efid;
+			_efSize = size;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool MIAS::readBufferedEF(uint16_t offset, uint8_t* data, uint16_t len) {
+	uint16_t window, rlen;
+
+	if(len > MIAS_EF_BUFFER_SIZE) {
+		return false;
+	}
+
+	if(len == 0) {
+		return true;
+	}
+
+	if((offset < _efOffset) || ((uint32_t) offset + len > (uint32_t) _efOffset + _efLength)) {
+		window = getReadBinaryLength();
+		if(window > MIAS_EF_BUFFER_SIZE) {
+			window = MIAS_EF_BUFFER_SIZE;
+		}
+
+		if(_efSize) {
+			if((uint32_t) offset + len > _efSize) {
+				return false;
+			}
+			if((uint32_t) offset + window > _efSize) {
+				window = _efSize - offset;
+			}
+		}
+
+		_efLength = 0;
+		for(;;) {
+			// Window is received in place
+			rlen = window + 2;
+			if(transmitExtended(0x00, 0xB0, offset >> 8, offset, NULL, 0, window, _efBuffer, &rlen) && (getStatusWord() == 0x9000) && (rlen >= len)) {
+				break;
+			}
+
+			// EF size is unknown and the window may go past its end, only ask for what is needed
+			if(window == len) {
+				return false;
+			}
+			window = len;
+		}
+
+		_efOffset = offset;
+		_efLength = rlen;
+	}
+
+	memcpy(data, &_efBuffer[offset - _efOffset], len);
+
+	return true;
+}
+
+bool MIAS::listFiles(void) {
+	uint16_t FILE_DIR_EF = 0x0101;
+	uint8_t record[0x15];
+	uint8_t nbOfFiles;
+	uint16_t i, offset;
+	mias_file_t* file;
+	void* ptr;
+
+	if(_files != NULL) {
+		return true;
+	}
+
+	// Records are parsed from the read-ahead window, so that several of them come with each READ BINARY
+	resetBufferedEF();
+
+	if(selectBufferedEF(FILE_DIR_EF, 0)) {
+		if(readBufferedEF(0, &nbOfFiles, 1)) {
+			_efSize = 1 + (nbOfFiles * 0x15);
+
+			for(i = 0; i < nbOfFiles; i++) {
+				offset = 1 + (i * 0x15);
+
+				file = NULL;
+				if(readBufferedEF(offset, record, 0x15)) {
+					file = (mias_file_t*) calloc(1, sizeof(mias_file_t));
+				}
+
+				// Incomplete list is dropped, it would otherwise be cached and files reported absent
+				if(file == NULL) {
+					while(_files != NULL) {
+						ptr = _files->next;
+						free(_files);
+						_files = (mias_file_t*) ptr;
+					}
+					return false;
+				}
+
+				file->efid = (record[0] << 8) | record[1];
+				file->size = (record[2] << 8) | record[3];
+				memcpy(file->dir, &record[12], 8);
+				memcpy(file->name, &record[4], 8);
+
+				file->next = _files;
+				_files = file;
+			}
+
+			_cacheModified = true;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool MIAS::getDirectoryFingerprint(uint16_t* containersSize, uint16_t* fileDirSize) {
+	uint8_t CONTAINERS_INFO_EF[] = { 0x00, 0x02 };
+	uint8_t FILE_DIR_EF[] = { 0x01, 0x01 };
+
+	if(selectEF(CONTAINERS_INFO_EF, containersSize)) {
+		if(selectEF(FILE_DIR_EF, fileDirSize)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// djb2 hash of a P11 label.
+static uint32_t p11LabelHash(uint8_t* label, uint16_t labelLen) {
+	uint32_t hash = 5381;
+	uint16_t i;
+
+	for(i = 0; i < labelLen; i++) {
+		hash = ((hash << 5) + hash) + label[i];
+	}
+
+	return hash;
+}
+
+mias_p11_object_t* MIAS::p11Find(uint8_t* label, uint16_t labelLen) {
+	mias_p11_object_t* obj;
+	uint32_t hash;
+	uint16_t i, n;
+
+	hash = p11LabelHash(label, labelLen);
+
+	for(i = hash % MIAS_P11_INDEX_SIZE, n = 0; (n < MIAS_P11_INDEX_SIZE) && _p11index[i]; i = (i + 1) % MIAS_P11_INDEX_SIZE, n++) {
+		obj = &_p11objects[_p11index[i] - 1];
+		if((obj->hash == hash) && (obj->label_len == labelLen) && (memcmp(obj->label, label, labelLen) == 0)) {
+			return obj;
+		}
+	}
+
+	return NULL;
+}
+
+mias_p11_object_t* MIAS::p11Index(mias_p11_object_t* obj) {
+	uint16_t i;
+
+	if(_p11count >= MIAS_P11_MAX_OBJECTS) {
+		return NULL;
+	}
+
+	obj->hash = p11LabelHash(obj->label, (obj->label_len > MIAS_P11_LABEL_MAX_LENGTH) ? 0 : obj->label_len);
+	_p11objects[_p11count] = *obj;
+	_p11count++;
+
+	// Labels too long to be stored will never match a lookup
+	if(obj->label_len <= MIAS_P11_LABEL_MAX_LENGTH) {
+		for(i = obj->hash % MIAS_P11_INDEX_SIZE; _p11index[i]; i = (i + 1) % MIAS_P11_INDEX_SIZE);
+		_p11index[i] = _p11count;
+	}
+
+	return &_p11objects[_p11count - 1];
+}
+
+bool MIAS::p11IsIndexed(uint16_t efid) {
+	uint16_t i;
+
+	for(i = 0; i < _p11count; i++) {
+		if(_p11objects[i].efid == efid) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+uint16_t MIAS::p11FileSize(uint16_t efid) {
+	mias_file_t* file;
+
+	for(file = _files; file != NULL; file = file->next) {
+		if(file->efid == efid) {
+			return file->size;
+		}
+	}
+
+	return 0;
+}
+
+bool MIAS::p11ReadLabel(mias_p11_object_t* obj) {
+	uint8_t len;
+	uint16_t offset;
+
+	if(selectBufferedEF(obj->efid, p11FileSize(obj->efid))) {
+		offset = 16;
+
+		if(readBufferedEF(offset, &len, 1)) {
+			offset++;
+
+			obj->label_len = len;
+
+			// Labels longer than what can be indexed will never match a lookup
+			if(len > MIAS_P11_LABEL_MAX_LENGTH) {
+				return true;
+			}
+
+			return readBufferedEF(offset, obj->label, len);
+		}
+	}
+
+	return false;
+}
+
+bool MIAS::p11LocateValue(mias_p11_object_t* obj) {
+	uint8_t record[3];
+	uint8_t n;
+	uint16_t i, offset, size;
+
+	// Header usually comes within the window read along with the label
+	if(!selectBufferedEF(obj->efid, p11FileSize(obj->efid))) {
+		return false;
+	}
+
+	offset = 16 + 1 + obj->label_len;
+
+	// Skip CKA_APPLICATION
+	if(!readBufferedEF(offset, record, 1)) {
+		return false;
+	}
+	offset += 1 + record[0];
+
+	// Skip CKA_OBJECT_ID
+	if(!readBufferedEF(offset, record, 1)) {
+		return false;
+	}
+	offset += 1 + record[0];
+
+	// CKA_VALUE length, value size is at most 16 bits
+	if(!readBufferedEF(offset, record, 1)) {
+		return false;
+	}
+
+	size = 0;
+	if(record[0] < 0x80) {
+		size = record[0];
+	}
+	else {
+		n = record[0] & 0x7F;
+		if((n == 0) || (n > 2) || !readBufferedEF(offset + 1, &record[1], n)) {
+			return false;
+		}
+
+		for(i=0; i<n; i++, offset++) {
+			size <<= 8;
+			size |= record[1 + i];
+		}
+	}
+	offset++;
+
+	obj->value_offset = offset;
+	obj->value_size = size;
+	_cacheModified = true;
+
+	return true;
+}
+
+bool MIAS::p11ReadValue(mias_p11_object_t* obj, uint8_t** object, uint16_t* objectLen) {
+	uint16_t i, len, rlen, offset;
+
+	if(selectBufferedEF(obj->efid, p11FileSize(obj->efid))) {
+		*objectLen = obj->value_size + 1;
+		// Room for the status word of the last chunk, replaced by the final '\0'
+		*object = (uint8_t*) malloc((*objectLen + 1) * sizeof(uint8_t));
+
+		i = 0;
+		offset = obj->value_offset;
+
+		// Beginning of the value may already be in the read-ahead window
+		if((offset >= _efOffset) && (offset < _efOffset + _efLength)) {
+			i = _efOffset + _efLength - offset;
+			if(i > obj->value_size) {
+				i = obj->value_size;
+			}
+			memcpy(*object, &_efBuffer[offset - _efOffset], i);
+			offset += i;
+		}
+
+		while(i < obj->value_size) {
+			len = getReadBinaryLength();
+			if((i + len) > obj->value_size) {
+				len = obj->value_size - i;
+			}
+
+			// Chunk is received in place
+			rlen = len + 2;
+			if(!transmitExtended(0x00, 0xB0, offset >> 8, offset, NULL, 0, len, &(*object)[i], &rlen) || (getStatusWord() != 0x9000) || (rlen == 0)) {
+				free(*object);
+				*object = NULL;
+				*objectLen = 0;
+				return false;
+			}
+
+			offset += rlen;
+			i += rlen;
+		}
+		(*object)[i] = '\0';
+
+		return true;
+	}
+
+	return false;
+}
+
+/** PUBLIC ********************************************************************/
+
+bool MIAS::verifyPin(uint8_t* pin, uint16_t pinLen) {	
+	if(transmit(0x00, 0x20, 0x00, 0x81, pin, pinLen)) {
+		if(getStatusWord() == 0x9000) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool MIAS::changePin(uint8_t* oldPin, uint16_t oldPinLen, uint8_t* newPin, uint16_t newPinLen) {
+	uint8_t data[1 + (8 * 2)];
+	uint16_t dataLen;
+	
+	dataLen = 1 + oldPinLen + newPinLen;
+	
+	if(dataLen > sizeof(data)) {
+		return false;
+	}
+	
+	data[0] = (uint8_t) oldPinLen;
+	memcpy(&data[1], oldPin, oldPinLen);
+	memcpy(&data[oldPinLen], newPin, newPinLen);
+	
+	if(transmit(0x80, 0x24, 0x00, 0x81, data, dataLen)) {
+		if(getStatusWord() == 0x9000) {
+			return true;
+		}
+	}
+	return false;
+}
+
+mias_p11_object_t* MIAS::p11FindObject(uint8_t* label, uint16_t labelLen, mias_p11_object_t* found) {
+	mias_file_t* file;
+	mias_p11_object_t* obj;
+	bool complete;
+
+	if(labelLen > MIAS_P11_LABEL_MAX_LENGTH) {
+		return NULL;
+	}
+
+	// Current EF may have been changed since the last lookup
+	resetBufferedEF();
+
+	// Look for an already indexed object first, this avoids walking FILE_DIR_EF
+	if((obj = p11Find(label, labelLen)) != NULL) {
+		return (obj->value_offset || p11LocateValue(obj)) ? obj : NULL;
+	}
+
+	if(_p11complete) {
+		return NULL;
+	}
+
+	if(!listFiles()) {
+		return NULL;
+	}
+
+	complete = true;
+
+	for(file = _files; file != NULL; file = file->next) {
+		if((strcmp((const char*) file->dir, "p11") == 0) && ((memcmp((const char*) file->name, "pubdat", 6) == 0) || ((memcmp((const char*) file->name, "pridat", 6) == 0)))) {
+			// Skip files whose label is already known
+			if(p11IsIndexed(file->efid)) {
+				continue;
+			}
+
+			memset(found, 0, sizeof(mias_p11_object_t));
+			found->efid = file->efid;
+
+			if(!p11ReadLabel(found)) {
+				complete = false;
+				continue;
+			}
+
+			// Object is still usable for this lookup when the arena is full
+			if((obj = p11Index(found)) != NULL) {
+				_cacheModified = true;
+			}
+			else {
+				obj = found;
+				complete = false;
+			}
+
+			if((obj->label_len == labelLen) && (memcmp(obj->label, label, labelLen) == 0)) {
+				return p11LocateValue(obj) ? obj : NULL;
+			}
+		}
+	}
+
+	// Labels of all P11 files are known, next unknown labels are rejected without walking FILE_DIR_EF
+	if(complete) {
+		_p11complete = true;
+		_cacheModified = true;
+	}
+
+	return NULL;
+}
+
+bool MIAS::p11GetObjectByLabel(uint8_t* label, uint16_t labelLen, uint8_t** object, uint16_t* objectLen) {
+	mias_p11_object_t* obj;
+	mias_p11_object_t found;
+
+	*objectLen = 0;
+
+	if((obj = p11FindObject(label, labelLen, &found)) != NULL) {
+		return p11ReadValue(obj, object, objectLen);
+	}
+
+	return false;
+}
+
+bool MIAS::p11SelectObjectByLabel(uint8_t* label, uint16_t labelLen, uint16_t* offset, uint16_t* size) {
+	mias_p11_object_t* obj;
+	mias_p11_object_t found;
+
+	if((obj = p11FindObject(label, labelLen, &found)) != NULL) {
+		if(selectBufferedEF(obj->efid, p11FileSize(obj->efid))) {
+			*offset = obj->value_offset;
+			*size = obj->value_size;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool MIAS::getCertificateFingerprint(uint8_t container_id, uint16_t* size, uint32_t* fingerprint) {
+	mias_key_pair_t* kp;
+
+	if(getKeyPairByContainerId(container_id, &kp)) {
+		if(kp->has_cert) {
+			if(selectEF(kp->pub_file_id, size)) {
+				return readFingerprint(0, *size, fingerprint);
+			}
+		}
+	}
+
+	return false;
+}
+
+bool MIAS::p11GetObjectFingerprint(uint8_t* label, uint16_t labelLen, uint16_t* size, uint32_t* fingerprint) {
+	mias_p11_object_t* obj;
+	uint8_t fid[2];
+
+	if(labelLen > MIAS_P11_LABEL_MAX_LENGTH) {
+		return false;
+	}
+
+	if(((obj = p11Find(label, labelLen)) == NULL) || (obj->value_offset == 0)) {
+		return false;
+	}
+
+	fid[0] = obj->efid >> 8;
+	fid[1] = obj->efid;
+
+	if(selectEF(fid, size)) {
+		if((obj->value_offset + obj->value_size) <= *size) {
+			return readFingerprint(obj->value_offset, obj->value_size, fingerprint);
+		}
+	}
+
+	return false;
+}
+
+bool MIAS::hashInit(uint8_t algorithm) {
+	_hashAlgo = algorithm;
+	return mseSetBeforeHash(_hashAlgo);
+}
+
+bool MIAS::hashUpdate(uint8_t* data, uint16_t dataLen) {
+	return psoHashInternally(_hashAlgo, data, dataLen);
+}
+
+bool MIAS::hashFinal(uint8_t* hash, uint16_t* hashLen) {
+	return psoHashInternallyFinal(hash, hashLen);
+}
+
+bool MIAS::signInit(uint8_t algorithm, uint8_t key) {
+	// Security environment is kept by the SE until the applet is selected again
+	if(_signReady && (_signSelection == _selections) && (_signAlgo == algorithm) && (_signKey == key)) {
+		return true;
+	}
+
+	_signAlgo = algorithm;
+	_signKey = key;
+	_signReady = mseSetBeforeSignature(_signAlgo, _signKey);
+	_signSelection = _selections;
+	return _signReady;
+}
+
+bool MIAS::signFinal(uint8_t* hash, uint16_t hashLen, uint8_t* signature, uint16_t* signatureLen) {
+	if(psoHashExternally(_signAlgo & 0xF0, hash, hashLen)) {
+		if(psoComputeDigitalSignature(signature, signatureLen)) {
+			return true;
+		}
+	}	
+
+	// Environment may have been lost, it is set again on next signature
+	_signReady = false;
+	return false;
+}
+
+bool MIAS::decryptInit(uint8_t algorithm, uint8_t key) {
+	_decryptAlgo = algorithm;
+	_decryptKey = key;
+	return mseSetBeforeDecrypt(_decryptAlgo, _decryptKey);
+}
+
+bool MIAS::decryptFinal(uint8_t* data, uint16_t dataLen, uint8_t* plain, uint16_t* plainLen) {
+	return psoDecipher(data, dataLen, plain, plainLen);
+}
+
+/*** METADATA CACHE **********************************************************/
+
+#define MIAS_CACHE_MAGIC   0x4D494143 // "MIAC"
+#define MIAS_CACHE_VERSION 4
+
+// Snapshot is written field by field in big endian, records do not depend on
+// the compiler layout of the structures and are read back in the same order.
+#define MIAS_CACHE_ICCID_LENGTH    10
+#define MIAS_CACHE_HEADER_SIZE     32
+#define MIAS_CACHE_KEY_PAIR_SIZE   8
+#define MIAS_CACHE_FILE_SIZE       22
+#define MIAS_CACHE_P11_OBJECT_SIZE (7 + MIAS_P11_LABEL_MAX_LENGTH)
+
+static void cachePut16(uint8_t* p, uint16_t v) {
+	p[0] = (uint8_t)(v >> 8);
+	p[1] = (uint8_t) v;
+}
+
+static uint16_t cacheGet16(const uint8_t* p) {
+	return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+bool MIAS::loadCache(const char* path, uint8_t* iccid, uint16_t iccidLen) {
+	FILE* f;
+	uint8_t header[MIAS_CACHE_HEADER_SIZE];
+	uint8_t record[MIAS_CACHE_P11_OBJECT_SIZE];
+	uint16_t containersSize, fileDirSize;
+	uint16_t nbKeyPairs, nbFiles, nbP11Objects;
+	mias_key_pair_t** lastKeyPair;
+	mias_file_t** lastFile;
+	mias_p11_object_t obj;
+	uint16_t i;
+	bool ret = false;
+
+	if(iccidLen > MIAS_CACHE_ICCID_LENGTH) {
+		return false;
+	}
+
+	if((f = fopen(path, "rb")) == NULL) {
+		return false;
+	}
+
+	// Header: magic, version, header and record sizes, ICCID, EF sizes, record counts, P11 completeness
+	if(fread(header, sizeof(header), 1, f) == 1) {
+		if((cacheGet16(&header[0]) == (MIAS_CACHE_MAGIC >> 16)) && (cacheGet16(&header[2]) == (MIAS_CACHE_MAGIC & 0xFFFF)) &&
+		   (cacheGet16(&header[4]) == MIAS_CACHE_VERSION) && (header[6] == MIAS_CACHE_HEADER_SIZE) &&
+		   (header[7] == MIAS_CACHE_KEY_PAIR_SIZE) && (header[8] == MIAS_CACHE_FILE_SIZE) && (header[9] == MIAS_CACHE_P11_OBJECT_SIZE) &&
+		   (memcmp(&header[10], iccid, iccidLen) == 0)) {
+			if(getDirectoryFingerprint(&containersSize, &fileDirSize)) {
+				if((cacheGet16(&header[20]) == containersSize) && (cacheGet16(&header[22]) == fileDirSize)) {
+					nbKeyPairs = cacheGet16(&header[24]);
+					nbFiles = cacheGet16(&header[26]);
+					nbP11Objects = cacheGet16(&header[28]);
+
+					clearCache();
+					ret = true;
+
+					lastKeyPair = &_keypairs;
+					for(i = 0; ret && (i < nbKeyPairs); i++) {
+						if((ret = (fread(record, MIAS_CACHE_KEY_PAIR_SIZE, 1, f) == 1))) {
+							mias_key_pair_t* kp = (mias_key_pair_t*) malloc(sizeof(mias_key_pair_t));
+							kp->kid = record[0];
+							kp->flags = cacheGet16(&record[1]);
+							kp->size_in_bits = cacheGet16(&record[3]);
+							memcpy(kp->pub_file_id, &record[5], 2);
+							kp->has_cert = (record[7] != 0);
+							kp->next = NULL;
+							*lastKeyPair = kp;
+							lastKeyPair = &kp->next;
+						}
+					}
+
+					lastFile = &_files;
+					for(i = 0; ret && (i < nbFiles); i++) {
+						if((ret = (fread(record, MIAS_CACHE_FILE_SIZE, 1, f) == 1))) {
+							mias_file_t* file = (mias_file_t*) malloc(sizeof(mias_file_t));
+							file->efid = cacheGet16(&record[0]);
+							memcpy(file->dir, &record[2], sizeof(file->dir));
+							memcpy(file->name, &record[11], sizeof(file->name));
+							file->size = cacheGet16(&record[20]);
+							file->next = NULL;
+							*lastFile = file;
+							lastFile = &file->next;
+						}
+					}
+
+					for(i = 0; ret && (i < nbP11Objects); i++) {
+						if((ret = (fread(record, MIAS_CACHE_P11_OBJECT_SIZE, 1, f) == 1))) {
+							memset(&obj, 0, sizeof(obj));
+							obj.efid = cacheGet16(&record[0]);
+							obj.label_len = record[2];
+							obj.value_offset = cacheGet16(&record[3]);
+							obj.value_size = cacheGet16(&record[5]);
+							memcpy(obj.label, &record[7], MIAS_P11_LABEL_MAX_LENGTH);
+							ret = (p11Index(&obj) != NULL);
+						}
+					}
+					_p11complete = ret && (header[30] != 0);
+
+					if(!ret) {
+						clearCache();
+					}
+				}
+			}
+		}
+	}
+
+	fclose(f);
+
+	_cacheModified = false;
+	return ret;
+}
+
+bool MIAS::saveCache(const char* path, uint8_t* iccid, uint16_t iccidLen) {
+	FILE* f;
+	uint8_t header[MIAS_CACHE_HEADER_SIZE];
+	uint8_t record[MIAS_CACHE_P11_OBJECT_SIZE];
+	uint16_t containersSize, fileDirSize;
+	uint16_t nbKeyPairs = 0, nbFiles = 0;
+	mias_key_pair_t* kp;
+	mias_file_t* file;
+	uint16_t i;
+	bool ret = true;
+
+	if(iccidLen > MIAS_CACHE_ICCID_LENGTH) {
+		return false;
+	}
+
+	if(!getDirectoryFingerprint(&containersSize, &fileDirSize)) {
+		return false;
+	}
+
+	for(kp = _keypairs; kp != NULL; kp = kp->next) {
+		nbKeyPairs++;
+	}
+	for(file = _files; file != NULL; file = file->next) {
+		nbFiles++;
+	}
+
+	memset(header, 0, sizeof(header));
+	cachePut16(&header[0], MIAS_CACHE_MAGIC >> 16);
+	cachePut16(&header[2], MIAS_CACHE_MAGIC & 0xFFFF);
+	cachePut16(&header[4], MIAS_CACHE_VERSION);
+	header[6] = MIAS_CACHE_HEADER_SIZE;
+	header[7] = MIAS_CACHE_KEY_PAIR_SIZE;
+	header[8] = MIAS_CACHE_FILE_SIZE;
+	header[9] = MIAS_CACHE_P11_OBJECT_SIZE;
+	memcpy(&header[10], iccid, iccidLen);
+	cachePut16(&header[20], containersSize);
+	cachePut16(&header[22], fileDirSize);
+	cachePut16(&header[24], nbKeyPairs);
+	cachePut16(&header[26], nbFiles);
+	cachePut16(&header[28], _p11count);
+	header[30] = _p11complete ? 1 : 0;
+
+	if((f = fopen(path, "wb")) == NULL) {
+		return false;
+	}
+
+	ret &= (fwrite(header, sizeof(header), 1, f) == 1);
+	for(kp = _keypairs; kp != NULL; kp = kp->next) {
+		record[0] = kp->kid;
+		cachePut16(&record[1], kp->flags);
+		cachePut16(&record[3], kp->size_in_bits);
+		memcpy(&record[5], kp->pub_file_id, 2);
+		record[7] = kp->has_cert ? 1 : 0;
+		ret &= (fwrite(record, MIAS_CACHE_KEY_PAIR_SIZE, 1, f) == 1);
+	}
+	for(file = _files; file != NULL; file = file->next) {
+		cachePut16(&record[0], file->efid);
+		memcpy(&record[2], file->dir, sizeof(file->dir));
+		memcpy(&record[11], file->name, sizeof(file->name));
+		cachePut16(&record[20], file->size);
+		ret &= (fwrite(record, MIAS_CACHE_FILE_SIZE, 1, f) == 1);
+	}
+	for(i = 0; i < _p11count; i++) {
+		cachePut16(&record[0], _p11objects[i].efid);
+		record[2] = _p11objects[i].label_len;
+		cachePut16(&record[3], _p11objects[i].value_offset);
+		cachePut16(&record[5], _p11objects[i].value_size);
+		memcpy(&record[7], _p11objects[i].label, MIAS_P11_LABEL_MAX_LENGTH);
+		ret &= (fwrite(record, MIAS_CACHE_P11_OBJECT_SIZE, 1, f) == 1);
+	}
+
+	fclose(f);
+
+	if(ret) {
+		_cacheModified = false;
+	}
+	else {
+		remove(path);
+	}
+
+	return ret;
+}
+
+bool MIAS::isCacheModified(void) {
+	return _cacheModified;
+}
+
+void MIAS::clearCache(void) {
+	void* ptr;
+
+	while(_keypairs != NULL) {
+		ptr = _keypairs->next;
+		free(_keypairs);
+		_keypairs = (mias_key_pair_t*) ptr;
+	}
+
+	while(_files != NULL) {
+		ptr = _files->next;
+		free(_files);
+		_files = (mias_file_t*) ptr;
+	}
+
+	_p11count = 0;
+	memset(_p11index, 0, sizeof(_p11index));
+	_p11complete = false;
+}
+
+/** C Accessors	***************************************************************/
+
+extern "C" MIAS* MIAS_create(void) {
+	return new MIAS();
+}
+
+extern "C" void MIAS_destroy(MIAS* mias) {
+	delete mias;
+}
+
+extern "C" bool MIAS_verify_pin(MIAS* mias, uint8_t* pin, uint16_t pin_len) {
+	return mias->verifyPin(pin, pin_len);
+}
+
+extern "C" bool MIAS_change_pin(MIAS* mias, uint8_t* old_pin, uint16_t old_pin_len, uint8_t* new_pin, uint16_t new_pin_len) {
+	return mias->changePin(old_pin, old_pin_len, new_pin, new_pin_len);
+}
+
+extern "C" bool MIAS_get_key_pair_by_container_id(MIAS* mias, uint8_t container_id, mias_key_pair_t** kp) {
+	return mias->getKeyPairByContainerId(container_id, kp);
+}
+
+extern "C" bool MIAS_get_certificate_by_container_id(MIAS* mias, uint8_t container_id, uint8_t** cert, uint16_t* cert_len) {
+	return mias->getCertificateByContainerId(container_id, cert, cert_len);
+}
+
+extern "C" bool MIAS_p11_get_object_by_label(MIAS* mias, uint8_t* label, uint16_t label_len, uint8_t** object, uint16_t* object_len) {
+	return mias->p11GetObjectByLabel(label, label_len, object, object_len);
+}
+		
+extern "C" bool MIAS_select_certificate_by_container_id(MIAS* mias, uint8_t container_id, uint16_t* size) {
+	return mias->selectCertificateByContainerId(container_id, size);
+}
+
+extern "C" bool MIAS_p11_select_object_by_label(MIAS* mias, uint8_t* label, uint16_t label_len, uint16_t* offset, uint16_t* size) {
+	return mias->p11SelectObjectByLabel(label, label_len, offset, size);
+}
+
+extern "C" bool MIAS_get_certificate_fingerprint(MIAS* mias, uint8_t container_id, uint16_t* size, uint32_t* fingerprint) {
+	return mias->getCertificateFingerprint(container_id, size, fingerprint);
+}
+
+extern "C" bool MIAS_p11_get_object_fingerprint(MIAS* mias, uint8_t* label, uint16_t label_len, uint16_t* size, uint32_t* fingerprint) {
+	return mias->p11GetObjectFingerprint(label, label_len, size, fingerprint);
+}
+
+extern "C" bool MIAS_hash_init(MIAS* mias, uint8_t algorithm) {
+	return mias->hashInit(algorithm);
+}
+
+extern "C" bool MIAS_hash_update(MIAS* mias, uint8_t* data, uint16_t data_len) {
+	return mias->hashUpdate(data, data_len);
+}
+
+extern "C" bool MIAS_hash_final(MIAS* mias, uint8_t* hash, uint16_t* hash_len) {
+	return mias->hashFinal(hash, hash_len);
+}
+
+extern "C" bool MIAS_sign_init(MIAS* mias, uint8_t algorithm, uint8_t key) {
+	return mias->signInit(algorithm, key);
+}
+
+extern "C" bool MIAS_sign_final(MIAS* mias, uint8_t* hash, uint16_t hash_len, uint8_t* signature, uint16_t* signature_len) {
+	return mias->signFinal(hash, hash_len, signature, signature_len);
+}
+
+extern "C" bool MIAS_decrypt_init(MIAS* mias, uint8_t algorithm, uint8_t key) {
+	return mias->decryptInit(algorithm, key);
+}
+
+extern "C" bool MIAS_decrypt_final(MIAS* mias, uint8_t* data, uint16_t data_len, uint8_t* plain, uint16_t* plain_len) {
+	return mias->decryptFinal(data, data_len, plain, plain_len);
+}
+
+extern "C" bool MIAS_load_cache(MIAS* mias, const char* path, uint8_t* iccid, uint16_t iccid_len) {
+	return mias->loadCache(path, iccid, iccid_len);
+}
+
+extern "C" bool MIAS_save_cache(MIAS* mias, const char* path, uint8_t* iccid, uint16_t iccid_len) {
+	return mias->saveCache(path, iccid, iccid_len);
+}
+
+extern "C" bool MIAS_is_cache_modified(MIAS* mias) {
+	return mias->isCacheModified();
+}
+
+extern "C" void MIAS_clear_cache(MIAS* mias) {
+	mias->clearCache();
+}
@@ -1,186 +1,1147 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *  
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#include "SEInterface.h"
-
-#ifdef APDU_DEBUG
-#include <stdio.h>
-#endif
-
-SEInterface::SEInterface(void) {
-	_apduLen = 0;
-	_apduResponseLen = 0;
-}
-
-SEInterface::~SEInterface(void) {
-}
-
-bool SEInterface::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2) {
-	_apdu[APDU_CLA_OFFSET] = cla;
-	_apdu[APDU_INS_OFFSET] = ins;
-	_apdu[APDU_P1_OFFSET] = p1;
-	_apdu[APDU_P2_OFFSET] = p2;
-	_apduLen = 4;
-	return transmit();
-}
-
-bool SEInterface::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le) {
-	_apdu[APDU_CLA_OFFSET] = cla;
-	_apdu[APDU_INS_OFFSET] = ins;
-	_apdu[APDU_P1_OFFSET] = p1;
-	_apdu[APDU_P2_OFFSET] = p2;
-	_apdu[APDU_LE_OFFSET] = le;
-	_apduLen = 5;
-	return transmit();
-}
-
-bool SEInterface::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen) {
-	_apdu[APDU_CLA_OFFSET] = cla;
-	_apdu[APDU_INS_OFFSET] = ins;
-	_apdu[APDU_P1_OFFSET] = p1;
-	_apdu[APDU_P2_OFFSET] = p2;
-	_apdu[APDU_LC_OFFSET] = dataLen;
-	memcpy(&_apdu[APDU_DATA_OFFSET], data, dataLen);
-	_apduLen = 5 + dataLen;	
-	return transmit();
-}
-
-bool SEInterface::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint8_t le) {
-	_apdu[APDU_CLA_OFFSET] = cla;
-	_apdu[APDU_INS_OFFSET] = ins;
-	_apdu[APDU_P1_OFFSET] = p1;
-	_apdu[APDU_P2_OFFSET] = p2;
-	_apdu[APDU_LC_OFFSET] = dataLen;
-	memcpy(&_apdu[APDU_DATA_OFFSET], data, dataLen);
-	_apdu[5 + dataLen] = le;
-	_apduLen = 5 + dataLen + 1;
-	return transmit();
-}
-
-bool SEInterface::transmit(void) {
-	#ifdef APDU_DEBUG
-	{
-	uint16_t i;
-	printf("APDU SND: ");
-	for(i=0; i<_apduLen; i++) {
-		printf("%02X", _apdu[i]);
-	}
-	printf("\n");
-	}
-	#endif
-	
-	if(transmitApdu(_apdu, _apduLen, _apduResponse, &_apduResponseLen) == false) {
-		return false;
-	}
-	
-	#ifdef APDU_DEBUG
-	{
-	uint16_t i;
-	printf("APDU RCV: ");
-	for(i=0; i<_apduResponseLen; i++) {
-		printf("%02X", _apduResponse[i]);
-	}
-	printf("\n");
-	}
-	#endif
-	
-	if((_apduResponseLen == 2) && (_apduResponse[0] == 0x6C)) {
-		_apdu[4] = _apduResponse[1];
-		return transmit();
-	}
-	
-	if((_apduResponseLen == 2) && (_apduResponse[0] == 0x61)) {
-		_apdu[0] = 0x00 | (_apdu[0] & 0x03);
-		_apdu[1] = 0xC0;
-		_apdu[2] = 0x00;
-		_apdu[3] = 0x00;
-		_apdu[4] = _apduResponse[1];
-		_apduLen = 5;
-		return transmit();
-	}
-	
-	return true;
-}
-
-uint16_t SEInterface::getStatusWord(void) {
-	uint16_t sw = 0;
-	
-	if(_apduResponseLen >= 2) {
-		sw = (_apduResponse[_apduResponseLen - 2] << 8) | _apduResponse[_apduResponseLen - 1];
-	}
-	
-	return sw;
-}
-
-uint16_t SEInterface::getResponse(uint8_t* data) {
-	uint16_t len = 0;
-	
-	if(_apduResponseLen > 2) {
-		len = _apduResponseLen - 2;
-		if(data) {
-			memcpy(data, _apduResponse, len);
-		}
-	}
-
-	return len;
-}
-
-uint16_t SEInterface::getResponseLength(void) {
-	uint16_t len = 0;
-	
-	if(_apduResponseLen > 2) {
-		len = _apduResponseLen - 2;
-	}
-
-	return len;	
-}
-
-/** C Accessors	***************************************************************/
-
-extern "C" bool SEInterface_transmit_case1(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2) {
-	return seiface->transmit(cla, ins, p1, p2);
-}
-
-extern "C" bool SEInterface_transmit_case2(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le) {
-	return seiface->transmit(cla, ins, p1, p2, le);
-}
-
-extern "C" bool SEInterface_transmit_case3(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len) {
-	return seiface->transmit(cla, ins, p1, p2, data, data_len);
-}
-
-extern "C" bool SEInterface_transmit_case4(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint8_t le) {
-	return seiface->transmit(cla, ins, p1, p2, data, data_len, le);
-}
-
-extern "C" uint16_t SEInterface_get_status_word(SEInterface* seiface) {
-	return seiface->getStatusWord();
-}
-
-extern "C" uint16_t SEInterface_get_response(SEInterface* seiface, uint8_t* data) {
-	return seiface->getResponse(data);
-}
-
-extern "C" uint16_t SEInterface_get_response_length(SEInterface* seiface) {
-	return seiface->getResponseLength();
-}
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#include "SEInterface.h"
+
+#include <stdlib.h>
+
+#ifdef __unix__
+#include <time.h>
+#endif
+
+#ifdef APDU_DEBUG
+#include <stdio.h>
+#endif
+
+#define SE_EXCHANGE_COMMAND            0
+#define SE_EXCHANGE_GET_RESPONSE       1
+#define SE_EXCHANGE_RESEND             2
+
+#ifdef SE_THREAD_SUPPORT
+// Deadline of a thread, listed by its SEInterface so that the deadlines of threads still
+// running are freed along with it.
+typedef struct se_thread_deadline_s {
+	se_deadline_t deadline;
+	SEInterface* seiface;
+	struct se_thread_deadline_s* prev;
+	struct se_thread_deadline_s* next;
+} se_thread_deadline_t;
+#endif
+
+SEInterface::SEInterface(void) {
+	_depth = 0;
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_init(&_mutex, NULL);
+	pthread_cond_init(&_cond, NULL);
+	memset(_waiting, 0, sizeof(_waiting));
+	memset(_tickets, 0, sizeof(_tickets));
+	memset(_serving, 0, sizeof(_serving));
+	#endif
+
+	_apduLen = 0;
+	_apduHasLe = false;
+	_apduResponseLen = 0;
+
+	_isExtended = false;
+	_maxCommandLength = SE_SHORT_MAX_DATA_LENGTH - 1;
+	_maxResponseLength = SE_SHORT_MAX_DATA_LENGTH;
+
+	#if SE_CHANNEL_POOL_SIZE > 0
+	memset(_channels, 0, sizeof(_channels));
+	_channelClock = 0;
+	#endif
+
+	_hook = NULL;
+	_hookCtx = NULL;
+	_stats = NULL;
+	_statsEnabled = false;
+
+	#ifdef SE_THREAD_SUPPORT
+	pthread_key_create(&_deadlineKey, freeDeadline);
+	_deadlines = NULL;
+	#else
+	memset(&_deadline, 0, sizeof(_deadline));
+	#endif
+}
+
+SEInterface::~SEInterface(void) {
+	#ifdef SE_THREAD_SUPPORT
+	se_thread_deadline_t* next;
+	#endif
+
+	if(_stats) {
+		free(_stats);
+	}
+
+	#ifdef SE_THREAD_SUPPORT
+	// Deleting the key runs no destructor, deadlines of threads still running are freed here
+	pthread_key_delete(_deadlineKey);
+	pthread_mutex_lock(&_mutex);
+	while(_deadlines != NULL) {
+		next = _deadlines->next;
+		free(_deadlines);
+		_deadlines = next;
+	}
+	pthread_mutex_unlock(&_mutex);
+	pthread_cond_destroy(&_cond);
+	pthread_mutex_destroy(&_mutex);
+	#endif
+}
+
+bool SEInterface::lock(void) {
+	return lock(SE_PRIORITY_NORMAL);
+}
+
+bool SEInterface::lock(uint8_t priority) {
+	#ifdef SE_THREAD_SUPPORT
+	uint32_t ticket;
+	uint8_t i;
+	bool wait;
+
+	if(priority >= SE_PRIORITY_LEVELS) {
+		priority = SE_PRIORITY_LEVELS - 1;
+	}
+
+	pthread_mutex_lock(&_mutex);
+
+	// Nested transaction
+	if(_depth && pthread_equal(_owner, pthread_self())) {
+		_depth++;
+		pthread_mutex_unlock(&_mutex);
+		return true;
+	}
+
+	// Waiters of the same priority are served in arrival order, after higher priority ones
+	ticket = _tickets[priority]++;
+	_waiting[priority]++;
+	do {
+		wait = _depth || (_serving[priority] != ticket);
+		for(i = priority + 1; !wait && (i < SE_PRIORITY_LEVELS); i++) {
+			wait = (_waiting[i] != 0);
+		}
+		if(wait) {
+			pthread_cond_wait(&_cond, &_mutex);
+		}
+	} while(wait);
+	_waiting[priority]--;
+	_serving[priority]++;
+
+	_owner = pthread_self();
+	_depth = 1;
+
+	pthread_mutex_unlock(&_mutex);
+	#else
+	(void) priority;
+
+	if(_depth++) {
+		return true;
+	}
+	#endif
+
+	return beginTransaction();
+}
+
+bool SEInterface::unlock(void) {
+	#ifdef SE_THREAD_SUPPORT
+	bool pending = false;
+	uint8_t i;
+
+	pthread_mutex_lock(&_mutex);
+
+	if((_depth == 0) || !pthread_equal(_owner, pthread_self())) {
+		pthread_mutex_unlock(&_mutex);
+		return false;
+	}
+
+	// Low layer transaction ends before the SE is handed over
+	if(_depth == 1) {
+		for(i = 0; i < SE_PRIORITY_LEVELS; i++) {
+			pending |= (_waiting[i] != 0);
+		}
+		pthread_mutex_unlock(&_mutex);
+		endTransaction(pending);
+		pthread_mutex_lock(&_mutex);
+	}
+
+	if(--_depth == 0) {
+		pthread_cond_broadcast(&_cond);
+	}
+
+	pthread_mutex_unlock(&_mutex);
+	#else
+	if(_depth == 0) {
+		return false;
+	}
+	if(_depth == 1) {
+		endTransaction(false);
+	}
+	_depth--;
+	#endif
+
+	return true;
+}
+
+bool SEInterface::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2) {
+	_apdu[APDU_CLA_OFFSET] = cla;
+	_apdu[APDU_INS_OFFSET] = ins;
+	_apdu[APDU_P1_OFFSET] = p1;
+	_apdu[APDU_P2_OFFSET] = p2;
+	_apduLen = 4;
+	_apduHasLe = false;
+	return transmit();
+}
+
+bool SEInterface::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le) {
+	_apdu[APDU_CLA_OFFSET] = cla;
+	_apdu[APDU_INS_OFFSET] = ins;
+	_apdu[APDU_P1_OFFSET] = p1;
+	_apdu[APDU_P2_OFFSET] = p2;
+	_apdu[APDU_LE_OFFSET] = le;
+	_apduLen = 5;
+	_apduHasLe = true;
+	return transmit();
+}
+
+bool SEInterface::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen) {
+	_apdu[APDU_CLA_OFFSET] = cla;
+	_apdu[APDU_INS_OFFSET] = ins;
+	_apdu[APDU_P1_OFFSET] = p1;
+	_apdu[APDU_P2_OFFSET] = p2;
+	_apdu[APDU_LC_OFFSET] = dataLen;
+	memcpy(&_apdu[APDU_DATA_OFFSET], data, dataLen);
+	_apduLen = 5 + dataLen;
+	_apduHasLe = false;
+	return transmit();
+}
+
+bool SEInterface::transmit(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint8_t le) {
+	_apdu[APDU_CLA_OFFSET] = cla;
+	_apdu[APDU_INS_OFFSET] = ins;
+	_apdu[APDU_P1_OFFSET] = p1;
+	_apdu[APDU_P2_OFFSET] = p2;
+	_apdu[APDU_LC_OFFSET] = dataLen;
+	memcpy(&_apdu[APDU_DATA_OFFSET], data, dataLen);
+	_apdu[5 + dataLen] = le;
+	_apduLen = 5 + dataLen + 1;
+	_apduHasLe = true;
+	return transmit();
+}
+
+bool SEInterface::transmitExtended(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint16_t ne) {
+	uint16_t len = sizeof(_apduResponse);
+
+	return transmitExtended(cla, ins, p1, p2, data, dataLen, ne, _apduResponse, &len);
+}
+
+bool SEInterface::transmitExtended(uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t dataLen, uint16_t ne, uint8_t* response, uint16_t* responseLen) {
+	uint16_t size = *responseLen;
+	bool ret;
+
+	*responseLen = 0;
+
+	if(size < 2) {
+		return false;
+	}
+
+	// Never request more than what response buffer can hold
+	if((ne + 2) > size) {
+		ne = size - 2;
+	}
+
+	_apdu[APDU_CLA_OFFSET] = cla;
+	_apdu[APDU_INS_OFFSET] = ins;
+	_apdu[APDU_P1_OFFSET] = p1;
+	_apdu[APDU_P2_OFFSET] = p2;
+	_apduLen = 4;
+	_apduHasLe = false;
+
+	// Short APDU
+	if((dataLen < SE_SHORT_MAX_DATA_LENGTH) && (ne <= SE_SHORT_MAX_DATA_LENGTH)) {
+		if(dataLen) {
+			_apdu[APDU_LC_OFFSET] = dataLen;
+			memcpy(&_apdu[APDU_DATA_OFFSET], data, dataLen);
+			_apduLen = APDU_DATA_OFFSET + dataLen;
+		}
+
+		if(ne) {
+			_apdu[_apduLen] = ne;
+			_apduLen++;
+			_apduHasLe = true;
+		}
+	}
+
+	// Short APDU with command chaining, last block is sent without chaining bit
+	else if(!_isExtended || (dataLen > _maxCommandLength) || (ne > _maxResponseLength)) {
+		if(ne > SE_SHORT_MAX_DATA_LENGTH) {
+			ne = SE_SHORT_MAX_DATA_LENGTH;
+		}
+
+		// Blocks are sent within a single transaction
+		lock();
+		while(dataLen >= SE_SHORT_MAX_DATA_LENGTH) {
+			if(!transmit(cla | 0x10, ins, p1, p2, data, SE_SHORT_MAX_DATA_LENGTH - 1)) {
+				unlock();
+				return false;
+			}
+
+			// Block rejected, its status word is returned
+			if(getStatusWord() != 0x9000) {
+				unlock();
+				return true;
+			}
+
+			data += SE_SHORT_MAX_DATA_LENGTH - 1;
+			dataLen -= SE_SHORT_MAX_DATA_LENGTH - 1;
+		}
+
+		*responseLen = size;
+		ret = transmitExtended(cla, ins, p1, p2, data, dataLen, ne, response, responseLen);
+		unlock();
+		return ret;
+	}
+
+	// Extended APDU
+	else {
+		_apdu[APDU_LC_OFFSET] = 0x00;
+		_apduLen = APDU_EXT_LC_OFFSET;
+
+		if(dataLen) {
+			_apdu[APDU_EXT_LC_OFFSET] = dataLen >> 8;
+			_apdu[APDU_EXT_LC_OFFSET + 1] = dataLen;
+			memcpy(&_apdu[APDU_EXT_DATA_OFFSET], data, dataLen);
+			_apduLen = APDU_EXT_DATA_OFFSET + dataLen;
+		}
+
+		if(ne) {
+			_apdu[_apduLen] = ne >> 8;
+			_apdu[_apduLen + 1] = ne;
+			_apduLen += 2;
+		}
+	}
+
+	return transmit(response, size, responseLen);
+}
+
+// Parse card capabilities (ISO 7816-4 compact-TLV tag 7 / BER-TLV tag 47).
+static bool hasExtendedLengthCapability(uint8_t* caps, uint16_t capsLen) {
+	return (capsLen >= 3) && (caps[2] & 0x40);
+}
+
+// Parse ATR historical bytes looking for card capabilities.
+static bool parseATR(uint8_t* atr, uint16_t atrLen) {
+	uint16_t i, k;
+	uint8_t y, t, l;
+
+	if(atrLen < 2) {
+		return false;
+	}
+
+	// Skip interface bytes
+	k = atr[1] & 0x0F;
+	y = atr[1] & 0xF0;
+	i = 2;
+	while(y) {
+		i += ((y >> 4) & 1) + ((y >> 5) & 1) + ((y >> 6) & 1);
+		if(y & 0x80) {
+			if(i >= atrLen) {
+				return false;
+			}
+			y = atr[i] & 0xF0;
+			i++;
+		}
+		else {
+			y = 0;
+		}
+	}
+
+	// Only category indicator 0x80 is made of compact-TLV objects only
+	if(((i + k) > atrLen) || (k == 0) || (atr[i] != 0x80)) {
+		return false;
+	}
+
+	for(k += i, i++; i < k; i += 1 + l) {
+		t = atr[i] >> 4;
+		l = atr[i] & 0x0F;
+
+		if((i + 1 + l) > k) {
+			break;
+		}
+
+		if(t == 0x07) {
+			return hasExtendedLengthCapability(&atr[i + 1], l);
+		}
+	}
+
+	return false;
+}
+
+// Parse EF.ATR BER-TLV content looking for card capabilities and extended length information.
+static bool parseEFATR(uint8_t* data, uint16_t dataLen, uint16_t* maxCommandLength, uint16_t* maxResponseLength) {
+	uint16_t i, j, k, t, l, v, end;
+	bool ret = false;
+
+	for(i = 0; i < dataLen; i += l) {
+		t = data[i++];
+		if((t & 0x1F) == 0x1F) {
+			if(i >= dataLen) {
+				break;
+			}
+			t = (t << 8) | data[i++];
+		}
+
+		if(i >= dataLen) {
+			break;
+		}
+		l = data[i++];
+		if(l == 0x81) {
+			l = data[i++];
+		}
+		else if(l == 0x82) {
+			l = (data[i] << 8) | data[i + 1];
+			i += 2;
+		}
+
+		if((i + l) > dataLen) {
+			break;
+		}
+
+		// Card capabilities
+		if(t == 0x47) {
+			ret = hasExtendedLengthCapability(&data[i], l);
+		}
+
+		// Extended length information: two INTEGERs, max Nc then max Ne
+		else if(t == 0x7F66) {
+			for(j = i, end = i + l; ((j + 2) <= end) && (data[j] == 0x02); j += 2 + data[j + 1]) {
+				if((j + 2 + data[j + 1]) > end) {
+					break;
+				}
+
+				for(v = 0, k = 0; k < data[j + 1]; k++) {
+					v = (v << 8) | data[j + 2 + k];
+				}
+
+				if(j == i) {
+					*maxCommandLength = v;
+				}
+				else {
+					*maxResponseLength = v;
+				}
+			}
+		}
+	}
+
+	return ret;
+}
+
+bool SEInterface::acquireChannel(const void* owner, uint8_t* channel, bool* reused) {
+	#if SE_CHANNEL_POOL_SIZE > 0
+	se_channel_t* entry = NULL;
+	uint8_t i;
+
+	*reused = false;
+
+	lock();
+
+	for(i = 0; i < SE_CHANNEL_POOL_SIZE; i++) {
+		if(_channels[i].channel && (_channels[i].owner == owner)) {
+			entry = &_channels[i];
+			*reused = true;
+			break;
+		}
+	}
+
+	if(entry == NULL) {
+		// Free entry first, least recently used idle channel otherwise
+		for(i = 0; i < SE_CHANNEL_POOL_SIZE; i++) {
+			if(_channels[i].channel == 0) {
+				entry = &_channels[i];
+				break;
+			}
+			if(!_channels[i].busy && ((entry == NULL) || (_channels[i].last_use < entry->last_use))) {
+				entry = &_channels[i];
+			}
+		}
+
+		if((entry != NULL) && (entry->channel == 0)) {
+			if(transmit(0x00, 0x70, 0x00, 0x00, 0x01) && (getStatusWord() == 0x9000) && (getResponseLength() == 1)) {
+				getResponse(&entry->channel);
+			}
+			if(entry->channel == 0) {
+				entry = NULL;
+			}
+		}
+	}
+
+	if(entry != NULL) {
+		entry->owner = owner;
+		entry->busy = true;
+		entry->last_use = ++_channelClock;
+		*channel = entry->channel;
+	}
+
+	unlock();
+
+	return (entry != NULL);
+	#else
+	(void) owner;
+	(void) channel;
+	*reused = false;
+	return false;
+	#endif
+}
+
+void SEInterface::releaseChannel(const void* owner) {
+	#if SE_CHANNEL_POOL_SIZE > 0
+	uint8_t i;
+
+	// Pool is changed under the lock, as acquireChannel may reassign an idle entry meanwhile
+	lock();
+	for(i = 0; i < SE_CHANNEL_POOL_SIZE; i++) {
+		if(_channels[i].channel && (_channels[i].owner == owner)) {
+			_channels[i].busy = false;
+		}
+	}
+	unlock();
+	#else
+	(void) owner;
+	#endif
+}
+
+void SEInterface::closeChannel(const void* owner) {
+	#if SE_CHANNEL_POOL_SIZE > 0
+	uint8_t i, channel;
+
+	lock();
+	for(i = 0; i < SE_CHANNEL_POOL_SIZE; i++) {
+		if(_channels[i].channel && (_channels[i].owner == owner)) {
+			channel = _channels[i].channel;
+			memset(&_channels[i], 0, sizeof(se_channel_t));
+			transmit(0x00, 0x70, 0x80, channel);
+		}
+	}
+	unlock();
+	#else
+	(void) owner;
+	#endif
+}
+
+void SEInterface::closeChannels(void) {
+	#if SE_CHANNEL_POOL_SIZE > 0
+	uint8_t i, channel;
+
+	lock();
+	for(i = 0; i < SE_CHANNEL_POOL_SIZE; i++) {
+		if(_channels[i].channel) {
+			channel = _channels[i].channel;
+			memset(&_channels[i], 0, sizeof(se_channel_t));
+			transmit(0x00, 0x70, 0x80, channel);
+		}
+	}
+	unlock();
+	#endif
+}
+
+void SEInterface::resetChannels(void) {
+	#if SE_CHANNEL_POOL_SIZE > 0
+	memset(_channels, 0, sizeof(_channels));
+	#endif
+}
+
+void SEInterface::forgetChannel(uint8_t channel) {
+	#if SE_CHANNEL_POOL_SIZE > 0
+	uint8_t i;
+
+	for(i = 0; channel && (i < SE_CHANNEL_POOL_SIZE); i++) {
+		if(_channels[i].channel == channel) {
+			memset(&_channels[i], 0, sizeof(se_channel_t));
+		}
+	}
+	#else
+	(void) channel;
+	#endif
+}
+
+bool SEInterface::detectExtendedLength(void) {
+	uint8_t buf[SE_SHORT_MAX_DATA_LENGTH];
+	uint8_t path[] = { 0x2F, 0x01 };
+	uint8_t channel;
+	uint16_t len;
+	uint16_t maxCommandLength, maxResponseLength;
+	uint16_t transportLength;
+
+	_isExtended = false;
+	_maxCommandLength = SE_SHORT_MAX_DATA_LENGTH - 1;
+	_maxResponseLength = SE_SHORT_MAX_DATA_LENGTH;
+
+	transportLength = getMaxTransportLength();
+	if(transportLength > SE_MAX_DATA_LENGTH) {
+		transportLength = SE_MAX_DATA_LENGTH;
+	}
+
+	// Nothing to gain
+	if(transportLength <= SE_SHORT_MAX_DATA_LENGTH) {
+		return false;
+	}
+
+	maxCommandLength = transportLength;
+	maxResponseLength = transportLength;
+
+	len = sizeof(buf);
+	if(getATR(buf, &len)) {
+		_isExtended = parseATR(buf, len);
+	}
+	else if(transmit(0x00, 0x70, 0x00, 0x00, 0x01) && (getStatusWord() == 0x9000) && (getResponse(&channel) == 1)) {
+		// Read EF.ATR on a logical channel, not to disturb basic channel current file
+		if(transmit(channel, 0xA4, 0x08, 0x04, path, sizeof(path), 0x00) && (getStatusWord() == 0x9000)) {
+			if(transmit(channel, 0xB0, 0x00, 0x00, 0x00) && (getStatusWord() == 0x9000)) {
+				len = getResponse(buf);
+				_isExtended = parseEFATR(buf, len, &maxCommandLength, &maxResponseLength);
+			}
+		}
+		transmit(0x00, 0x70, 0x80, channel);
+	}
+
+	if(_isExtended) {
+		_maxCommandLength = (maxCommandLength < transportLength) ? maxCommandLength : transportLength;
+		_maxResponseLength = (maxResponseLength < transportLength) ? maxResponseLength : transportLength;
+
+		if(_maxResponseLength <= SE_SHORT_MAX_DATA_LENGTH) {
+			_isExtended = false;
+			_maxCommandLength = SE_SHORT_MAX_DATA_LENGTH - 1;
+			_maxResponseLength = SE_SHORT_MAX_DATA_LENGTH;
+		}
+	}
+
+	return _isExtended;
+}
+
+bool SEInterface::isExtendedLength(void) {
+	return _isExtended;
+}
+
+uint16_t SEInterface::getMaxCommandLength(void) {
+	return _maxCommandLength;
+}
+
+uint16_t SEInterface::getMaxResponseLength(void) {
+	return _maxResponseLength;
+}
+
+bool SEInterface::transmit(void) {
+	uint16_t len;
+
+	return transmit(_apduResponse, sizeof(_apduResponse), &len);
+}
+
+bool SEInterface::transmit(uint8_t* response, uint16_t responseSize, uint16_t* responseLen) {
+	uint8_t sw1, sw2;
+	uint16_t len, le;
+	bool retried = false;
+	uint8_t ins = _apdu[APDU_INS_OFFSET];
+	uint8_t kind = SE_EXCHANGE_COMMAND;
+	uint32_t start = 0;
+	uint32_t timeout;
+	se_deadline_t* deadline = threadDeadline(false);
+	bool measure = _statsEnabled || (_hook != NULL);
+
+	*responseLen = 0;
+	_apduResponseLen = 0;
+
+	if(responseSize < 2) {
+		return false;
+	}
+
+	// Command and its GET RESPONSE or resend run within a single transaction
+	lock();
+
+	while(1) {
+		#ifdef APDU_DEBUG
+		{
+		uint16_t i;
+		printf("APDU SND: ");
+		for(i=0; i<_apduLen; i++) {
+			printf("%02X", _apdu[i]);
+		}
+		printf("\n");
+		}
+		#endif
+
+		// No exchange is started once the deadline expired, its response could not be waited for
+		timeout = getTimeLeft();
+		if(timeout == 0) {
+			deadline->timedOut = true;
+			unlock();
+			return false;
+		}
+
+		// Chunk is received right after the previous one, overwriting its status word
+		len = responseSize - *responseLen;
+		if(measure) {
+			start = getTimestamp();
+		}
+		if(transmitApdu(_apdu, _apduLen, &response[*responseLen], &len, timeout) == false) {
+			if(measure) {
+				record(ins, kind, NULL, 0, getTimestamp() - start, false);
+			}
+			if((timeout != SE_WAIT_FOREVER) && (getTimeLeft() == 0)) {
+				deadline->timedOut = true;
+			}
+			unlock();
+			return false;
+		}
+		if(measure) {
+			record(ins, kind, &response[*responseLen], len, getTimestamp() - start, true);
+		}
+
+		#ifdef APDU_DEBUG
+		{
+		uint16_t i;
+		printf("APDU RCV: ");
+		for(i=0; i<len; i++) {
+			printf("%02X", response[*responseLen + i]);
+		}
+		printf("\n");
+		}
+		#endif
+
+		if(len < 2) {
+			unlock();
+			return false;
+		}
+
+		sw1 = response[*responseLen + len - 2];
+		sw2 = response[*responseLen + len - 1];
+
+		// Channel is not open anymore (e.g. SE was reset), pool must not hand it out again
+		if((sw1 == 0x68) && (sw2 == 0x81)) {
+			forgetChannel(_apdu[APDU_CLA_OFFSET] & 0x03);
+		}
+
+		// Wrong Le on a short APDU, send it again once with the length given by the SE
+		if((len == 2) && (sw1 == 0x6C) && !retried && _apduHasLe) {
+			_apdu[_apduLen - 1] = sw2;
+			retried = true;
+			kind = SE_EXCHANGE_RESEND;
+			continue;
+		}
+
+		*responseLen += len - 2;
+
+		// More data available, as long as there is room left for it
+		if(sw1 == 0x61) {
+			le = sw2 ? sw2 : SE_SHORT_MAX_DATA_LENGTH;
+			if((*responseLen + le + 2) > responseSize) {
+				le = responseSize - *responseLen - 2;
+			}
+
+			if(le) {
+				_apdu[APDU_CLA_OFFSET] = 0x00 | (_apdu[APDU_CLA_OFFSET] & 0x03);
+				_apdu[APDU_INS_OFFSET] = 0xC0;
+				_apdu[APDU_P1_OFFSET] = 0x00;
+				_apdu[APDU_P2_OFFSET] = 0x00;
+				_apdu[APDU_LE_OFFSET] = le;
+				_apduLen = 5;
+				_apduHasLe = true;
+				retried = false;
+				kind = SE_EXCHANGE_GET_RESPONSE;
+				continue;
+			}
+		}
+
+		break;
+	}
+
+	// Status word is kept in internal buffer when response is assembled elsewhere
+	if(response != _apduResponse) {
+		_apduResponse[0] = response[*responseLen];
+		_apduResponse[1] = response[*responseLen + 1];
+		_apduResponseLen = 2;
+	}
+	else {
+		_apduResponseLen = *responseLen + 2;
+	}
+
+	unlock();
+	return true;
+}
+
+uint16_t SEInterface::getStatusWord(void) {
+	uint16_t sw = 0;
+	
+	if(_apduResponseLen >= 2) {
+		sw = (_apduResponse[_apduResponseLen - 2] << 8) | _apduResponse[_apduResponseLen - 1];
+	}
+	
+	return sw;
+}
+
+uint16_t SEInterface::getResponse(uint8_t* data) {
+	uint16_t len = 0;
+	
+	if(_apduResponseLen > 2) {
+		len = _apduResponseLen - 2;
+		if(data) {
+			memcpy(data, _apduResponse, len);
+		}
+	}
+
+	return len;
+}
+
+uint16_t SEInterface::getResponseLength(void) {
+	uint16_t len = 0;
+	
+	if(_apduResponseLen > 2) {
+		len = _apduResponseLen - 2;
+	}
+
+	return len;	
+}
+
+uint32_t SEInterface::getTimestamp(void) {
+	#ifdef __unix__
+	struct timespec ts;
+
+	if(clock_gettime(CLOCK_MONOTONIC, &ts) == 0) {
+		return (uint32_t) (ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+	}
+	#endif
+
+	return 0;
+}
+
+se_deadline_t* SEInterface::threadDeadline(bool create) {
+	#ifdef SE_THREAD_SUPPORT
+	se_thread_deadline_t* entry = (se_thread_deadline_t*) pthread_getspecific(_deadlineKey);
+
+	if((entry == NULL) && create) {
+		entry = (se_thread_deadline_t*) calloc(1, sizeof(se_thread_deadline_t));
+		if((entry != NULL) && (pthread_setspecific(_deadlineKey, entry) != 0)) {
+			free(entry);
+			entry = NULL;
+		}
+
+		if(entry != NULL) {
+			entry->seiface = this;
+			pthread_mutex_lock(&_mutex);
+			entry->next = _deadlines;
+			if(_deadlines != NULL) {
+				_deadlines->prev = entry;
+			}
+			_deadlines = entry;
+			pthread_mutex_unlock(&_mutex);
+		}
+	}
+
+	return (entry != NULL) ? &entry->deadline : NULL;
+	#else
+	(void) create;
+	return &_deadline;
+	#endif
+}
+
+#ifdef SE_THREAD_SUPPORT
+void SEInterface::freeDeadline(void* deadline) {
+	se_thread_deadline_t* entry = (se_thread_deadline_t*) deadline;
+	SEInterface* seiface = entry->seiface;
+
+	pthread_mutex_lock(&seiface->_mutex);
+	if(entry->prev != NULL) {
+		entry->prev->next = entry->next;
+	}
+	else {
+		seiface->_deadlines = entry->next;
+	}
+	if(entry->next != NULL) {
+		entry->next->prev = entry->prev;
+	}
+	pthread_mutex_unlock(&seiface->_mutex);
+
+	free(entry);
+}
+#endif
+
+void SEInterface::setDeadline(uint32_t timeout) {
+	se_deadline_t deadline;
+
+	// Time left is a signed 32-bit count of us, deadlines beyond about 35 minutes are not bounded
+	deadline.bounded = (timeout < (0x7FFFFFFF / 1000));
+	deadline.deadline = getTimestamp() + (timeout * 1000);
+	deadline.timedOut = false;
+	restoreDeadline(&deadline);
+}
+
+void SEInterface::saveDeadline(se_deadline_t* deadline) {
+	se_deadline_t* current = threadDeadline(false);
+
+	if(current != NULL) {
+		*deadline = *current;
+	}
+	else {
+		memset(deadline, 0, sizeof(se_deadline_t));
+	}
+}
+
+void SEInterface::restoreDeadline(const se_deadline_t* deadline) {
+	// A thread which never set a bound has none to remove
+	se_deadline_t* current = threadDeadline(deadline->bounded || deadline->timedOut);
+
+	if(current != NULL) {
+		*current = *deadline;
+	}
+}
+
+uint32_t SEInterface::getTimeLeft(void) {
+	se_deadline_t* deadline = threadDeadline(false);
+	int32_t remaining;
+
+	if((deadline == NULL) || !deadline->bounded) {
+		return SE_WAIT_FOREVER;
+	}
+
+	remaining = (int32_t) (deadline->deadline - getTimestamp());
+	return (remaining > 0) ? (remaining / 1000) : 0;
+}
+
+bool SEInterface::isTimedOut(void) {
+	se_deadline_t* deadline = threadDeadline(false);
+
+	return (deadline != NULL) && deadline->timedOut;
+}
+
+void SEInterface::setApduHook(se_apdu_hook_t hook, void* ctx) {
+	_hook = hook;
+	_hookCtx = ctx;
+}
+
+bool SEInterface::enableStats(bool enable) {
+	if(enable && (_stats == NULL)) {
+		_stats = (se_stats_t*) calloc(1, sizeof(se_stats_t));
+	}
+
+	_statsEnabled = enable && (_stats != NULL);
+
+	return _statsEnabled;
+}
+
+const se_stats_t* SEInterface::getStats(void) {
+	return _stats;
+}
+
+const se_ins_stats_t* SEInterface::getStats(uint8_t ins) {
+	uint16_t i;
+
+	if(_stats) {
+		for(i=0; i<_stats->count; i++) {
+			if(_stats->ins[i].ins == ins) {
+				return &_stats->ins[i];
+			}
+		}
+	}
+
+	return NULL;
+}
+
+void SEInterface::resetStats(void) {
+	if(_stats) {
+		memset(_stats, 0, sizeof(se_stats_t));
+	}
+}
+
+static void updateStats(se_ins_stats_t* stats, uint8_t kind, uint16_t sent, uint16_t received, uint32_t latency, bool success) {
+	uint8_t bucket;
+
+	if(kind == SE_EXCHANGE_COMMAND) {
+		stats->commands++;
+	}
+	else if(kind == SE_EXCHANGE_GET_RESPONSE) {
+		stats->retries_61xx++;
+	}
+	else {
+		stats->retries_6cxx++;
+	}
+
+	stats->exchanges++;
+	if(!success) {
+		stats->errors++;
+	}
+
+	stats->bytes_sent += sent;
+	stats->bytes_received += received;
+
+	stats->latency_total_us += latency;
+	if(latency > stats->latency_max_us) {
+		stats->latency_max_us = latency;
+	}
+
+	for(bucket=0; (bucket < (SE_STATS_LATENCY_BUCKETS - 1)) && (latency >= (1000UL << bucket)); bucket++);
+	stats->latency_histogram[bucket]++;
+}
+
+void SEInterface::record(uint8_t ins, uint8_t kind, uint8_t* response, uint16_t responseLen, uint32_t latency, bool success) {
+	se_ins_stats_t* stats;
+	se_apdu_event_t event;
+
+	if(_statsEnabled) {
+		updateStats(&_stats->total, kind, _apduLen, responseLen, latency, success);
+
+		stats = (se_ins_stats_t*) getStats(ins);
+		if((stats == NULL) && (_stats->count < SE_STATS_MAX_INS)) {
+			stats = &_stats->ins[_stats->count++];
+			stats->ins = ins;
+		}
+
+		if(stats) {
+			updateStats(stats, kind, _apduLen, responseLen, latency, success);
+		}
+		else if(kind == SE_EXCHANGE_COMMAND) {
+			_stats->untracked++;
+		}
+	}
+
+	if(_hook) {
+		event.ins = ins;
+		event.apdu = _apdu;
+		event.apdu_len = _apduLen;
+		event.response = response;
+		event.response_len = responseLen;
+		event.latency_us = latency;
+		event.success = success;
+		_hook(_hookCtx, &event);
+	}
+}
+
+/** C Accessors	***************************************************************/
+
+extern "C" bool SEInterface_lock(SEInterface* seiface) {
+	return seiface->lock();
+}
+
+extern "C" bool SEInterface_lock_priority(SEInterface* seiface, uint8_t priority) {
+	return seiface->lock(priority);
+}
+
+extern "C" bool SEInterface_unlock(SEInterface* seiface) {
+	return seiface->unlock();
+}
+
+extern "C" void SEInterface_close_channels(SEInterface* seiface) {
+	seiface->closeChannels();
+}
+
+extern "C" void SEInterface_reset_channels(SEInterface* seiface) {
+	seiface->resetChannels();
+}
+
+extern "C" bool SEInterface_transmit_case1(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2) {
+	return seiface->transmit(cla, ins, p1, p2);
+}
+
+extern "C" bool SEInterface_transmit_case2(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t le) {
+	return seiface->transmit(cla, ins, p1, p2, le);
+}
+
+extern "C" bool SEInterface_transmit_case3(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len) {
+	return seiface->transmit(cla, ins, p1, p2, data, data_len);
+}
+
+extern "C" bool SEInterface_transmit_case4(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint8_t le) {
+	return seiface->transmit(cla, ins, p1, p2, data, data_len, le);
+}
+
+extern "C" bool SEInterface_transmit_extended(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint16_t ne) {
+	return seiface->transmitExtended(cla, ins, p1, p2, data, data_len, ne);
+}
+
+extern "C" bool SEInterface_transmit_extended_to(SEInterface* seiface, uint8_t cla, uint8_t ins, uint8_t p1, uint8_t p2, uint8_t* data, uint16_t data_len, uint16_t ne, uint8_t* response, uint16_t* response_len) {
+	return seiface->transmitExtended(cla, ins, p1, p2, data, data_len, ne, response, response_len);
+}
+
+extern "C" bool SEInterface_detect_extended_length(SEInterface* seiface) {
+	return seiface->detectExtendedLength();
+}
+
+extern "C" bool SEInterface_is_extended_length(SEInterface* seiface) {
+	return seiface->isExtendedLength();
+}
+
+extern "C" uint16_t SEInterface_get_max_command_length(SEInterface* seiface) {
+	return seiface->getMaxCommandLength();
+}
+
+extern "C" uint16_t SEInterface_get_max_response_length(SEInterface* seiface) {
+	return seiface->getMaxResponseLength();
+}
+
+extern "C" uint16_t SEInterface_get_status_word(SEInterface* seiface) {
+	return seiface->getStatusWord();
+}
+
+extern "C" uint16_t SEInterface_get_response(SEInterface* seiface, uint8_t* data) {
+	return seiface->getResponse(data);
+}
+
+extern "C" uint16_t SEInterface_get_response_length(SEInterface* seiface) {
+	return seiface->getResponseLength();
+}
+
+extern "C" void SEInterface_set_apdu_hook(SEInterface* seiface, se_apdu_hook_t hook, void* ctx) {
+	seiface->setApduHook(hook, ctx);
+}
+
+extern "C" bool SEInterface_enable_stats(SEInterface* seiface, bool enable) {
+	return seiface->enableStats(enable);
+}
+
+extern "C" const se_stats_t* SEInterface_get_stats(SEInterface* seiface) {
+	return seiface->getStats();
+}
+
+extern "C" const se_ins_stats_t* SEInterface_get_ins_stats(SEInterface* seiface, uint8_t ins) {
+	return seiface->getStats(ins);
+}
+
+extern "C" void SEInterface_reset_stats(SEInterface* seiface) {
+	seiface->resetStats();
+}
+
+extern "C" void SEInterface_set_deadline(SEInterface* seiface, uint32_t timeout) {
+	seiface->setDeadline(timeout);
+}
+
+extern "C" void SEInterface_save_deadline(SEInterface* seiface, se_deadline_t* deadline) {
+	seiface->saveDeadline(deadline);
+}
+
+extern "C" void SEInterface_restore_deadline(SEInterface* seiface, const se_deadline_t* deadline) {
+	seiface->restoreDeadline(deadline);
+}
+
+extern "C" uint32_t SEInterface_get_time_left(SEInterface* seiface) {
+	return seiface->getTimeLeft();
+}
+
+extern "C" bool SEInterface_is_timed_out(SEInterface* seiface) {
+	return seiface->isTimedOut();
+}
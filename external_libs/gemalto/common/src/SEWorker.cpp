@@ -0,0 +1,245 @@
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#include "SEWorker.h"
+
+SEWorker::SEWorker(void) {
+	_se = NULL;
+	_queue = NULL;
+	_running = false;
+
+	#ifdef SE_THREAD_SUPPORT
+	_calling = NULL;
+	pthread_mutex_init(&_mutex, NULL);
+	pthread_cond_init(&_cond, NULL);
+	#endif
+}
+
+SEWorker::~SEWorker(void) {
+	stop();
+
+	#ifdef SE_THREAD_SUPPORT
+	pthread_cond_destroy(&_cond);
+	pthread_mutex_destroy(&_mutex);
+	#endif
+}
+
+bool SEWorker::start(SEInterface* se) {
+	if(_running) {
+		return true;
+	}
+
+	_se = se;
+	_running = true;
+
+	#ifdef SE_THREAD_SUPPORT
+	if(pthread_create(&_thread, NULL, serve, this) != 0) {
+		_running = false;
+	}
+	#endif
+
+	return _running;
+}
+
+void SEWorker::stop(void) {
+	if(!_running) {
+		return;
+	}
+
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_lock(&_mutex);
+	_running = false;
+	pthread_cond_broadcast(&_cond);
+	pthread_mutex_unlock(&_mutex);
+
+	pthread_join(_thread, NULL);
+	#else
+	_running = false;
+	#endif
+}
+
+bool SEWorker::submit(se_job_t* job) {
+	#ifdef SE_THREAD_SUPPORT
+	se_job_t** pjob;
+
+	pthread_mutex_lock(&_mutex);
+
+	if(!_running) {
+		pthread_mutex_unlock(&_mutex);
+		return false;
+	}
+
+	if(job->priority >= SE_PRIORITY_LEVELS) {
+		job->priority = SE_PRIORITY_LEVELS - 1;
+	}
+	job->state = SE_JOB_PENDING;
+	job->result = false;
+	_se->saveDeadline(&job->deadline);
+
+	// After queued jobs of the same or a higher priority
+	for(pjob = &_queue; (*pjob != NULL) && ((*pjob)->priority >= job->priority); pjob = &(*pjob)->next);
+	job->next = *pjob;
+	*pjob = job;
+
+	pthread_cond_broadcast(&_cond);
+	pthread_mutex_unlock(&_mutex);
+	#else
+	if(!_running) {
+		return false;
+	}
+
+	job->state = SE_JOB_RUNNING;
+	job->next = NULL;
+	_se->saveDeadline(&job->deadline);
+	execute(job);
+	job->state = SE_JOB_DONE;
+
+	// Job is not touched after its completion callback, which may free or resubmit it
+	if(job->done != NULL) {
+		job->done(job->ctx, job->result);
+	}
+	#endif
+
+	return true;
+}
+
+bool SEWorker::isDone(se_job_t* job) {
+	bool done;
+
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_lock(&_mutex);
+	done = (job->state == SE_JOB_DONE) && (_calling != job);
+	pthread_mutex_unlock(&_mutex);
+	#else
+	done = (job->state == SE_JOB_DONE);
+	#endif
+
+	return done;
+}
+
+bool SEWorker::wait(se_job_t* job) {
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_lock(&_mutex);
+	while((job->state != SE_JOB_DONE) || (_calling == job)) {
+		pthread_cond_wait(&_cond, &_mutex);
+	}
+	pthread_mutex_unlock(&_mutex);
+	#endif
+
+	return job->result;
+}
+
+void SEWorker::execute(se_job_t* job) {
+	se_deadline_t deadline;
+
+	// Job runs under the deadline of its submitter, not the one of the previous job
+	_se->saveDeadline(&deadline);
+	_se->restoreDeadline(&job->deadline);
+	_se->lock(job->priority);
+	job->result = job->run(job->ctx);
+	_se->unlock();
+	_se->restoreDeadline(&deadline);
+}
+
+#ifdef SE_THREAD_SUPPORT
+void* SEWorker::serve(void* arg) {
+	SEWorker* worker = (SEWorker*) arg;
+	se_job_t* job;
+	se_job_done_t done;
+	void* ctx;
+	bool result;
+
+	pthread_mutex_lock(&worker->_mutex);
+
+	for(;;) {
+		while((worker->_queue == NULL) && worker->_running) {
+			pthread_cond_wait(&worker->_cond, &worker->_mutex);
+		}
+
+		// Stopped, queued jobs are all done
+		if(worker->_queue == NULL) {
+			break;
+		}
+
+		job = worker->_queue;
+		worker->_queue = job->next;
+		job->state = SE_JOB_RUNNING;
+
+		pthread_mutex_unlock(&worker->_mutex);
+		worker->execute(job);
+		pthread_mutex_lock(&worker->_mutex);
+
+		job->state = SE_JOB_DONE;
+		if(job->done == NULL) {
+			pthread_cond_broadcast(&worker->_cond);
+			continue;
+		}
+
+		// Job is not touched after its completion callback, which may free or resubmit it,
+		// waiters of the job are held until the callback returned
+		done = job->done;
+		ctx = job->ctx;
+		result = job->result;
+		worker->_calling = job;
+
+		pthread_mutex_unlock(&worker->_mutex);
+		done(ctx, result);
+		pthread_mutex_lock(&worker->_mutex);
+
+		worker->_calling = NULL;
+		pthread_cond_broadcast(&worker->_cond);
+	}
+
+	pthread_mutex_unlock(&worker->_mutex);
+
+	return NULL;
+}
+#endif
+
+extern "C" SEWorker* SEWorker_create(void) {
+	return new SEWorker();
+}
+
+extern "C" void SEWorker_destroy(SEWorker* worker) {
+	delete worker;
+}
+
+extern "C" bool SEWorker_start(SEWorker* worker, SEInterface* se) {
+	return worker->start(se);
+}
+
+extern "C" void SEWorker_stop(SEWorker* worker) {
+	worker->stop();
+}
+
+extern "C" bool SEWorker_submit(SEWorker* worker, se_job_t* job) {
+	return worker->submit(job);
+}
+
+extern "C" bool SEWorker_is_done(SEWorker* worker, se_job_t* job) {
+	return worker->isDone(job);
+}
+
+extern "C" bool SEWorker_wait(SEWorker* worker, se_job_t* job) {
+	return worker->wait(job);
+}
@@ -1,51 +1,199 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *  
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#ifndef __MBEDTLS_SE_H__
-#define __MBEDTLS_SE_H__
-
-#include "SEInterface.h"
-
-#include "mbedtls/pk.h"
-#include "mbedtls/x509_crt.h"
-
-#define MBEDTLS_ERR_SE_MIAS_SELECT_ERROR                  -0x5280  /**< Selecting mobile IAS applet failed. */
-#define MBEDTLS_ERR_SE_MIAS_VERIFY_PIN_ERROR              -0x5300  /**< Verifying pin on mobile IAS applet failed. */
-#define MBEDTLS_ERR_SE_MIAS_IO_ERROR                      -0x5380  /**< Transmitting apdu to mobile IAS applet failed. */
-#define MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR             -0x5400  /**< Mobile IAS read object failed. */
-#define MBEDTLS_ERR_SE_EF_VERIFY_PIN_ERROR                -0x5480  /**< Verifying pin to access EF failed. */
-#define MBEDTLS_ERR_SE_EF_INVALID_NAME_ERROR              -0x5500  /**< Trying to access an EF with an invalid name. */
-#define MBEDTLS_ERR_SE_EF_READ_OBJECT_ERROR               -0x5580  /**< EF read object failed. */
-#define MBEDTLS_ERR_SE_BAD_KEY_NAME_ERROR                 -0x5600  /**< No matching key found with the given name. */
-
-
-#define MBEDTLS_SE_EF_KEY_NAME_PREFIX       "SE://EF/"
-#define MBEDTLS_SE_MIAS_KEY_NAME_PREFIX     "SE://MIAS/"
-#define MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX "SE://MIAS_P11/"
-
-int mbedtls_se_init(SEInterface* se_iface);
-
-int mbedtls_x509_crt_parse_se(mbedtls_x509_crt* cert, char* path, char* pin);
-int mbedtls_pk_parse_se(mbedtls_pk_context* pk, char* path, char* pin);
-
-#endif /* __MBEDTLS_SE_H__ */
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __MBEDTLS_SE_H__
+#define __MBEDTLS_SE_H__
+
+#include "MF.h"
+#include "MIAS.h"
+#include "SEInterface.h"
+#include "SEWorker.h"
+
+#include "mbedtls/md.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/x509_crt.h"
+
+#define MBEDTLS_ERR_SE_MIAS_SELECT_ERROR                  -0x5280  /**< Selecting mobile IAS applet failed. */
+#define MBEDTLS_ERR_SE_MIAS_VERIFY_PIN_ERROR              -0x5300  /**< Verifying pin on mobile IAS applet failed. */
+#define MBEDTLS_ERR_SE_MIAS_IO_ERROR                      -0x5380  /**< Transmitting apdu to mobile IAS applet failed. */
+#define MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR             -0x5400  /**< Mobile IAS read object failed. */
+#define MBEDTLS_ERR_SE_EF_VERIFY_PIN_ERROR                -0x5480  /**< Verifying pin to access EF failed. */
+#define MBEDTLS_ERR_SE_EF_INVALID_NAME_ERROR              -0x5500  /**< Trying to access an EF with an invalid name. */
+#define MBEDTLS_ERR_SE_EF_READ_OBJECT_ERROR               -0x5580  /**< EF read object failed. */
+#define MBEDTLS_ERR_SE_BAD_KEY_NAME_ERROR                 -0x5600  /**< No matching key found with the given name. */
+#define MBEDTLS_ERR_SE_CACHE_MISS_ERROR                   -0x5680  /**< No valid metadata snapshot found for the card. */
+#define MBEDTLS_ERR_SE_WORKER_ERROR                       -0x5700  /**< SE worker is not running. */
+#define MBEDTLS_ERR_SE_TIMEOUT_ERROR                      -0x5780  /**< Deadline set with mbedtls_se_set_timeout expired. */
+
+
+// One secure element: its applets, MIAS session, metadata and certificate caches, and worker.
+// Operations on a context are serialized by the lock of its SEInterface, several contexts can be
+// used in parallel from different threads (e.g. a gateway with several modems).
+// Keys and certificates parsed with a context use it until they are freed.
+typedef struct mbedtls_se_context {
+	SEInterface* iface;
+	MF* mf;
+	MIAS* mias;
+	SEWorker* worker;
+
+	char* mias_session_pin;                     // Open MIAS session, NULL if none
+	char* cache_path;                           // Metadata snapshot, NULL if disabled
+	uint8_t iccid[MF_ICCID_LENGTH];
+	uint16_t iccid_len;
+	struct mbedtls_se_crt_cache_s* crt_cache;
+	struct mias_key_s* rsa_keys;                // Not owned by their PK contexts
+
+	se_job_t prepare_job;                       // Single preparation queued at a time
+	void* prepare_key;
+	char prepare_alg;
+	bool prepare_queued;
+} mbedtls_se_context;
+
+#define MBEDTLS_SE_HASH_ON_HOST 0 // Digest computed by mbedTLS, only the final value is sent to MIAS
+#define MBEDTLS_SE_HASH_ON_CARD 1 // Data streamed to MIAS by PSO HASH blocks, for policies requiring on-card hashing
+
+#define MBEDTLS_SE_HASH_MAX_BLOCK_SIZE 128
+
+typedef struct {
+	int mode;
+	mbedtls_md_type_t md_alg;
+	mbedtls_md_context_t md;                                // MBEDTLS_SE_HASH_ON_HOST only
+	unsigned char block[MBEDTLS_SE_HASH_MAX_BLOCK_SIZE];    // MBEDTLS_SE_HASH_ON_CARD only, pending bytes of an incomplete block
+	size_t block_len;
+	size_t block_size;
+	mbedtls_se_context* se;                                 // MBEDTLS_SE_HASH_ON_CARD only
+	bool started;
+	bool deselect;                                          // MIAS was selected for hashing and has to be deselected
+} mbedtls_se_hash_context;
+
+// Asynchronous signature, owned by the caller until it is done.
+typedef struct {
+	se_job_t job;
+	mbedtls_se_context* se;
+	mbedtls_pk_context* pk;
+	mbedtls_md_type_t md_alg;
+	const unsigned char* hash;
+	size_t hash_len;
+	unsigned char* sig;
+	size_t* sig_len;
+	int ret;
+	void (*done)(void* ctx, int ret);
+	void* ctx;
+} mbedtls_se_async_t;
+
+#define MBEDTLS_SE_EF_KEY_NAME_PREFIX       "SE://EF/"
+#define MBEDTLS_SE_MIAS_KEY_NAME_PREFIX     "SE://MIAS/"
+#define MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX "SE://MIAS_P11/"
+
+// Set up a context on the SE reached through se_iface, which must stay valid until mbedtls_se_free.
+int mbedtls_se_init(mbedtls_se_context* se, SEInterface* se_iface);
+
+// Stop the worker once queued operations are done, close the MIAS session and release the context.
+// Keys must not be used anymore, certificates from mbedtls_x509_crt_get_se must be released before.
+void mbedtls_se_free(mbedtls_se_context* se);
+
+// Enable persistent MIAS metadata cache (key pairs, file directory, P11 objects location).
+// Snapshot stored at path is loaded if it matches the card, and is rewritten each time
+// new metadata is read from the card. Must be called after mbedtls_se_init.
+int mbedtls_se_init_cache(mbedtls_se_context* se, const char* path);
+
+// Parse certificates stored on the SE at path and add them to the cert chain.
+// Path may list several SE paths separated by ';' (e.g. client certificate then intermediates),
+// and each of them may hold several DER certificates one after the other. Compressed MIAS
+// certificates (01 00 header followed by a zlib stream) are inflated while they are read.
+// Certificates are read one at a time in a buffer of their own size, and are kept in a cache:
+// they are only read again from the SE in case the size of an EF or the fingerprint of the
+// DER extent and last bytes of its certificates changed.
+int mbedtls_x509_crt_parse_se(mbedtls_se_context* se, mbedtls_x509_crt* cert, char* path, char* pin);
+
+// Same as mbedtls_x509_crt_parse_se, but returns the parsed certificate held from the cache,
+// so nothing is parsed again as long as the certificate did not change on the SE.
+// Cert must not be freed by the caller, it stays valid until released by mbedtls_x509_crt_release_se,
+// even if the cache parses it again or drops it meanwhile.
+int mbedtls_x509_crt_get_se(mbedtls_se_context* se, mbedtls_x509_crt** cert, char* path, char* pin);
+
+// Release a certificate from mbedtls_x509_crt_get_se, NULL is ignored.
+void mbedtls_x509_crt_release_se(mbedtls_se_context* se, mbedtls_x509_crt* cert);
+
+// Drop all certificates kept in cache.
+void mbedtls_se_clear_crt_cache(mbedtls_se_context* se);
+
+int mbedtls_pk_parse_se(mbedtls_se_context* se, mbedtls_pk_context* pk, char* path, char* pin);
+
+// Close the MIAS session kept open between private key operations: MIAS stays selected and its
+// PIN verified after a signature or a decryption, so that the next one only costs MSE SET and PSO.
+void mbedtls_se_close_session(mbedtls_se_context* se);
+
+// Bound the SE exchanges of the calling thread on the context to timeout_ms from now, e.g. the TLS
+// handshake timeout, 0 to remove the bound. Once it expired, operations fail with
+// MBEDTLS_ERR_SE_TIMEOUT_ERROR. Asynchronous operations are bounded by the submitting thread.
+void mbedtls_se_set_timeout(mbedtls_se_context* se, uint32_t timeout_ms);
+
+// Save the bound of the calling thread, to restore it with mbedtls_se_restore_timeout once the
+// operation bounded by mbedtls_se_set_timeout is done.
+void mbedtls_se_save_timeout(mbedtls_se_context* se, se_deadline_t* saved);
+void mbedtls_se_restore_timeout(mbedtls_se_context* se, const se_deadline_t* saved);
+
+// Start the SE worker thread running asynchronous operations, so that the calling thread keeps
+// running while the card computes. Must be called after mbedtls_se_init.
+int mbedtls_se_start_worker(mbedtls_se_context* se);
+
+// Stop the SE worker thread once queued operations are done.
+void mbedtls_se_stop_worker(mbedtls_se_context* se);
+
+// Queue a signature with a key from mbedtls_pk_parse_se, run by the SE worker ahead of background
+// reads. Hash and sig must stay valid until the signature is done. Done callback (may be NULL) is
+// called from the worker thread with the mbedtls_pk_sign result.
+int mbedtls_pk_sign_se_async(mbedtls_se_async_t* req, mbedtls_pk_context* pk, mbedtls_md_type_t md_alg, const unsigned char* hash, size_t hash_len, unsigned char* sig, size_t* sig_len, void (*done)(void* ctx, int ret), void* ctx);
+
+// Returns true in case the asynchronous operation is done, false otherwise.
+bool mbedtls_se_async_is_done(mbedtls_se_async_t* req);
+
+// Wait for the asynchronous operation to be done, and returns its result.
+int mbedtls_se_async_wait(mbedtls_se_async_t* req);
+
+// Get the card ready to sign with a key from mbedtls_pk_parse_se: MIAS selected, PIN verified and
+// security environment set for md_alg, so that the next signature with the same digest only sends
+// the hash and PSO COMPUTE DIGITAL SIGNATURE. Queued on the SE worker when started, so that the
+// card works while the caller waits for the network (e.g. TLS server flight); pk must then stay
+// valid until the signature. Run synchronously otherwise.
+int mbedtls_pk_prepare_se(mbedtls_pk_context* pk, mbedtls_md_type_t md_alg);
+
+// Streaming hash, either computed on the host (one APDU less per block) or on the card.
+// Both modes produce the same digest, so callers can switch between them to compare costs.
+// SE context is only used in MBEDTLS_SE_HASH_ON_CARD mode (may be NULL otherwise). It is then locked
+// from mbedtls_se_hash_starts until mbedtls_se_hash_finish or mbedtls_se_hash_free, which must be
+// called from the same thread.
+void mbedtls_se_hash_init(mbedtls_se_hash_context* ctx);
+int mbedtls_se_hash_starts(mbedtls_se_hash_context* ctx, mbedtls_se_context* se, mbedtls_md_type_t md_alg, int mode);
+int mbedtls_se_hash_update(mbedtls_se_hash_context* ctx, const unsigned char* input, size_t ilen);
+
+// Output parameter must have room for the digest size of md_alg.
+int mbedtls_se_hash_finish(mbedtls_se_hash_context* ctx, unsigned char* output);
+
+// Finish hashing and sign the digest with a key from mbedtls_pk_parse_se: the card only
+// receives the final hash value, whatever the hashing mode.
+int mbedtls_se_hash_sign(mbedtls_se_hash_context* ctx, mbedtls_pk_context* pk, unsigned char* sig, size_t* sig_len, int (*f_rng)(void*, unsigned char*, size_t), void* p_rng);
+void mbedtls_se_hash_free(mbedtls_se_hash_context* ctx);
+
+#endif /* __MBEDTLS_SE_H__ */
@@ -1,495 +1,1890 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *  
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-
-#include "MF.h"
-#include "MIAS.h"
-
-#include "mbedtls_se.h"
-
-#include "mbedtls/md.h"
-
-static MF* _mf;
-static MIAS* _mias;
-
-#define USE_BASIC_CHANNEL false
-
-typedef struct {
-	char*  pin;
-	mias_key_pair_t* kp;
-} mias_key_t;
-
-static void hex_string_2_bytes_array(uint8_t* hexstr, uint16_t hexstrLen, uint8_t* bytes, uint16_t* bytesLen) {
-	uint8_t d;
-	uint16_t i, j;
-
-	*bytesLen = 0;
-	for(i = 0; i < hexstrLen; *bytesLen += 1) {
-		d = 0;
-		for(j = i + 2; i < j; i++) {
-			d <<= 4;
-			if((hexstr[i] >= '0') && (hexstr[i] <= '9')) {
-				d |= hexstr[i] - '0';
-			}
-			else if((hexstr[i] >= 'a') && (hexstr[i] <= 'f')) {
-				d |= hexstr[i] - 'a' + 10;
-			}
-			else if((hexstr[i] >= 'A') && (hexstr[i] <= 'F')) {
-				d |= hexstr[i] - 'A' + 10;
-			}
-		}
-		*bytes = d;
-		bytes++;
-	}
-}
-
-static int mbedtls_se_read_ef(uint8_t* efname, uint16_t efnamelen, char** data, int* data_size, char* pin) {
-	int ret;
-	uint16_t size;
-	
-	*data_size = -1;
-	
-	#ifdef __cplusplus
-	if(_mf->select(USE_BASIC_CHANNEL)) {
-		if(_mf->verifyPin((uint8_t*) pin, strlen(pin))) {
-			if(_mf->readEF(efname, efnamelen, (uint8_t**) data, &size)) {
-				*data_size = size & 0x0000FFFF;
-				ret = 0;
-			}
-			else {
-				ret = MBEDTLS_ERR_SE_EF_READ_OBJECT_ERROR;
-			}
-		}
-		else {
-			ret = MBEDTLS_ERR_SE_EF_VERIFY_PIN_ERROR;
-		}
-	}
-	_mf->deselect();
-	#else
-	if(Applet_select((Applet*) _mf, USE_BASIC_CHANNEL)) {
-		if(MF_verify_pin(_mf, (uint8_t*) pin, strlen(pin))) {
-			if(MF_read_ef(_mf, efname, efnamelen, (uint8_t**) data, &size)) {
-				*data_size = size & 0x0000FFFF;
-				ret = 0;
-			}
-			else {
-				ret = MBEDTLS_ERR_SE_EF_READ_OBJECT_ERROR;
-			}
-		}
-		else {
-			ret = MBEDTLS_ERR_SE_EF_VERIFY_PIN_ERROR;
-		}
-	}
-	Applet_deselect((Applet*) _mf);	
-	#endif
-	
-	return ret;
-}
-
-static int mbedtls_se_read_object(char* path, char** obj, int* size, char* pin) {
-	int ret;
-	uint8_t* efname;
-	uint16_t efname_len;
-		
-	// Name is expected to be of even size (hex string name)
-	if(strlen(path) & 1) {
-		return MBEDTLS_ERR_SE_EF_INVALID_NAME_ERROR;
-	}
-	
-	efname_len = (strlen(path) / 2);
-	efname = (uint8_t*) malloc(efname_len * sizeof(uint8_t));
-	hex_string_2_bytes_array((uint8_t*) path, strlen(path), efname, (uint16_t*) &efname_len);
-	ret = mbedtls_se_read_ef(efname, efname_len, obj, size, pin);
-	free(efname);
-	
-	return ret;
-}
-
-static int mbedtls_se_p11_read_object(char* label, char** obj, int* size, char* pin) {
-	int ret;
-	
-	#ifdef __cplusplus
-	if(_mias->select(USE_BASIC_CHANNEL)) {
-		if(_mias->verifyPin((uint8_t*) pin, strlen(pin))) {
-			if(_mias->p11GetObjectByLabel((uint8_t*) label, strlen(label), (uint8_t**) obj, (uint16_t*) size)) {
-				*size = *size & 0x0000FFFF;
-				ret = 0;
-			}
-			else {
-				ret = MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR;
-			}
-		}
-		else {
-			ret = MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR;
-		}
-	}
-	_mias->deselect();
-	#else
-	if(Applet_select((Applet*) _mias, USE_BASIC_CHANNEL)) {
-		if(MIAS_verify_pin(_mias, (uint8_t*) pin, strlen(pin))) {
-			if(MIAS_p11_get_object_by_label(_mias, (uint8_t*) label, strlen(label), (uint8_t**) obj, (uint16_t*) size)) {
-				*size = *size & 0x0000FFFF;
-				ret = 0;
-			}
-			else {
-				ret = MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR;
-			}
-		}
-		else {
-			ret = MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR;
-		}
-	}
-	Applet_deselect((Applet*) _mf);	
-	#endif
-	
-	/*
-	if(!ret) {
-		printf("P11: %s\r\n", label);
-		for(int i=0; i<*size; i++) {
-			if(i && ((i % 32) == 0)) {
-				printf("\r\n");		
-			} 
-			printf("%02X", (*obj)[i]);
-		}
-		printf("\r\n\r\n");
-	}
-	*/
-	
-	return ret;
-}
-
-static int mbedtls_mias_pk_rsa_alt_decrypt(void* ctx, int mode, size_t* olen, const unsigned char* input, unsigned char* output, size_t output_max_len) {
-	int ret;
-	
-	#ifdef __cplusplus
-	if(_mias->select(USE_BASIC_CHANNEL)) {
-		if(_mias->verifyPin((uint8_t*) ((mias_key_t*) ctx)->pin, strlen(((mias_key_t*) ctx)->pin))) {
-			if(_mias->decryptInit(ALGO_RSA_PKCS1_PADDING, ((mias_key_t*) ctx)->kp->kid)) {						
-				if(_mias->decryptFinal((uint8_t*) input, ((mias_key_t*) ctx)->kp->size_in_bits / 8, output, (uint16_t*) &olen)) {
-						ret = 0;
-				}
-				else {
-					ret = MBEDTLS_ERR_SE_MIAS_IO_ERROR;
-				}
-			}
-			else {
-				ret = MBEDTLS_ERR_SE_MIAS_IO_ERROR;
-			}
-		}
-		else {
-			ret = MBEDTLS_ERR_SE_MIAS_VERIFY_PIN_ERROR;
-		}
-	}
-	else {
-		ret = MBEDTLS_ERR_SE_MIAS_SELECT_ERROR;
-	}
-	_mias->deselect();
-	#else
-	if(Applet_select((Applet*) _mias, USE_BASIC_CHANNEL)) {
-		if(MIAS_verify_pin(_mias, (uint8_t*) ((mias_key_t*) ctx)->pin, strlen(((mias_key_t*) ctx)->pin))) {
-			if(MIAS_decrypt_init(_mias, ALGO_RSA_PKCS1_PADDING, ((mias_key_t*) ctx)->kp->kid)) {						
-				if(MIAS_decrypt_final(_mias, (uint8_t*) input, ((mias_key_t*) ctx)->kp->size_in_bits / 8, output, (uint16_t*) &olen)) {
-						ret = 0;
-				}
-				else {
-					ret = MBEDTLS_ERR_SE_MIAS_IO_ERROR;
-				}
-			}
-			else {
-				ret = MBEDTLS_ERR_SE_MIAS_IO_ERROR;
-			}
-		}
-		else {
-			ret = MBEDTLS_ERR_SE_MIAS_VERIFY_PIN_ERROR;
-		}
-	}
-	else {
-		ret = MBEDTLS_ERR_SE_MIAS_SELECT_ERROR;
-	}
-	Applet_deselect((Applet*) _mias);
-	#endif
-	
-	return ret;
-}
-
-static int mbedtls_mias_pk_rsa_alt_sign(void* ctx, int (*f_rng)(void*, unsigned char*, size_t), void* p_rng, int mode, mbedtls_md_type_t md_alg, unsigned int hashlen, const unsigned char* hash, unsigned char* sig) {
-	int ret;
-	uint16_t sig_size;
-	char mias_alg;	
-
-	switch (md_alg) {
-		case MBEDTLS_MD_SHA1:
-			mias_alg = ALGO_SHA1_WITH_RSA_PKCS1_PADDING;
-			break;
-		
-		case MBEDTLS_MD_SHA224:
-			mias_alg = ALGO_SHA224_WITH_RSA_PKCS1_PADDING;
-			break;
-		
-		case MBEDTLS_MD_SHA256:
-			mias_alg = ALGO_SHA256_WITH_RSA_PKCS1_PADDING;
-			break;
-		
-		case MBEDTLS_MD_SHA384:
-			mias_alg = ALGO_SHA384_WITH_RSA_PKCS1_PADDING;
-			break;
-		
-		case MBEDTLS_MD_SHA512:
-			mias_alg = ALGO_SHA512_WITH_RSA_PKCS1_PADDING;
-			break;
-		
-		default:
-			return MBEDTLS_ERR_MD_FEATURE_UNAVAILABLE;
-	}
-		
-	#ifdef __cplusplus
-	if(_mias->select(USE_BASIC_CHANNEL)) {
-		if(_mias->verifyPin((uint8_t*) ((mias_key_t*) ctx)->pin, strlen(((mias_key_t*) ctx)->pin))) {
-			if(_mias->signInit(mias_alg, ((mias_key_t*) ctx)->kp->kid)) {						
-				if(_mias->signFinal((uint8_t*) hash, hashlen, sig, &sig_size)) {
-					ret = 0;
-				}
-				else {
-					ret = MBEDTLS_ERR_SE_MIAS_IO_ERROR;
-				}
-			}
-			else {
-				ret = MBEDTLS_ERR_SE_MIAS_IO_ERROR;
-			}
-		}
-		else {
-			ret = MBEDTLS_ERR_SE_MIAS_VERIFY_PIN_ERROR;
-		}
-	}
-	else {
-		ret = MBEDTLS_ERR_SE_MIAS_SELECT_ERROR;
-	}
-	_mias->deselect();
-	#else
-	if(Applet_select((Applet*) _mias, USE_BASIC_CHANNEL)) {
-		if(MIAS_verify_pin(_mias, (uint8_t*) ((mias_key_t*) ctx)->pin, strlen(((mias_key_t*) ctx)->pin))) {
-			if(MIAS_sign_init(_mias, mias_alg, ((mias_key_t*) ctx)->kp->kid)) {						
-				if(MIAS_sign_final(_mias, (uint8_t*) hash, hashlen, sig, &sig_size)) {
-					ret = 0;
-				}
-				else {
-					ret = MBEDTLS_ERR_SE_MIAS_IO_ERROR;
-				}
-			}
-			else {
-				ret = MBEDTLS_ERR_SE_MIAS_IO_ERROR;
-			}
-		}
-		else {
-			ret = MBEDTLS_ERR_SE_MIAS_VERIFY_PIN_ERROR;
-		}
-	}
-	else {
-		ret = MBEDTLS_ERR_SE_MIAS_SELECT_ERROR;
-	}
-	Applet_deselect((Applet*) _mias);
-	#endif
-	
-	return ret;
-}
-
-static size_t mbedtls_mias_pk_rsa_alt_key_len(void* ctx) {
-	return (((mias_key_t*) ctx)->kp->size_in_bits / 8);
-}
-
-int mbedtls_se_init(SEInterface* seiface) {	
-	#ifdef __cplusplus
-	_mias = new MIAS();
-	_mias->init(seiface);
-	
-	_mf = new MF();
-	_mf->init(seiface);
-	#else
-	_mias = MIAS_create();
-	Applet_init((Applet*) _mias, seiface);
-	
-	_mf = MF_create();
-	Applet_init((Applet*) _mf, seiface);
-	#endif
-	return 0;
-}
-
-int mbedtls_x509_crt_parse_se(mbedtls_x509_crt* cert, char* path, char* pin) {
-	int ret = MBEDTLS_ERR_SE_BAD_KEY_NAME_ERROR;
-	
-	// Read Certificate from EF
-	if(memcmp(path, MBEDTLS_SE_EF_KEY_NAME_PREFIX, strlen(MBEDTLS_SE_EF_KEY_NAME_PREFIX)) == 0) {
-		int obj_size;
-		char* obj;
-		
-		// Remove prefix from key path
-		path += strlen(MBEDTLS_SE_EF_KEY_NAME_PREFIX);
-	
-		if((ret = mbedtls_se_read_object(path, &obj, &obj_size, pin)) == 0) {
-			ret = mbedtls_x509_crt_parse(cert, (const unsigned char*) obj, obj_size);
-		}
-
-		free(obj);
-	}
-
-	// Read Certificate from MIAS P11 Data object
-	else if(memcmp(path, MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX, strlen(MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX)) == 0) {
-		int obj_size;
-		char* obj;
-		
-		// Remove prefix from key path
-		path += strlen(MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX);
-		
-		if((ret = mbedtls_se_p11_read_object(path, &obj, &obj_size, pin)) == 0) {
-			ret = mbedtls_x509_crt_parse(cert, (const unsigned char*) obj, obj_size);
-		}
-
-		free(obj);
-	}
-	
-	// Read Certificate from MIAS
-	else if(memcmp(path, MBEDTLS_SE_MIAS_KEY_NAME_PREFIX, strlen(MBEDTLS_SE_MIAS_KEY_NAME_PREFIX)) == 0) {
-		uint8_t cid;
-		
-		// Remove prefix from key path
-		path += strlen(MBEDTLS_SE_MIAS_KEY_NAME_PREFIX);
-			
-		cid = 0;
-		while(*path) {
-			cid *= 10;
-			cid += *path - '0';
-			path++;
-		}
-		
-		#ifdef __cplusplus
-		if(_mias->select(USE_BASIC_CHANNEL)) {
-			char* obj;
-			int obj_size;
-			
-			if(_mias->getCertificateByContainerId(cid, (uint8_t**) &obj, (uint16_t*) &obj_size)) {
-				obj_size &= 0x0000FFFF;
-				ret = mbedtls_x509_crt_parse(cert, (const unsigned char*) obj, obj_size);
-				free(obj);
-			}
-		}
-		_mias->deselect();		
-		#else
-		if(Applet_select((Applet*) _mias, USE_BASIC_CHANNEL)) {
-			char* obj;
-			int obj_size;
-			
-			if(MIAS_get_certificate_by_container_id(_mias, cid, (uint8_t**) &obj, (uint16_t*) &obj_size)) {
-				obj_size &= 0x0000FFFF;
-				ret = mbedtls_x509_crt_parse(cert, (const unsigned char*) obj, obj_size);
-				free(obj);
-			}
-		}
-		Applet_deselect((Applet*) _mias);
-		#endif
-	}
-
-	return ret;
-}
-
-int mbedtls_pk_parse_se(mbedtls_pk_context* pk, char* path, char* pin) {
-	int ret = MBEDTLS_ERR_SE_BAD_KEY_NAME_ERROR;
-
-	// Read PKey from EF
-	if(memcmp(path, MBEDTLS_SE_EF_KEY_NAME_PREFIX, strlen(MBEDTLS_SE_EF_KEY_NAME_PREFIX)) == 0) {
-		int obj_size;
-		char* obj;
-		
-		// Remove prefix from key path
-		path += strlen(MBEDTLS_SE_EF_KEY_NAME_PREFIX);
-	
-		if((ret = mbedtls_se_read_object(path, &obj, &obj_size, pin)) == 0) {
-			ret = mbedtls_pk_parse_key(pk, (const unsigned char*) obj, obj_size, NULL, 0);
-		}
-
-		free(obj);
-	}
-
-	// Read PKey from MIAS P11 Data object
-	else if(memcmp(path, MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX, strlen(MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX)) == 0) {
-		int obj_size;
-		char* obj;
-		
-		// Remove prefix from key path
-		path += strlen(MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX);
-		
-		if((ret = mbedtls_se_p11_read_object(path, &obj, &obj_size, pin)) == 0) {
-			ret = mbedtls_pk_parse_key(pk, (const unsigned char*) obj, obj_size, NULL, 0);
-		}
-
-		free(obj);
-	}
-	
-	// Read PKey from MIAS
-	else if(memcmp(path, MBEDTLS_SE_MIAS_KEY_NAME_PREFIX, strlen(MBEDTLS_SE_MIAS_KEY_NAME_PREFIX)) == 0) {
-		uint8_t cid;
-		mias_key_t* mias_key;
-		
-		// Remove prefix from key path
-		path += strlen(MBEDTLS_SE_MIAS_KEY_NAME_PREFIX);
-		
-		// NOTE: for unknown reason a call to mbedtls_pk_parse_key need to be done even if useless in that case, 
-		//       otherwise a compil error will occur!
-		// ToDo: Investigate this to avoid calling mbedtls_pk_parse_key.
-		mbedtls_pk_parse_key(pk, NULL, 0, NULL, 0);
-		
-		mias_key = (mias_key_t*) malloc(sizeof(mias_key_t));
-		mias_key->pin = (char*) malloc((strlen(pin) + 1) * sizeof(char));
-		memcpy(mias_key->pin, pin, strlen(pin) + 1);
-		
-		cid = 0;
-		while(*path) {
-			cid *= 10;
-			cid += *path - '0';
-			path++;
-		}
-		
-		#ifdef __cplusplus
-		if(_mias->select(USE_BASIC_CHANNEL)) {
-			_mias->getKeyPairByContainerId(cid, &mias_key->kp);
-		}
-		_mias->deselect();
-		#else
-		if(Applet_select((Applet*) _mias, USE_BASIC_CHANNEL)) {
-			MIAS_get_key_pair_by_container_id(_mias, cid, &mias_key->kp);
-		}
-		Applet_deselect((Applet*) _mias);
-		#endif
-				
-		if(mias_key->kp) {
-			return mbedtls_pk_setup_rsa_alt(pk, mias_key, mbedtls_mias_pk_rsa_alt_decrypt, mbedtls_mias_pk_rsa_alt_sign, mbedtls_mias_pk_rsa_alt_key_len);
-		}
-		else {
-			free(mias_key);
-		}
-	}
-	
-	return ret;
-}
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Hex.h"
+#include "MF.h"
+#include "MIAS.h"
+
+#include "mbedtls_se.h"
+
+#include "mbedtls/md.h"
+#include "mbedtls/asn1write.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/pk_internal.h"
+
+#define USE_BASIC_CHANNEL false
+
+typedef struct {
+	bool     valid;
+	uint16_t size;   // EF size from its FCP
+	uint32_t value;  // Fingerprint of the DER extent and last bytes of the object
+} mbedtls_se_fingerprint_t;
+
+// Certificates of a cache entry, also held by the callers of mbedtls_x509_crt_get_se until they
+// release them, so that they outlive their entry being parsed again or dropped.
+typedef struct {
+	mbedtls_x509_crt crt; // First member, callers only know the certificate
+	int refs;
+} mbedtls_se_crt_t;
+
+// Certificates read from the SE, kept between connections.
+typedef struct mbedtls_se_crt_cache_s {
+	char* path;
+	char* paths;                  // Copy of path, one string per SE path of the list
+	int nb_paths;
+	mbedtls_se_fingerprint_t* fp; // One per SE path
+	mbedtls_se_crt_t* crt;        // Reference held by the cache
+
+	struct mbedtls_se_crt_cache_s* next;
+} mbedtls_se_crt_cache_t;
+
+// Key pair metadata is copied, MIAS drops its own list whenever its cache is loaded or cleared.
+typedef struct mias_key_s {
+	char*  pin;
+	uint8_t kid;
+	uint16_t flags;
+	uint16_t size_in_bits;
+	mbedtls_se_context* se;
+
+	struct mias_key_s* next; // RSA keys of the context
+} mias_key_t;
+
+// Applet transactions and shared state (applets, caches) are serialized between threads.
+static void mbedtls_se_lock(mbedtls_se_context* se, uint8_t priority) {
+	#ifdef __cplusplus
+	se->iface->lock(priority);
+	#else
+	SEInterface_lock_priority(se->iface, priority);
+	#endif
+}
+
+static void mbedtls_se_unlock(mbedtls_se_context* se) {
+	#ifdef __cplusplus
+	se->iface->unlock();
+	#else
+	SEInterface_unlock(se->iface);
+	#endif
+}
+
+// Returns true in case an exchange failed because the deadline of mbedtls_se_set_timeout expired, false otherwise.
+static bool mbedtls_se_timed_out(mbedtls_se_context* se) {
+	#ifdef __cplusplus
+	return se->iface->isTimedOut();
+	#else
+	return SEInterface_is_timed_out(se->iface);
+	#endif
+}
+
+// Report a failure caused by the deadline as such, whichever step it interrupted.
+static int mbedtls_se_error(mbedtls_se_context* se, int ret) {
+	if((ret != 0) && mbedtls_se_timed_out(se)) {
+		return MBEDTLS_ERR_SE_TIMEOUT_ERROR;
+	}
+	return ret;
+}
+
+// Write MIAS metadata snapshot in case new metadata has been read from the card.
+// MIAS applet is expected to be selected.
+static void mbedtls_se_save_cache(mbedtls_se_context* se) {
+	if(se->cache_path == NULL) {
+		return;
+	}
+
+	#ifdef __cplusplus
+	if(se->mias->isCacheModified()) {
+		se->mias->saveCache(se->cache_path, se->iccid, se->iccid_len);
+	}
+	#else
+	if(MIAS_is_cache_modified(se->mias)) {
+		MIAS_save_cache(se->mias, se->cache_path, se->iccid, se->iccid_len);
+	}
+	#endif
+}
+
+// Update fingerprint with the value currently read from the SE.
+// Returns true in case the object did not change since the previous fingerprint was taken.
+static bool mbedtls_se_update_fingerprint(mbedtls_se_fingerprint_t* fp, bool valid, uint16_t size, uint32_t value) {
+	bool unchanged;
+
+	unchanged = valid && fp->valid && (fp->size == size) && (fp->value == value);
+
+	fp->valid = valid;
+	fp->size = size;
+	fp->value = value;
+
+	return unchanged;
+}
+
+static int mbedtls_se_read_ef(mbedtls_se_context* se, uint8_t* efname, uint16_t efnamelen, char** data, int* data_size, char* pin) {
+	int ret;
+	uint16_t size;
+	
+	*data = NULL;
+	*data_size = -1;
+	
+	mbedtls_se_lock(se, SE_PRIORITY_LOW);
+	#ifdef __cplusplus
+	if(se->mf->select(USE_BASIC_CHANNEL)) {
+		if(se->mf->verifyPin((uint8_t*) pin, strlen(pin))) {
+			if(se->mf->readEF(efname, efnamelen, (uint8_t**) data, &size)) {
+				*data_size = size & 0x0000FFFF;
+				ret = 0;
+			}
+			else {
+				ret = MBEDTLS_ERR_SE_EF_READ_OBJECT_ERROR;
+			}
+		}
+		else {
+			ret = MBEDTLS_ERR_SE_EF_VERIFY_PIN_ERROR;
+		}
+	}
+	se->mf->deselect();
+	#else
+	if(Applet_select((Applet*) se->mf, USE_BASIC_CHANNEL)) {
+		if(MF_verify_pin(se->mf, (uint8_t*) pin, strlen(pin))) {
+			if(MF_read_ef(se->mf, efname, efnamelen, (uint8_t**) data, &size)) {
+				*data_size = size & 0x0000FFFF;
+				ret = 0;
+			}
+			else {
+				ret = MBEDTLS_ERR_SE_EF_READ_OBJECT_ERROR;
+			}
+		}
+		else {
+			ret = MBEDTLS_ERR_SE_EF_VERIFY_PIN_ERROR;
+		}
+	}
+	Applet_deselect((Applet*) se->mf);	
+	#endif
+	mbedtls_se_unlock(se);
+	
+	return ret;
+}
+
+static int mbedtls_se_read_object(mbedtls_se_context* se, char* path, char** obj, int* size, char* pin) {
+	int ret;
+	uint8_t* efname;
+	uint16_t efname_len;
+		
+	*obj = NULL;
+
+	// Name is expected to be of even size (hex string name)
+	if(strlen(path) & 1) {
+		return MBEDTLS_ERR_SE_EF_INVALID_NAME_ERROR;
+	}
+	
+	efname_len = (strlen(path) / 2);
+	efname = (uint8_t*) malloc(efname_len * sizeof(uint8_t));
+	if(!hex_decode(path, strlen(path), efname)) {
+		free(efname);
+		return MBEDTLS_ERR_SE_EF_INVALID_NAME_ERROR;
+	}
+	ret = mbedtls_se_read_ef(se, efname, efname_len, obj, size, pin);
+	free(efname);
+	
+	return ret;
+}
+
+static int mbedtls_se_p11_read_object(mbedtls_se_context* se, char* label, char** obj, int* size, char* pin) {
+	int ret;
+	
+	*obj = NULL;
+
+	mbedtls_se_lock(se, SE_PRIORITY_LOW);
+	#ifdef __cplusplus
+	if(se->mias->select(USE_BASIC_CHANNEL)) {
+		if(se->mias->verifyPin((uint8_t*) pin, strlen(pin))) {
+			if(se->mias->p11GetObjectByLabel((uint8_t*) label, strlen(label), (uint8_t**) obj, (uint16_t*) size)) {
+				*size = *size & 0x0000FFFF;
+				ret = 0;
+			}
+			else {
+				ret = MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR;
+			}
+			mbedtls_se_save_cache(se);
+		}
+		else {
+			ret = MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR;
+		}
+	}
+	se->mias->deselect();
+	#else
+	if(Applet_select((Applet*) se->mias, USE_BASIC_CHANNEL)) {
+		if(MIAS_verify_pin(se->mias, (uint8_t*) pin, strlen(pin))) {
+			if(MIAS_p11_get_object_by_label(se->mias, (uint8_t*) label, strlen(label), (uint8_t**) obj, (uint16_t*) size)) {
+				*size = *size & 0x0000FFFF;
+				ret = 0;
+			}
+			else {
+				ret = MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR;
+			}
+			mbedtls_se_save_cache(se);
+		}
+		else {
+			ret = MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR;
+		}
+	}
+	Applet_deselect((Applet*) se->mias);
+	#endif
+	mbedtls_se_unlock(se);
+	
+	/*
+	if(!ret) {
+		printf("P11: %s\r\n", label);
+		for(int i=0; i<*size; i++) {
+			if(i && ((i % 32) == 0)) {
+				printf("\r\n");		
+			} 
+			printf("%02X", (*obj)[i]);
+		}
+		printf("\r\n\r\n");
+	}
+	*/
+	
+	return ret;
+}
+
+// Close the MIAS session kept open between private key operations.
+static void mbedtls_se_mias_close_session(mbedtls_se_context* se) {
+	free(se->mias_session_pin);
+	se->mias_session_pin = NULL;
+
+	#ifdef __cplusplus
+	se->mias->deselect();
+	#else
+	Applet_deselect((Applet*) se->mias);
+	#endif
+}
+
+// Select MIAS and verify PIN, unless it was already done for a previous private key operation.
+// Reused parameter tells whether the session was already open, in which case nothing was sent.
+static int mbedtls_se_mias_open_session(mbedtls_se_context* se, char* pin, bool* reused) {
+	bool selected;
+
+	*reused = false;
+
+	#ifdef __cplusplus
+	selected = se->mias->isSelected();
+	#else
+	selected = Applet_is_selected((Applet*) se->mias);
+	#endif
+
+	if(selected && (se->mias_session_pin != NULL) && (strcmp(se->mias_session_pin, pin) == 0)) {
+		*reused = true;
+		return 0;
+	}
+
+	mbedtls_se_mias_close_session(se);
+
+	#ifdef __cplusplus
+	if(!se->mias->select(USE_BASIC_CHANNEL)) {
+		return MBEDTLS_ERR_SE_MIAS_SELECT_ERROR;
+	}
+	if(!se->mias->verifyPin((uint8_t*) pin, strlen(pin))) {
+		mbedtls_se_mias_close_session(se);
+		return MBEDTLS_ERR_SE_MIAS_VERIFY_PIN_ERROR;
+	}
+	#else
+	if(!Applet_select((Applet*) se->mias, USE_BASIC_CHANNEL)) {
+		return MBEDTLS_ERR_SE_MIAS_SELECT_ERROR;
+	}
+	if(!MIAS_verify_pin(se->mias, (uint8_t*) pin, strlen(pin))) {
+		mbedtls_se_mias_close_session(se);
+		return MBEDTLS_ERR_SE_MIAS_VERIFY_PIN_ERROR;
+	}
+	#endif
+
+	se->mias_session_pin = (char*) malloc((strlen(pin) + 1) * sizeof(char));
+	memcpy(se->mias_session_pin, pin, strlen(pin) + 1);
+
+	return 0;
+}
+
+// Run a private key operation within the MIAS session.
+// PIN is only verified again in case the card reports the security status is not satisfied
+// anymore (6982), and the session is only opened again in case a reused one fails (e.g. card reset).
+static int mbedtls_se_mias_run(mbedtls_se_context* se, char* pin, bool (*op)(void*), void* op_ctx) {
+	int ret;
+	bool reused;
+	bool reverified = false;
+	uint16_t sw;
+
+	mbedtls_se_lock(se, SE_PRIORITY_HIGH);
+
+	ret = mbedtls_se_mias_open_session(se, pin, &reused);
+	while(ret == 0) {
+		if(op(op_ctx)) {
+			break;
+		}
+
+		// Neither PIN nor session are worth recovering once the deadline expired
+		if(mbedtls_se_timed_out(se)) {
+			ret = MBEDTLS_ERR_SE_TIMEOUT_ERROR;
+			break;
+		}
+
+		#ifdef __cplusplus
+		sw = se->mias->getStatusWord();
+		#else
+		sw = Applet_get_status_word((Applet*) se->mias);
+		#endif
+
+		if((sw == 0x6982) && !reverified) {
+			reverified = true;
+
+			#ifdef __cplusplus
+			ret = se->mias->verifyPin((uint8_t*) pin, strlen(pin)) ? 0 : MBEDTLS_ERR_SE_MIAS_VERIFY_PIN_ERROR;
+			#else
+			ret = MIAS_verify_pin(se->mias, (uint8_t*) pin, strlen(pin)) ? 0 : MBEDTLS_ERR_SE_MIAS_VERIFY_PIN_ERROR;
+			#endif
+		}
+		else if(reused) {
+			// Pooled channel may not be usable anymore either, MIAS is selected again on a new one
+			mbedtls_se_mias_close_session(se);
+			#ifdef __cplusplus
+			se->mias->close();
+			#else
+			Applet_close((Applet*) se->mias);
+			#endif
+			ret = mbedtls_se_mias_open_session(se, pin, &reused);
+		}
+		else {
+			ret = MBEDTLS_ERR_SE_MIAS_IO_ERROR;
+		}
+	}
+
+	if(ret != 0) {
+		mbedtls_se_mias_close_session(se);
+	}
+
+	mbedtls_se_unlock(se);
+
+	return mbedtls_se_error(se, ret);
+}
+
+typedef struct {
+	mias_key_t* key;
+	const unsigned char* input;
+	unsigned char* output;
+	size_t output_max_len;
+	size_t* olen;
+} mbedtls_se_mias_decrypt_t;
+
+static bool mbedtls_se_mias_decrypt(void* ctx) {
+	mbedtls_se_mias_decrypt_t* op = (mbedtls_se_mias_decrypt_t*) ctx;
+	MIAS* mias = op->key->se->mias;
+	uint8_t plain[SE_MAX_DATA_LENGTH];
+	uint16_t len;
+	bool ret = false;
+
+	#ifdef __cplusplus
+	if(mias->decryptInit(ALGO_RSA_PKCS1_PADDING, op->key->kid)) {
+		ret = mias->decryptFinal((uint8_t*) op->input, op->key->size_in_bits / 8, plain, &len);
+	}
+	#else
+	if(MIAS_decrypt_init(mias, ALGO_RSA_PKCS1_PADDING, op->key->kid)) {
+		ret = MIAS_decrypt_final(mias, (uint8_t*) op->input, op->key->size_in_bits / 8, plain, &len);
+	}
+	#endif
+
+	if(ret) {
+		if(len > op->output_max_len) {
+			return false;
+		}
+		memcpy(op->output, plain, len);
+		*op->olen = len;
+	}
+
+	return ret;
+}
+
+static int mbedtls_mias_pk_rsa_alt_decrypt(void* ctx, int mode, size_t* olen, const unsigned char* input, unsigned char* output, size_t output_max_len) {
+	mbedtls_se_mias_decrypt_t op;
+
+	// Private key operation only
+	(void) mode;
+
+	op.key = (mias_key_t*) ctx;
+	op.input = input;
+	op.output = output;
+	op.output_max_len = output_max_len;
+	op.olen = olen;
+
+	return mbedtls_se_mias_run(((mias_key_t*) ctx)->se, ((mias_key_t*) ctx)->pin, mbedtls_se_mias_decrypt, &op);
+}
+
+// MIAS signature algorithm of key for the given digest.
+static int mbedtls_se_mias_sign_algorithm(mias_key_t* key, mbedtls_md_type_t md_alg, char* alg) {
+	char hash_alg;
+
+	switch (md_alg) {
+		case MBEDTLS_MD_SHA1:
+			hash_alg = ALGO_SHA1;
+			break;
+		
+		case MBEDTLS_MD_SHA224:
+			hash_alg = ALGO_SHA224;
+			break;
+		
+		case MBEDTLS_MD_SHA256:
+			hash_alg = ALGO_SHA256;
+			break;
+		
+		case MBEDTLS_MD_SHA384:
+			hash_alg = ALGO_SHA384;
+			break;
+		
+		case MBEDTLS_MD_SHA512:
+			hash_alg = ALGO_SHA512;
+			break;
+		
+		default:
+			return MBEDTLS_ERR_MD_FEATURE_UNAVAILABLE;
+	}
+
+	*alg = hash_alg | ((key->flags & ECC_KEY_PAIR_FLAG) ? ECDSA : RSA_PKCS1_PADDING);
+
+	return 0;
+}
+
+typedef struct {
+	mias_key_t* key;
+	char alg;
+	const unsigned char* hash;
+	unsigned int hashlen;
+	unsigned char* sig;
+	size_t* sig_len;         // ECDSA only, RSA signature length is the key length
+} mbedtls_se_mias_sign_t;
+
+static bool mbedtls_se_mias_sign(void* ctx) {
+	mbedtls_se_mias_sign_t* op = (mbedtls_se_mias_sign_t*) ctx;
+	MIAS* mias = op->key->se->mias;
+	uint8_t raw[SE_SHORT_MAX_DATA_LENGTH + 2];
+	uint16_t raw_len;
+	size_t key_len = op->key->size_in_bits / 8;
+	bool ret;
+
+	// Signature and its status word are received in a local buffer, mbedTLS only provides room for the key length
+	#ifdef __cplusplus
+	ret = mias->signInit(op->alg, op->key->kid) && mias->signFinal((uint8_t*) op->hash, op->hashlen, raw, &raw_len);
+	#else
+	ret = MIAS_sign_init(mias, op->alg, op->key->kid) && MIAS_sign_final(mias, (uint8_t*) op->hash, op->hashlen, raw, &raw_len);
+	#endif
+
+	if(!ret || (raw_len != key_len)) {
+		return false;
+	}
+
+	memcpy(op->sig, raw, key_len);
+	return true;
+}
+
+static int mbedtls_mias_pk_rsa_alt_sign(void* ctx, int (*f_rng)(void*, unsigned char*, size_t), void* p_rng, int mode, mbedtls_md_type_t md_alg, unsigned int hashlen, const unsigned char* hash, unsigned char* sig) {
+	mbedtls_se_mias_sign_t op;
+	char mias_alg;
+	int ret;
+
+	// Private key operation with the SE random generator
+	(void) f_rng;
+	(void) p_rng;
+	(void) mode;
+
+	if((ret = mbedtls_se_mias_sign_algorithm((mias_key_t*) ctx, md_alg, &mias_alg)) != 0) {
+		return ret;
+	}
+
+	op.key = (mias_key_t*) ctx;
+	op.alg = mias_alg;
+	op.hash = hash;
+	op.hashlen = hashlen;
+	op.sig = sig;
+	op.sig_len = NULL;
+
+	return mbedtls_se_mias_run(((mias_key_t*) ctx)->se, ((mias_key_t*) ctx)->pin, mbedtls_se_mias_sign, &op);
+}
+
+static size_t mbedtls_mias_pk_rsa_alt_key_len(void* ctx) {
+	return (((mias_key_t*) ctx)->size_in_bits / 8);
+}
+
+// Convert a raw r || s ECDSA signature to its ASN.1 form, as expected by mbedTLS.
+static int mbedtls_se_ecdsa_signature_to_asn1(uint8_t* raw, uint16_t raw_len, unsigned char* sig, size_t* sig_len) {
+	int ret;
+	mbedtls_mpi r, s;
+	unsigned char buf[MBEDTLS_ECDSA_MAX_LEN];
+	unsigned char* p = buf + sizeof(buf);
+	size_t len = 0;
+
+	mbedtls_mpi_init(&r);
+	mbedtls_mpi_init(&s);
+
+	// SEQUENCE { INTEGER r, INTEGER s }, written backwards
+	ret = mbedtls_mpi_read_binary(&r, raw, raw_len / 2);
+	if(ret == 0) {
+		ret = mbedtls_mpi_read_binary(&s, raw + (raw_len / 2), raw_len / 2);
+	}
+	if(ret == 0) {
+		ret = mbedtls_asn1_write_mpi(&p, buf, &s);
+	}
+	if(ret > 0) {
+		len += ret;
+		ret = mbedtls_asn1_write_mpi(&p, buf, &r);
+	}
+	if(ret > 0) {
+		len += ret;
+		ret = mbedtls_asn1_write_len(&p, buf, len);
+	}
+	if(ret > 0) {
+		len += ret;
+		ret = mbedtls_asn1_write_tag(&p, buf, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE);
+	}
+	if(ret > 0) {
+		len += ret;
+		memcpy(sig, p, len);
+		*sig_len = len;
+		ret = 0;
+	}
+
+	mbedtls_mpi_free(&r);
+	mbedtls_mpi_free(&s);
+
+	return ret;
+}
+
+static bool mbedtls_se_mias_ecdsa_sign(void* ctx) {
+	mbedtls_se_mias_sign_t* op = (mbedtls_se_mias_sign_t*) ctx;
+	MIAS* mias = op->key->se->mias;
+	uint8_t raw[SE_SHORT_MAX_DATA_LENGTH + 2];
+	uint16_t raw_len;
+	bool ret;
+
+	#ifdef __cplusplus
+	ret = mias->signInit(op->alg, op->key->kid) && mias->signFinal((uint8_t*) op->hash, op->hashlen, raw, &raw_len);
+	#else
+	ret = MIAS_sign_init(mias, op->alg, op->key->kid) && MIAS_sign_final(mias, (uint8_t*) op->hash, op->hashlen, raw, &raw_len);
+	#endif
+
+	if(!ret || (raw_len < 2)) {
+		return false;
+	}
+
+	// Signature may already be ASN.1 encoded
+	if((raw[0] == 0x30) && ((raw[1] == (raw_len - 2)) || ((raw[1] == 0x81) && (raw[2] == (raw_len - 3))))) {
+		memcpy(op->sig, raw, raw_len);
+		*op->sig_len = raw_len;
+		return true;
+	}
+
+	return !(raw_len & 1) && (mbedtls_se_ecdsa_signature_to_asn1(raw, raw_len, op->sig, op->sig_len) == 0);
+}
+
+static int mbedtls_mias_pk_ecdsa_sign(void* ctx, mbedtls_md_type_t md_alg, const unsigned char* hash, size_t hash_len, unsigned char* sig, size_t* sig_len, int (*f_rng)(void*, unsigned char*, size_t), void* p_rng) {
+	mbedtls_se_mias_sign_t op;
+	char mias_alg;
+	int ret;
+
+	// Nonce is generated by the SE
+	(void) f_rng;
+	(void) p_rng;
+
+	if((ret = mbedtls_se_mias_sign_algorithm((mias_key_t*) ctx, md_alg, &mias_alg)) != 0) {
+		return ret;
+	}
+
+	op.key = (mias_key_t*) ctx;
+	op.alg = mias_alg;
+	op.hash = hash;
+	op.hashlen = hash_len;
+	op.sig = sig;
+	op.sig_len = sig_len;
+
+	return mbedtls_se_mias_run(((mias_key_t*) ctx)->se, ((mias_key_t*) ctx)->pin, mbedtls_se_mias_ecdsa_sign, &op);
+}
+
+static size_t mbedtls_mias_pk_ecdsa_get_bitlen(const void* ctx) {
+	return ((const mias_key_t*) ctx)->size_in_bits;
+}
+
+static int mbedtls_mias_pk_ecdsa_can_do(mbedtls_pk_type_t type) {
+	return (type == MBEDTLS_PK_ECDSA);
+}
+
+static void* mbedtls_mias_pk_ecdsa_alloc(void) {
+	return calloc(1, sizeof(mias_key_t));
+}
+
+static void mbedtls_mias_pk_ecdsa_free(void* ctx) {
+	free(((mias_key_t*) ctx)->pin);
+	free(ctx);
+}
+
+// Opaque ECDSA key, private key operations are done by MIAS.
+static const mbedtls_pk_info_t mbedtls_mias_pk_ecdsa_info = {
+	MBEDTLS_PK_ECDSA,
+	"MIAS_ECDSA",
+	mbedtls_mias_pk_ecdsa_get_bitlen,
+	mbedtls_mias_pk_ecdsa_can_do,
+	NULL,
+	mbedtls_mias_pk_ecdsa_sign,
+	NULL,
+	NULL,
+	NULL,
+	mbedtls_mias_pk_ecdsa_alloc,
+	mbedtls_mias_pk_ecdsa_free,
+	NULL,
+};
+
+int mbedtls_se_init(mbedtls_se_context* se, SEInterface* seiface) {	
+	memset(se, 0, sizeof(mbedtls_se_context));
+	se->iface = seiface;
+	mbedtls_se_lock(se, SE_PRIORITY_NORMAL);
+
+	// Large objects are read in one or two exchanges when extended length is supported
+	#ifdef __cplusplus
+	seiface->detectExtendedLength();
+	#else
+	SEInterface_detect_extended_length(seiface);
+	#endif
+
+	#ifdef __cplusplus
+	se->mias = new MIAS();
+	se->mias->init(seiface);
+	
+	se->mf = new MF();
+	se->mf->init(seiface);
+	#else
+	se->mias = MIAS_create();
+	Applet_init((Applet*) se->mias, seiface);
+	
+	se->mf = MF_create();
+	Applet_init((Applet*) se->mf, seiface);
+	#endif
+
+	mbedtls_se_unlock(se);
+	return 0;
+}
+
+void mbedtls_se_free(mbedtls_se_context* se) {
+	mias_key_t* key;
+
+	if(se->iface == NULL) {
+		return;
+	}
+
+	// Queued operations still use the applets
+	mbedtls_se_stop_worker(se);
+	#ifdef __cplusplus
+	delete se->worker;
+	#else
+	SEWorker_destroy(se->worker);
+	#endif
+
+	mbedtls_se_clear_crt_cache(se);
+
+	mbedtls_se_lock(se, SE_PRIORITY_NORMAL);
+	mbedtls_se_mias_close_session(se);
+	while(se->rsa_keys != NULL) {
+		key = se->rsa_keys;
+		se->rsa_keys = key->next;
+		free(key->pin);
+		free(key);
+	}
+	#ifdef __cplusplus
+	delete se->mias;
+	delete se->mf;
+	#else
+	MIAS_destroy(se->mias);
+	MF_destroy(se->mf);
+	#endif
+	mbedtls_se_unlock(se);
+
+	free(se->cache_path);
+	memset(se, 0, sizeof(mbedtls_se_context));
+}
+
+int mbedtls_se_start_worker(mbedtls_se_context* se) {
+	bool started;
+
+	#ifdef __cplusplus
+	if(se->worker == NULL) {
+		se->worker = new SEWorker();
+	}
+	started = se->worker->start(se->iface);
+	#else
+	if(se->worker == NULL) {
+		se->worker = SEWorker_create();
+	}
+	started = SEWorker_start(se->worker, se->iface);
+	#endif
+
+	return started ? 0 : MBEDTLS_ERR_SE_WORKER_ERROR;
+}
+
+void mbedtls_se_stop_worker(mbedtls_se_context* se) {
+	if(se->worker != NULL) {
+		#ifdef __cplusplus
+		se->worker->stop();
+		#else
+		SEWorker_stop(se->worker);
+		#endif
+	}
+}
+
+// Key of a PK context from mbedtls_pk_parse_se, NULL in case the key is not held by MIAS.
+static mias_key_t* mbedtls_se_mias_key(mbedtls_pk_context* pk) {
+	if(pk->pk_info == &mbedtls_mias_pk_ecdsa_info) {
+		return (mias_key_t*) pk->pk_ctx;
+	}
+
+	if((pk->pk_info == &mbedtls_rsa_alt_info) && (((mbedtls_rsa_alt_context*) pk->pk_ctx)->sign_func == mbedtls_mias_pk_rsa_alt_sign)) {
+		return (mias_key_t*) ((mbedtls_rsa_alt_context*) pk->pk_ctx)->key;
+	}
+
+	return NULL;
+}
+
+static bool mbedtls_se_async_sign(void* ctx) {
+	mbedtls_se_async_t* req = (mbedtls_se_async_t*) ctx;
+
+	req->ret = mbedtls_pk_sign(req->pk, req->md_alg, req->hash, req->hash_len, req->sig, req->sig_len, NULL, NULL);
+
+	return (req->ret == 0);
+}
+
+static void mbedtls_se_async_done(void* ctx, bool result) {
+	mbedtls_se_async_t* req = (mbedtls_se_async_t*) ctx;
+
+	(void) result;
+
+	if(req->done != NULL) {
+		req->done(req->ctx, req->ret);
+	}
+}
+
+int mbedtls_pk_sign_se_async(mbedtls_se_async_t* req, mbedtls_pk_context* pk, mbedtls_md_type_t md_alg, const unsigned char* hash, size_t hash_len, unsigned char* sig, size_t* sig_len, void (*done)(void* ctx, int ret), void* ctx) {
+	mias_key_t* key = mbedtls_se_mias_key(pk);
+	bool submitted = false;
+
+	req->se = (key != NULL) ? key->se : NULL;
+	req->pk = pk;
+	req->md_alg = md_alg;
+	req->hash = hash;
+	req->hash_len = hash_len;
+	req->sig = sig;
+	req->sig_len = sig_len;
+	req->ret = MBEDTLS_ERR_SE_WORKER_ERROR;
+	req->done = done;
+	req->ctx = ctx;
+
+	req->job.run = mbedtls_se_async_sign;
+	req->job.done = mbedtls_se_async_done;
+	req->job.ctx = req;
+	req->job.priority = SE_PRIORITY_HIGH;
+	// Not submitted request is reported as done
+	req->job.state = SE_JOB_DONE;
+
+	if((req->se != NULL) && (req->se->worker != NULL)) {
+		#ifdef __cplusplus
+		submitted = req->se->worker->submit(&req->job);
+		#else
+		submitted = SEWorker_submit(req->se->worker, &req->job);
+		#endif
+	}
+
+	return submitted ? 0 : MBEDTLS_ERR_SE_WORKER_ERROR;
+}
+
+bool mbedtls_se_async_is_done(mbedtls_se_async_t* req) {
+	if((req->se == NULL) || (req->se->worker == NULL)) {
+		return true;
+	}
+
+	#ifdef __cplusplus
+	return req->se->worker->isDone(&req->job);
+	#else
+	return SEWorker_is_done(req->se->worker, &req->job);
+	#endif
+}
+
+int mbedtls_se_async_wait(mbedtls_se_async_t* req) {
+	if((req->se != NULL) && (req->se->worker != NULL)) {
+		#ifdef __cplusplus
+		req->se->worker->wait(&req->job);
+		#else
+		SEWorker_wait(req->se->worker, &req->job);
+		#endif
+	}
+
+	return req->ret;
+}
+
+typedef struct {
+	mias_key_t* key;
+	char alg;
+} mbedtls_se_mias_prepare_t;
+
+// Security environment is kept by MIAS until the next signature, see MIAS::signInit.
+static bool mbedtls_se_mias_prepare(void* ctx) {
+	mbedtls_se_mias_prepare_t* op = (mbedtls_se_mias_prepare_t*) ctx;
+
+	#ifdef __cplusplus
+	return op->key->se->mias->signInit(op->alg, op->key->kid);
+	#else
+	return MIAS_sign_init(op->key->se->mias, op->alg, op->key->kid);
+	#endif
+}
+
+static bool mbedtls_se_prepare_job(void* ctx) {
+	mbedtls_se_context* se = (mbedtls_se_context*) ctx;
+	mbedtls_se_mias_prepare_t op;
+
+	op.key = (mias_key_t*) se->prepare_key;
+	op.alg = se->prepare_alg;
+
+	return (mbedtls_se_mias_run(se, op.key->pin, mbedtls_se_mias_prepare, &op) == 0);
+}
+
+int mbedtls_pk_prepare_se(mbedtls_pk_context* pk, mbedtls_md_type_t md_alg) {
+	mbedtls_se_mias_prepare_t op;
+	mbedtls_se_context* se;
+	bool submitted;
+	int ret;
+
+	if((op.key = mbedtls_se_mias_key(pk)) == NULL) {
+		return MBEDTLS_ERR_PK_TYPE_MISMATCH;
+	}
+
+	if((ret = mbedtls_se_mias_sign_algorithm(op.key, md_alg, &op.alg)) != 0) {
+		return ret;
+	}
+
+	se = op.key->se;
+	if(se->worker != NULL) {
+		#ifdef __cplusplus
+		// Previous preparation still queued, its key can't be replaced yet
+		if(se->prepare_queued && !se->worker->isDone(&se->prepare_job)) {
+			return 0;
+		}
+		#else
+		if(se->prepare_queued && !SEWorker_is_done(se->worker, &se->prepare_job)) {
+			return 0;
+		}
+		#endif
+
+		se->prepare_key = op.key;
+		se->prepare_alg = op.alg;
+		se->prepare_job.run = mbedtls_se_prepare_job;
+		se->prepare_job.done = NULL;
+		se->prepare_job.ctx = se;
+		se->prepare_job.priority = SE_PRIORITY_NORMAL;
+
+		#ifdef __cplusplus
+		submitted = se->worker->submit(&se->prepare_job);
+		#else
+		submitted = SEWorker_submit(se->worker, &se->prepare_job);
+		#endif
+
+		se->prepare_queued = submitted;
+		if(submitted) {
+			return 0;
+		}
+	}
+
+	return mbedtls_se_mias_run(se, op.key->pin, mbedtls_se_mias_prepare, &op);
+}
+
+int mbedtls_se_init_cache(mbedtls_se_context* se, const char* path) {
+	int ret = MBEDTLS_ERR_SE_EF_READ_OBJECT_ERROR;
+
+	mbedtls_se_lock(se, SE_PRIORITY_NORMAL);
+
+	free(se->cache_path);
+	se->cache_path = NULL;
+
+	// Snapshot is bound to the card's ICCID
+	#ifdef __cplusplus
+	if(se->mf->select(USE_BASIC_CHANNEL)) {
+		if(se->mf->readICCID(se->iccid, &se->iccid_len)) {
+			ret = 0;
+		}
+	}
+	se->mf->deselect();
+	#else
+	if(Applet_select((Applet*) se->mf, USE_BASIC_CHANNEL)) {
+		if(MF_read_iccid(se->mf, se->iccid, &se->iccid_len)) {
+			ret = 0;
+		}
+	}
+	Applet_deselect((Applet*) se->mf);
+	#endif
+
+	if(ret != 0) {
+		mbedtls_se_unlock(se);
+		return ret;
+	}
+
+	se->cache_path = (char*) malloc((strlen(path) + 1) * sizeof(char));
+	memcpy(se->cache_path, path, strlen(path) + 1);
+
+	ret = MBEDTLS_ERR_SE_CACHE_MISS_ERROR;
+
+	#ifdef __cplusplus
+	if(se->mias->select(USE_BASIC_CHANNEL)) {
+		if(se->mias->loadCache(se->cache_path, se->iccid, se->iccid_len)) {
+			ret = 0;
+		}
+	}
+	se->mias->deselect();
+	#else
+	if(Applet_select((Applet*) se->mias, USE_BASIC_CHANNEL)) {
+		if(MIAS_load_cache(se->mias, se->cache_path, se->iccid, se->iccid_len)) {
+			ret = 0;
+		}
+	}
+	Applet_deselect((Applet*) se->mias);
+	#endif
+
+	mbedtls_se_unlock(se);
+	return ret;
+}
+
+// Parse the certificates stored one after the other within size bytes from offset in the EF currently
+// selected on applet. Each DER certificate is read in a buffer of its own size and parsed right away,
+// so that the whole EF is never held in memory. A compressed certificate is inflated while it is read.
+// Other encodings (PEM) are read and parsed at once.
+static int mbedtls_se_parse_crt_stream(Applet* applet, uint16_t offset, uint16_t size, mbedtls_x509_crt* chain, int read_error) {
+	int ret;
+	int nb = 0;
+	uint8_t header[4 + 2];
+	uint8_t* der;
+	uint32_t end, len, header_len;
+	bool read;
+
+	end = (uint32_t) offset + size;
+
+	while(((uint32_t) offset + 2) <= end) {
+		header_len = ((end - offset) < 4) ? (end - offset) : 4;
+
+		#ifdef __cplusplus
+		read = applet->readBinary(offset, header, header_len);
+		#else
+		read = Applet_read_binary(applet, offset, header, header_len);
+		#endif
+
+		if(!read) {
+			return read_error;
+		}
+
+		if((header[0] == 0x01) && (header[1] == 0x00) && (header_len == 4) && (nb == 0)) {
+			// Compressed certificate (MIAS), the zlib stream is inflated straight into the DER buffer
+			len = header[2] | (header[3] << 8);
+			if((der = (uint8_t*) malloc(len + 2)) == NULL) {
+				return MBEDTLS_ERR_X509_ALLOC_FAILED;
+			}
+
+			#ifdef __cplusplus
+			read = applet->readInflatedBinary(offset + 4, end - offset - 4, der, len);
+			#else
+			read = Applet_read_inflated_binary(applet, offset + 4, end - offset - 4, der, len);
+			#endif
+
+			ret = read ? mbedtls_x509_crt_parse_der(chain, der, len) : read_error;
+			free(der);
+
+			// Remaining bytes are padding
+			return ret;
+		}
+		else if(header[0] != 0x30) {
+			// Remaining bytes are padding
+			if(nb > 0) {
+				break;
+			}
+			len = end - offset;
+			header_len = 0;
+		}
+		else if(header[1] < 0x80) {
+			len = header[1];
+			header_len = 2;
+		}
+		else if((header[1] == 0x81) && (header_len >= 3)) {
+			len = header[2];
+			header_len = 3;
+		}
+		else if((header[1] == 0x82) && (header_len >= 4)) {
+			len = (header[2] << 8) | header[3];
+			header_len = 4;
+		}
+		else {
+			return MBEDTLS_ERR_X509_INVALID_FORMAT;
+		}
+
+		if((offset + header_len + len) > end) {
+			return MBEDTLS_ERR_X509_INVALID_FORMAT;
+		}
+		len += header_len;
+
+		// Room for the status word of the last chunk, replaced by the final '\0'
+		if((der = (uint8_t*) malloc(len + 2)) == NULL) {
+			return MBEDTLS_ERR_X509_ALLOC_FAILED;
+		}
+
+		#ifdef __cplusplus
+		read = applet->readBinary(offset, der, len);
+		#else
+		read = Applet_read_binary(applet, offset, der, len);
+		#endif
+
+		if(!read) {
+			ret = read_error;
+		}
+		else if(header_len) {
+			ret = mbedtls_x509_crt_parse_der(chain, der, len);
+		}
+		else {
+			der[len] = '\0';
+			if((ret = mbedtls_x509_crt_parse(chain, der, len + 1)) > 0) {
+				ret = MBEDTLS_ERR_X509_INVALID_FORMAT;
+			}
+		}
+		free(der);
+
+		if(ret != 0) {
+			return ret;
+		}
+
+		offset += len;
+		nb++;
+	}
+
+	return (nb > 0) ? 0 : MBEDTLS_ERR_X509_INVALID_FORMAT;
+}
+
+// Parse certificates of EF at path into chain, fp is updated.
+// Returns 0 in case EF did not change since fp was taken and force is false, nothing is parsed then.
+// Otherwise returns 1 once certificates are parsed, or in case chain is NULL only 1 without parsing.
+static int mbedtls_se_ef_load_crt(mbedtls_se_context* se, char* path, char* pin, mbedtls_se_fingerprint_t* fp, mbedtls_x509_crt* chain, bool force) {
+	int ret;
+	uint8_t* efname;
+	uint16_t efname_len;
+	uint16_t size;
+	uint32_t fp_value;
+	bool fp_valid, unchanged, selected;
+
+	// Name is expected to be of even size (hex string name)
+	if(strlen(path) & 1) {
+		return MBEDTLS_ERR_SE_EF_INVALID_NAME_ERROR;
+	}
+
+	efname_len = (strlen(path) / 2);
+	efname = (uint8_t*) malloc(efname_len * sizeof(uint8_t));
+	if(!hex_decode(path, strlen(path), efname)) {
+		free(efname);
+		return MBEDTLS_ERR_SE_EF_INVALID_NAME_ERROR;
+	}
+
+	ret = MBEDTLS_ERR_SE_EF_READ_OBJECT_ERROR;
+
+	mbedtls_se_lock(se, SE_PRIORITY_LOW);
+	#ifdef __cplusplus
+	if(se->mf->select(USE_BASIC_CHANNEL)) {
+		if(se->mf->verifyPin((uint8_t*) pin, strlen(pin))) {
+			fp_valid = se->mf->getEFFingerprint(efname, efname_len, &size, &fp_value);
+			unchanged = mbedtls_se_update_fingerprint(fp, fp_valid, size, fp_value);
+
+			if(chain == NULL) {
+				ret = unchanged ? 0 : 1;
+			}
+			else if(unchanged && !force) {
+				ret = 0;
+			}
+			else {
+				selected = fp_valid || se->mf->selectEF(efname, efname_len, &size);
+				if(selected && ((ret = mbedtls_se_parse_crt_stream(se->mf, 0, size, chain, MBEDTLS_ERR_SE_EF_READ_OBJECT_ERROR)) == 0)) {
+					ret = 1;
+				}
+			}
+		}
+		else {
+			ret = MBEDTLS_ERR_SE_EF_VERIFY_PIN_ERROR;
+		}
+	}
+	se->mf->deselect();
+	#else
+	if(Applet_select((Applet*) se->mf, USE_BASIC_CHANNEL)) {
+		if(MF_verify_pin(se->mf, (uint8_t*) pin, strlen(pin))) {
+			fp_valid = MF_get_ef_fingerprint(se->mf, efname, efname_len, &size, &fp_value);
+			unchanged = mbedtls_se_update_fingerprint(fp, fp_valid, size, fp_value);
+
+			if(chain == NULL) {
+				ret = unchanged ? 0 : 1;
+			}
+			else if(unchanged && !force) {
+				ret = 0;
+			}
+			else {
+				selected = fp_valid || MF_select_ef(se->mf, efname, efname_len, &size);
+				if(selected && ((ret = mbedtls_se_parse_crt_stream((Applet*) se->mf, 0, size, chain, MBEDTLS_ERR_SE_EF_READ_OBJECT_ERROR)) == 0)) {
+					ret = 1;
+				}
+			}
+		}
+		else {
+			ret = MBEDTLS_ERR_SE_EF_VERIFY_PIN_ERROR;
+		}
+	}
+	Applet_deselect((Applet*) se->mf);
+	#endif
+	mbedtls_se_unlock(se);
+
+	free(efname);
+
+	return ret;
+}
+
+// Same as mbedtls_se_ef_load_crt for the MIAS P11 data object identified by label.
+static int mbedtls_se_p11_load_crt(mbedtls_se_context* se, char* label, char* pin, mbedtls_se_fingerprint_t* fp, mbedtls_x509_crt* chain, bool force) {
+	int ret;
+	uint16_t offset, size, fp_size;
+	uint32_t fp_value;
+	bool fp_valid, unchanged;
+
+	ret = MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR;
+
+	mbedtls_se_lock(se, SE_PRIORITY_LOW);
+	#ifdef __cplusplus
+	if(se->mias->select(USE_BASIC_CHANNEL)) {
+		if(se->mias->verifyPin((uint8_t*) pin, strlen(pin))) {
+			// Object may not be located yet, in which case its fingerprint is only known once selected
+			fp_valid = fp->valid && se->mias->p11GetObjectFingerprint((uint8_t*) label, strlen(label), &fp_size, &fp_value);
+			unchanged = fp_valid && mbedtls_se_update_fingerprint(fp, fp_valid, fp_size, fp_value);
+
+			if(chain == NULL) {
+				ret = unchanged ? 0 : 1;
+			}
+			else if(unchanged && !force) {
+				ret = 0;
+			}
+			else if(se->mias->p11SelectObjectByLabel((uint8_t*) label, strlen(label), &offset, &size)) {
+				fp_valid = se->mias->p11GetObjectFingerprint((uint8_t*) label, strlen(label), &fp_size, &fp_value);
+				mbedtls_se_update_fingerprint(fp, fp_valid, fp_size, fp_value);
+
+				if((ret = mbedtls_se_parse_crt_stream(se->mias, offset, size, chain, MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR)) == 0) {
+					ret = 1;
+				}
+			}
+			mbedtls_se_save_cache(se);
+		}
+	}
+	se->mias->deselect();
+	#else
+	if(Applet_select((Applet*) se->mias, USE_BASIC_CHANNEL)) {
+		if(MIAS_verify_pin(se->mias, (uint8_t*) pin, strlen(pin))) {
+			// Object may not be located yet, in which case its fingerprint is only known once selected
+			fp_valid = fp->valid && MIAS_p11_get_object_fingerprint(se->mias, (uint8_t*) label, strlen(label), &fp_size, &fp_value);
+			unchanged = fp_valid && mbedtls_se_update_fingerprint(fp, fp_valid, fp_size, fp_value);
+
+			if(chain == NULL) {
+				ret = unchanged ? 0 : 1;
+			}
+			else if(unchanged && !force) {
+				ret = 0;
+			}
+			else if(MIAS_p11_select_object_by_label(se->mias, (uint8_t*) label, strlen(label), &offset, &size)) {
+				fp_valid = MIAS_p11_get_object_fingerprint(se->mias, (uint8_t*) label, strlen(label), &fp_size, &fp_value);
+				mbedtls_se_update_fingerprint(fp, fp_valid, fp_size, fp_value);
+
+				if((ret = mbedtls_se_parse_crt_stream((Applet*) se->mias, offset, size, chain, MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR)) == 0) {
+					ret = 1;
+				}
+			}
+			mbedtls_se_save_cache(se);
+		}
+	}
+	Applet_deselect((Applet*) se->mias);
+	#endif
+	mbedtls_se_unlock(se);
+
+	return ret;
+}
+
+// Same as mbedtls_se_ef_load_crt for the certificate of MIAS container cid.
+static int mbedtls_se_mias_load_crt(mbedtls_se_context* se, uint8_t cid, mbedtls_se_fingerprint_t* fp, mbedtls_x509_crt* chain, bool force) {
+	int ret;
+	uint16_t size;
+	uint32_t fp_value;
+	bool fp_valid, unchanged, selected;
+
+	ret = MBEDTLS_ERR_SE_BAD_KEY_NAME_ERROR;
+
+	mbedtls_se_lock(se, SE_PRIORITY_LOW);
+	#ifdef __cplusplus
+	if(se->mias->select(USE_BASIC_CHANNEL)) {
+		fp_valid = se->mias->getCertificateFingerprint(cid, &size, &fp_value);
+		unchanged = mbedtls_se_update_fingerprint(fp, fp_valid, size, fp_value);
+
+		if(chain == NULL) {
+			ret = unchanged ? 0 : 1;
+		}
+		else if(unchanged && !force) {
+			ret = 0;
+		}
+		else {
+			selected = fp_valid || se->mias->selectCertificateByContainerId(cid, &size);
+			if(selected && ((ret = mbedtls_se_parse_crt_stream(se->mias, 0, size, chain, MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR)) == 0)) {
+				ret = 1;
+			}
+		}
+		mbedtls_se_save_cache(se);
+	}
+	se->mias->deselect();
+	#else
+	if(Applet_select((Applet*) se->mias, USE_BASIC_CHANNEL)) {
+		fp_valid = MIAS_get_certificate_fingerprint(se->mias, cid, &size, &fp_value);
+		unchanged = mbedtls_se_update_fingerprint(fp, fp_valid, size, fp_value);
+
+		if(chain == NULL) {
+			ret = unchanged ? 0 : 1;
+		}
+		else if(unchanged && !force) {
+			ret = 0;
+		}
+		else {
+			selected = fp_valid || MIAS_select_certificate_by_container_id(se->mias, cid, &size);
+			if(selected && ((ret = mbedtls_se_parse_crt_stream((Applet*) se->mias, 0, size, chain, MBEDTLS_ERR_SE_MIAS_READ_OBJECT_ERROR)) == 0)) {
+				ret = 1;
+			}
+		}
+		mbedtls_se_save_cache(se);
+	}
+	Applet_deselect((Applet*) se->mias);
+	#endif
+	mbedtls_se_unlock(se);
+
+	return ret;
+}
+
+// Parse certificates stored at path into chain, fp is updated.
+// Returns 0 in case certificates did not change since fp was taken and force is false, nothing is parsed
+// then. Otherwise returns 1 once certificates are parsed, or in case chain is NULL only 1 without parsing.
+static int mbedtls_se_load_crt(mbedtls_se_context* se, char* path, char* pin, mbedtls_se_fingerprint_t* fp, mbedtls_x509_crt* chain, bool force) {
+	int ret = MBEDTLS_ERR_SE_BAD_KEY_NAME_ERROR;
+
+	// Paths of a list may be shorter than the prefixes, comparison stops at the end of path
+
+	// Read Certificate from EF
+	if(strncmp(path, MBEDTLS_SE_EF_KEY_NAME_PREFIX, strlen(MBEDTLS_SE_EF_KEY_NAME_PREFIX)) == 0) {
+		// Remove prefix from key path
+		path += strlen(MBEDTLS_SE_EF_KEY_NAME_PREFIX);
+	
+		ret = mbedtls_se_ef_load_crt(se, path, pin, fp, chain, force);
+	}
+
+	// Read Certificate from MIAS P11 Data object
+	else if(strncmp(path, MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX, strlen(MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX)) == 0) {
+		// Remove prefix from key path
+		path += strlen(MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX);
+		
+		ret = mbedtls_se_p11_load_crt(se, path, pin, fp, chain, force);
+	}
+	
+	// Read Certificate from MIAS
+	else if(strncmp(path, MBEDTLS_SE_MIAS_KEY_NAME_PREFIX, strlen(MBEDTLS_SE_MIAS_KEY_NAME_PREFIX)) == 0) {
+		uint8_t cid;
+		
+		// Remove prefix from key path
+		path += strlen(MBEDTLS_SE_MIAS_KEY_NAME_PREFIX);
+			
+		cid = 0;
+		while(*path) {
+			cid *= 10;
+			cid += *path - '0';
+			path++;
+		}
+		
+		ret = mbedtls_se_mias_load_crt(se, cid, fp, chain, force);
+	}
+
+	return ret;
+}
+
+static mbedtls_se_crt_t* mbedtls_se_crt_new(void) {
+	mbedtls_se_crt_t* crt;
+
+	if((crt = (mbedtls_se_crt_t*) malloc(sizeof(mbedtls_se_crt_t))) != NULL) {
+		mbedtls_x509_crt_init(&crt->crt);
+		crt->refs = 1;
+	}
+
+	return crt;
+}
+
+// Drop a reference on certificates, they are freed with the last one. SE is expected to be locked.
+static void mbedtls_se_crt_release(mbedtls_se_crt_t* crt) {
+	if(--crt->refs == 0) {
+		mbedtls_x509_crt_free(&crt->crt);
+		free(crt);
+	}
+}
+
+static void mbedtls_se_crt_cache_free(mbedtls_se_crt_cache_t* entry) {
+	if(entry->crt != NULL) {
+		mbedtls_se_crt_release(entry->crt);
+	}
+	free(entry->fp);
+	free(entry->paths);
+	free(entry->path);
+	free(entry);
+}
+
+// Get the cache entry of the certificates stored at path (SE paths separated by ';'). Certificates are
+// only read and parsed in case they are not cached yet or in case one of their EF changed since they
+// were cached. SE is expected to be locked, entry is only valid until it is unlocked.
+static int mbedtls_se_crt_cache_get(mbedtls_se_context* se, char* path, char* pin, mbedtls_se_crt_cache_t** entry) {
+	int ret;
+	int i;
+	char* p;
+	bool changed;
+	mbedtls_se_crt_t* crt;
+	mbedtls_se_crt_cache_t** pentry;
+
+	for(pentry = &se->crt_cache; *pentry != NULL; pentry = &(*pentry)->next) {
+		if(strcmp((*pentry)->path, path) == 0) {
+			break;
+		}
+	}
+
+	if(*pentry == NULL) {
+		*pentry = (mbedtls_se_crt_cache_t*) calloc(1, sizeof(mbedtls_se_crt_cache_t));
+		(*pentry)->path = (char*) malloc((strlen(path) + 1) * sizeof(char));
+		memcpy((*pentry)->path, path, strlen(path) + 1);
+		(*pentry)->paths = (char*) malloc((strlen(path) + 1) * sizeof(char));
+		memcpy((*pentry)->paths, path, strlen(path) + 1);
+		(*pentry)->nb_paths = 1;
+		for(p = (*pentry)->paths; *p; p++) {
+			if(*p == ';') {
+				*p = '\0';
+				(*pentry)->nb_paths++;
+			}
+		}
+		(*pentry)->fp = (mbedtls_se_fingerprint_t*) calloc((*pentry)->nb_paths, sizeof(mbedtls_se_fingerprint_t));
+	}
+
+	// A single path is checked and parsed at once, a list is only parsed again in case one of its
+	// paths changed, as certificates are kept in the order of the list
+	ret = 0;
+	changed = ((*pentry)->nb_paths == 1);
+	for(i = 0, p = (*pentry)->paths; !changed && (i < (*pentry)->nb_paths); i++, p += strlen(p) + 1) {
+		if((ret = mbedtls_se_load_crt(se, p, pin, &(*pentry)->fp[i], NULL, false)) < 0) {
+			break;
+		}
+		changed = (ret == 1);
+	}
+
+	if(ret >= 0) {
+		if(!changed) {
+			*entry = *pentry;
+			return 0;
+		}
+
+		// Cached certificates are only replaced once all of them were parsed again, callers still
+		// holding the previous ones keep them until they release them
+		if((crt = mbedtls_se_crt_new()) == NULL) {
+			ret = MBEDTLS_ERR_X509_ALLOC_FAILED;
+		}
+		for(i = 0, p = (*pentry)->paths; (crt != NULL) && (i < (*pentry)->nb_paths); i++, p += strlen(p) + 1) {
+			if((ret = mbedtls_se_load_crt(se, p, pin, &(*pentry)->fp[i], &crt->crt, (*pentry)->nb_paths > 1)) <= 0) {
+				break;
+			}
+		}
+
+		if(ret >= 0) {
+			if(ret == 1) {
+				if((*pentry)->crt != NULL) {
+					mbedtls_se_crt_release((*pentry)->crt);
+				}
+				(*pentry)->crt = crt;
+			}
+			else {
+				mbedtls_se_crt_release(crt);
+			}
+			*entry = *pentry;
+			return 0;
+		}
+
+		if(crt != NULL) {
+			mbedtls_se_crt_release(crt);
+		}
+	}
+
+	// Drop entry, a failed read must not let a stale certificate be used
+	*entry = *pentry;
+	*pentry = (*pentry)->next;
+	mbedtls_se_crt_cache_free(*entry);
+	*entry = NULL;
+
+	return ret;
+}
+
+int mbedtls_x509_crt_parse_se(mbedtls_se_context* se, mbedtls_x509_crt* cert, char* path, char* pin) {
+	int ret;
+	mbedtls_se_crt_cache_t* entry;
+	mbedtls_x509_crt* crt;
+
+	mbedtls_se_lock(se, SE_PRIORITY_LOW);
+	if((ret = mbedtls_se_crt_cache_get(se, path, pin, &entry)) == 0) {
+		for(crt = &entry->crt->crt; (ret == 0) && (crt != NULL) && (crt->raw.p != NULL); crt = crt->next) {
+			ret = mbedtls_x509_crt_parse_der(cert, crt->raw.p, crt->raw.len);
+		}
+	}
+	mbedtls_se_unlock(se);
+
+	return mbedtls_se_error(se, ret);
+}
+
+int mbedtls_x509_crt_get_se(mbedtls_se_context* se, mbedtls_x509_crt** cert, char* path, char* pin) {
+	int ret;
+	mbedtls_se_crt_cache_t* entry;
+
+	*cert = NULL;
+
+	mbedtls_se_lock(se, SE_PRIORITY_LOW);
+	if((ret = mbedtls_se_crt_cache_get(se, path, pin, &entry)) == 0) {
+		entry->crt->refs++;
+		*cert = &entry->crt->crt;
+	}
+	mbedtls_se_unlock(se);
+
+	return mbedtls_se_error(se, ret);
+}
+
+void mbedtls_x509_crt_release_se(mbedtls_se_context* se, mbedtls_x509_crt* cert) {
+	if(cert == NULL) {
+		return;
+	}
+
+	mbedtls_se_lock(se, SE_PRIORITY_NORMAL);
+	mbedtls_se_crt_release((mbedtls_se_crt_t*) cert);
+	mbedtls_se_unlock(se);
+}
+
+void mbedtls_se_clear_crt_cache(mbedtls_se_context* se) {
+	mbedtls_se_crt_cache_t* entry;
+
+	mbedtls_se_lock(se, SE_PRIORITY_NORMAL);
+	while(se->crt_cache != NULL) {
+		entry = se->crt_cache;
+		se->crt_cache = entry->next;
+		mbedtls_se_crt_cache_free(entry);
+	}
+	mbedtls_se_unlock(se);
+}
+
+void mbedtls_se_close_session(mbedtls_se_context* se) {
+	mbedtls_se_lock(se, SE_PRIORITY_NORMAL);
+	mbedtls_se_mias_close_session(se);
+	mbedtls_se_unlock(se);
+}
+
+void mbedtls_se_set_timeout(mbedtls_se_context* se, uint32_t timeout_ms) {
+	#ifdef __cplusplus
+	se->iface->setDeadline(timeout_ms ? timeout_ms : SE_WAIT_FOREVER);
+	#else
+	SEInterface_set_deadline(se->iface, timeout_ms ? timeout_ms : SE_WAIT_FOREVER);
+	#endif
+}
+
+void mbedtls_se_save_timeout(mbedtls_se_context* se, se_deadline_t* saved) {
+	#ifdef __cplusplus
+	se->iface->saveDeadline(saved);
+	#else
+	SEInterface_save_deadline(se->iface, saved);
+	#endif
+}
+
+void mbedtls_se_restore_timeout(mbedtls_se_context* se, const se_deadline_t* saved) {
+	#ifdef __cplusplus
+	se->iface->restoreDeadline(saved);
+	#else
+	SEInterface_restore_deadline(se->iface, saved);
+	#endif
+}
+
+static int mbedtls_se_hash_algorithm(mbedtls_md_type_t md_alg, uint8_t* algorithm, size_t* block_size) {
+	switch (md_alg) {
+		case MBEDTLS_MD_SHA1:
+			*algorithm = ALGO_SHA1;
+			*block_size = 64;
+			break;
+		
+		case MBEDTLS_MD_SHA224:
+			*algorithm = ALGO_SHA224;
+			*block_size = 64;
+			break;
+		
+		case MBEDTLS_MD_SHA256:
+			*algorithm = ALGO_SHA256;
+			*block_size = 64;
+			break;
+		
+		case MBEDTLS_MD_SHA384:
+			*algorithm = ALGO_SHA384;
+			*block_size = 128;
+			break;
+		
+		case MBEDTLS_MD_SHA512:
+			*algorithm = ALGO_SHA512;
+			*block_size = 128;
+			break;
+		
+		default:
+			return MBEDTLS_ERR_MD_FEATURE_UNAVAILABLE;
+	}
+
+	return 0;
+}
+
+// Send data to MIAS by PSO HASH, MIAS is expected to be selected.
+static int mbedtls_se_hash_card_update(mbedtls_se_hash_context* ctx, const unsigned char* data, size_t len) {
+	uint16_t l;
+	bool ret;
+
+	while(len > 0) {
+		l = (len > 0xFFFF) ? (uint16_t) ((0xFFFF / ctx->block_size) * ctx->block_size) : (uint16_t) len;
+
+		#ifdef __cplusplus
+		ret = ctx->se->mias->hashUpdate((uint8_t*) data, l);
+		#else
+		ret = MIAS_hash_update(ctx->se->mias, (uint8_t*) data, l);
+		#endif
+
+		if(!ret) {
+			return MBEDTLS_ERR_SE_MIAS_IO_ERROR;
+		}
+
+		data += l;
+		len -= l;
+	}
+
+	return 0;
+}
+
+// Release MIAS once on card hashing is over.
+static void mbedtls_se_hash_card_end(mbedtls_se_hash_context* ctx) {
+	if(ctx->deselect) {
+		#ifdef __cplusplus
+		ctx->se->mias->deselect();
+		#else
+		Applet_deselect((Applet*) ctx->se->mias);
+		#endif
+		ctx->deselect = false;
+	}
+	ctx->started = false;
+	mbedtls_se_unlock(ctx->se);
+}
+
+void mbedtls_se_hash_init(mbedtls_se_hash_context* ctx) {
+	memset(ctx, 0, sizeof(mbedtls_se_hash_context));
+	mbedtls_md_init(&ctx->md);
+}
+
+int mbedtls_se_hash_starts(mbedtls_se_hash_context* ctx, mbedtls_se_context* se, mbedtls_md_type_t md_alg, int mode) {
+	int ret;
+	uint8_t algorithm;
+	bool selected, started;
+
+	if(ctx->started || ((mode != MBEDTLS_SE_HASH_ON_HOST) && ((mode != MBEDTLS_SE_HASH_ON_CARD) || (se == NULL)))) {
+		return MBEDTLS_ERR_MD_BAD_INPUT_DATA;
+	}
+
+	if((ret = mbedtls_se_hash_algorithm(md_alg, &algorithm, &ctx->block_size)) != 0) {
+		return ret;
+	}
+
+	ctx->mode = mode;
+	ctx->md_alg = md_alg;
+	ctx->block_len = 0;
+
+	if(mode == MBEDTLS_SE_HASH_ON_HOST) {
+		mbedtls_md_free(&ctx->md);
+		mbedtls_md_init(&ctx->md);
+		if(((ret = mbedtls_md_setup(&ctx->md, mbedtls_md_info_from_type(md_alg), 0)) != 0) || ((ret = mbedtls_md_starts(&ctx->md)) != 0)) {
+			return ret;
+		}
+		ctx->started = true;
+		return 0;
+	}
+
+	// MIAS is kept selected (in the open session if any) until hashing is finished
+	mbedtls_se_lock(se, SE_PRIORITY_NORMAL);
+	ctx->se = se;
+	ctx->started = true;
+
+	#ifdef __cplusplus
+	if(!(selected = se->mias->isSelected())) {
+		selected = se->mias->select(USE_BASIC_CHANNEL);
+		ctx->deselect = selected;
+	}
+	started = selected && se->mias->hashInit(algorithm);
+	#else
+	if(!(selected = Applet_is_selected((Applet*) se->mias))) {
+		selected = Applet_select((Applet*) se->mias, USE_BASIC_CHANNEL);
+		ctx->deselect = selected;
+	}
+	started = selected && MIAS_hash_init(se->mias, algorithm);
+	#endif
+
+	if(!started) {
+		mbedtls_se_hash_card_end(ctx);
+		return selected ? MBEDTLS_ERR_SE_MIAS_IO_ERROR : MBEDTLS_ERR_SE_MIAS_SELECT_ERROR;
+	}
+
+	return 0;
+}
+
+int mbedtls_se_hash_update(mbedtls_se_hash_context* ctx, const unsigned char* input, size_t ilen) {
+	int ret;
+	size_t l;
+
+	if(!ctx->started) {
+		return MBEDTLS_ERR_MD_BAD_INPUT_DATA;
+	}
+
+	if(ctx->mode == MBEDTLS_SE_HASH_ON_HOST) {
+		return mbedtls_md_update(&ctx->md, input, ilen);
+	}
+
+	// Card expects whole blocks until the last one, incomplete blocks are kept until more data comes
+	if(ctx->block_len > 0) {
+		l = ctx->block_size - ctx->block_len;
+		if(l > ilen) {
+			l = ilen;
+		}
+		memcpy(&ctx->block[ctx->block_len], input, l);
+		ctx->block_len += l;
+		input += l;
+		ilen -= l;
+
+		if(ctx->block_len < ctx->block_size) {
+			return 0;
+		}
+		if((ret = mbedtls_se_hash_card_update(ctx, ctx->block, ctx->block_len)) != 0) {
+			mbedtls_se_hash_card_end(ctx);
+			return ret;
+		}
+		ctx->block_len = 0;
+	}
+
+	l = ilen - (ilen % ctx->block_size);
+	if((ret = mbedtls_se_hash_card_update(ctx, input, l)) != 0) {
+		mbedtls_se_hash_card_end(ctx);
+		return ret;
+	}
+
+	memcpy(ctx->block, &input[l], ilen - l);
+	ctx->block_len = ilen - l;
+
+	return 0;
+}
+
+int mbedtls_se_hash_finish(mbedtls_se_hash_context* ctx, unsigned char* output) {
+	int ret;
+	uint8_t hash[MBEDTLS_MD_MAX_SIZE + 2];
+	uint16_t hash_len;
+	bool done;
+
+	if(!ctx->started) {
+		return MBEDTLS_ERR_MD_BAD_INPUT_DATA;
+	}
+
+	if(ctx->mode == MBEDTLS_SE_HASH_ON_HOST) {
+		ctx->started = false;
+		return mbedtls_md_finish(&ctx->md, output);
+	}
+
+	if((ret = mbedtls_se_hash_card_update(ctx, ctx->block, ctx->block_len)) == 0) {
+		#ifdef __cplusplus
+		done = ctx->se->mias->hashFinal(hash, &hash_len);
+		#else
+		done = MIAS_hash_final(ctx->se->mias, hash, &hash_len);
+		#endif
+
+		if(done && (hash_len == mbedtls_md_get_size(mbedtls_md_info_from_type(ctx->md_alg)))) {
+			memcpy(output, hash, hash_len);
+		}
+		else {
+			ret = MBEDTLS_ERR_SE_MIAS_IO_ERROR;
+		}
+	}
+	ctx->block_len = 0;
+
+	mbedtls_se_hash_card_end(ctx);
+
+	return ret;
+}
+
+int mbedtls_se_hash_sign(mbedtls_se_hash_context* ctx, mbedtls_pk_context* pk, unsigned char* sig, size_t* sig_len, int (*f_rng)(void*, unsigned char*, size_t), void* p_rng) {
+	int ret;
+	unsigned char hash[MBEDTLS_MD_MAX_SIZE];
+
+	if((ret = mbedtls_se_hash_finish(ctx, hash)) != 0) {
+		return ret;
+	}
+
+	return mbedtls_pk_sign(pk, ctx->md_alg, hash, mbedtls_md_get_size(mbedtls_md_info_from_type(ctx->md_alg)), sig, sig_len, f_rng, p_rng);
+}
+
+void mbedtls_se_hash_free(mbedtls_se_hash_context* ctx) {
+	if(ctx->started && (ctx->mode == MBEDTLS_SE_HASH_ON_CARD)) {
+		mbedtls_se_hash_card_end(ctx);
+	}
+	mbedtls_md_free(&ctx->md);
+	memset(ctx, 0, sizeof(mbedtls_se_hash_context));
+}
+
+int mbedtls_pk_parse_se(mbedtls_se_context* se, mbedtls_pk_context* pk, char* path, char* pin) {
+	int ret = MBEDTLS_ERR_SE_BAD_KEY_NAME_ERROR;
+
+	// Read PKey from EF
+	if(memcmp(path, MBEDTLS_SE_EF_KEY_NAME_PREFIX, strlen(MBEDTLS_SE_EF_KEY_NAME_PREFIX)) == 0) {
+		int obj_size;
+		char* obj;
+		
+		// Remove prefix from key path
+		path += strlen(MBEDTLS_SE_EF_KEY_NAME_PREFIX);
+	
+		if((ret = mbedtls_se_read_object(se, path, &obj, &obj_size, pin)) == 0) {
+			ret = mbedtls_pk_parse_key(pk, (const unsigned char*) obj, obj_size, NULL, 0);
+		}
+
+		free(obj);
+	}
+
+	// Read PKey from MIAS P11 Data object
+	else if(memcmp(path, MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX, strlen(MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX)) == 0) {
+		int obj_size;
+		char* obj;
+		
+		// Remove prefix from key path
+		path += strlen(MBEDTLS_SE_MIAS_P11_KEY_NAME_PREFIX);
+		
+		if((ret = mbedtls_se_p11_read_object(se, path, &obj, &obj_size, pin)) == 0) {
+			ret = mbedtls_pk_parse_key(pk, (const unsigned char*) obj, obj_size, NULL, 0);
+		}
+
+		free(obj);
+	}
+	
+	// Read PKey from MIAS
+	else if(memcmp(path, MBEDTLS_SE_MIAS_KEY_NAME_PREFIX, strlen(MBEDTLS_SE_MIAS_KEY_NAME_PREFIX)) == 0) {
+		uint8_t cid;
+		mias_key_pair_t* kp;
+		mias_key_t* mias_key;
+		mias_key_t* key;
+		
+		// Remove prefix from key path
+		path += strlen(MBEDTLS_SE_MIAS_KEY_NAME_PREFIX);
+		
+		// NOTE: for unknown reason a call to mbedtls_pk_parse_key need to be done even if useless in that case, 
+		//       otherwise a compil error will occur!
+		// ToDo: Investigate this to avoid calling mbedtls_pk_parse_key.
+		mbedtls_pk_parse_key(pk, NULL, 0, NULL, 0);
+		
+		mias_key = (mias_key_t*) malloc(sizeof(mias_key_t));
+		mias_key->pin = (char*) malloc((strlen(pin) + 1) * sizeof(char));
+		memcpy(mias_key->pin, pin, strlen(pin) + 1);
+		mias_key->se = se;
+		mias_key->next = NULL;
+		
+		cid = 0;
+		while(*path) {
+			cid *= 10;
+			cid += *path - '0';
+			path++;
+		}
+		
+		kp = NULL;
+		mbedtls_se_lock(se, SE_PRIORITY_NORMAL);
+		#ifdef __cplusplus
+		if(se->mias->select(USE_BASIC_CHANNEL)) {
+			se->mias->getKeyPairByContainerId(cid, &kp);
+			mbedtls_se_save_cache(se);
+		}
+		se->mias->deselect();
+		#else
+		if(Applet_select((Applet*) se->mias, USE_BASIC_CHANNEL)) {
+			MIAS_get_key_pair_by_container_id(se->mias, cid, &kp);
+			mbedtls_se_save_cache(se);
+		}
+		Applet_deselect((Applet*) se->mias);
+		#endif
+		if(kp) {
+			mias_key->kid = kp->kid;
+			mias_key->flags = kp->flags;
+			mias_key->size_in_bits = kp->size_in_bits;
+		}
+		mbedtls_se_unlock(se);
+				
+		if(kp && (mias_key->flags & ECC_KEY_PAIR_FLAG)) {
+			// Key context is owned by the PK context
+			if((ret = mbedtls_pk_setup(pk, &mbedtls_mias_pk_ecdsa_info)) == 0) {
+				*((mias_key_t*) pk->pk_ctx) = *mias_key;
+			}
+			else {
+				free(mias_key->pin);
+			}
+			free(mias_key);
+		}
+		else if(kp) {
+			// RSA alt key is not freed with the PK context: it is kept by the SE context, and shared by
+			// the PK contexts of the same key (e.g. one per connection)
+			mbedtls_se_lock(se, SE_PRIORITY_NORMAL);
+			for(key = se->rsa_keys; key != NULL; key = key->next) {
+				if((key->kid == mias_key->kid) && (strcmp(key->pin, mias_key->pin) == 0)) {
+					break;
+				}
+			}
+			if(key != NULL) {
+				free(mias_key->pin);
+				free(mias_key);
+				mias_key = key;
+			}
+			else {
+				mias_key->next = se->rsa_keys;
+				se->rsa_keys = mias_key;
+			}
+			mbedtls_se_unlock(se);
+
+			return mbedtls_pk_setup_rsa_alt(pk, mias_key, mbedtls_mias_pk_rsa_alt_decrypt, mbedtls_mias_pk_rsa_alt_sign, mbedtls_mias_pk_rsa_alt_key_len);
+		}
+		else {
+			free(mias_key->pin);
+			free(mias_key);
+		}
+	}
+	
+	return mbedtls_se_error(se, ret);
+}
@@ -1,50 +1,133 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#ifndef __AT_INTERFACE_H__
-#define __AT_INTERFACE_H__
-
-#include "Serial.h"
-
-class ATInterface {
-	public:
-
-		ATInterface(Serial* serial);
-		virtual ~ATInterface(void);
-
-		bool open(void);
-		void close(void);
-
-		bool sendATCSIM(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen);
-
-	protected:
-		bool bytesArray2HexString(uint8_t* bytes, uint16_t bytesLen, uint8_t* hexstr, uint16_t* hexstrLen);
-		bool hexString2BytesArray(uint8_t* hexstr, uint16_t hexstrLen, uint8_t* bytes, uint16_t* bytesLen);
-		bool readLine(char* data, unsigned long int* len);
-
-	private:
-		Serial* _serial;
-
-};
-
-#endif /* __AT_INTERFACE_H__ */
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __AT_INTERFACE_H__
+#define __AT_INTERFACE_H__
+
+#include "Serial.h"
+#include "SEInterface.h"
+
+// AT+CSIM command or response line: hex encoded APDU or response, and its framing.
+#define AT_CSIM_BUFFER_SIZE            (32 + 2 * (APDU_EXT_DATA_OFFSET + SE_MAX_DATA_LENGTH + 2))
+
+// Time to wait for each line of a response, in ms.
+#ifndef AT_RESPONSE_TIMEOUT
+#define AT_RESPONSE_TIMEOUT            5000
+#endif
+
+// Command sent after a failed exchange, its response tells that everything before was drained.
+#define AT_RESYNC_COMMAND              "AT+CMEE?\r\n"
+#define AT_RESYNC_RESPONSE             "+CMEE: "
+
+// Maximum number of unsolicited result code handlers.
+#ifndef AT_URC_MAX_HANDLERS
+#define AT_URC_MAX_HANDLERS            8
+#endif
+
+// Longest time poll holds the channel while waiting, in ms, not to delay exchanges of other threads.
+#define AT_URC_POLL_PERIOD             20
+
+// Handler of an unsolicited result code, called with the line without its CR LF. It runs on the
+// thread reading the channel, which is held meanwhile: it must not send AT commands.
+typedef void (*at_urc_handler_t)(void* ctx, const char* line, unsigned long int len);
+
+// Unsolicited result code handler, keyed by the DJB2 hash of the URC name.
+typedef struct {
+	uint32_t hash;
+	at_urc_handler_t handler;
+	void* ctx;
+} at_urc_entry_t;
+
+class ATInterface {
+	public:
+
+		ATInterface(Serial* serial);
+		virtual ~ATInterface(void);
+
+		bool open(void);
+		void close(void);
+
+		// Transmit an APDU with AT+CSIM and wait up to timeout ms (SERIAL_WAIT_FOREVER for no limit)
+		// for the whole response, each line being waited for up to AT_RESPONSE_TIMEOUT ms.
+		// ResponseLen parameter is the response buffer size on input, the response length on output.
+		// Returns true in case the response was received, false otherwise (timeout or error).
+		bool sendATCSIM(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t timeout);
+
+		// Route the unsolicited result codes with the given name (e.g. "+CREG:", "RING") to handler,
+		// in place of the handler already registered for it. The name of a line is its text up to the
+		// first ':' included, or the whole line. Lines received during an exchange which are not part
+		// of its response and have no handler are dropped.
+		// Returns true in case handler was registered, false otherwise (AT_URC_MAX_HANDLERS reached).
+		bool addUrcHandler(const char* name, at_urc_handler_t handler, void* ctx);
+
+		// Stop routing the unsolicited result codes with the given name.
+		void removeUrcHandler(const char* name);
+
+		// Dispatch the unsolicited result codes received while no exchange is running, waiting up to
+		// timeout ms (SERIAL_WAIT_FOREVER for no limit) for the first one.
+		// Returns true in case lines were received, false otherwise (timeout or error).
+		bool poll(uint32_t timeout);
+
+	protected:
+		// Read a response line before the deadline of the current exchange. Len parameter is the
+		// data buffer size on input, the line length on output.
+		// Returns true in case a line was read, false otherwise (timeout or error).
+		bool readLine(char* data, unsigned long int* len);
+
+		// Drain what is left of a failed exchange (late response, unsolicited result codes), so
+		// that it is not taken for the response of the next command.
+		// Returns true in case the modem answered AT_RESYNC_COMMAND, false otherwise.
+		bool resync(void);
+
+		// Exchange of sendATCSIM, once the channel is held.
+		// Returns true in case the response was received, false otherwise (timeout or error).
+		bool exchange(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t timeout);
+
+		// Route line to its handler in case it is a registered unsolicited result code. Len parameter
+		// is the line length, CR LF included.
+		// Returns true in case line was handled, false otherwise.
+		bool dispatch(char* line, unsigned long int len);
+
+	private:
+		Serial* _serial;
+		char _buf[AT_CSIM_BUFFER_SIZE];
+
+		bool _bounded;
+		uint32_t _deadline;        // Timestamp in ms, when bounded
+		bool _resync;              // Last exchange did not complete
+
+		at_urc_entry_t _urc[AT_URC_MAX_HANDLERS];
+		uint8_t _urcCount;
+		#ifdef SE_THREAD_SUPPORT
+		pthread_mutex_t _mutex;    // Exchanges, polling and handlers
+		#endif
+
+		// Returns the DJB2 hash of the URC name of line, len being the line length without CR LF.
+		static uint32_t hash(const char* line, unsigned long int len);
+
+		// Returns true in case line is a final error result code (ERROR or +CME ERROR), false otherwise.
+		static bool isError(const char* line);
+
+};
+
+#endif /* __AT_INTERFACE_H__ */
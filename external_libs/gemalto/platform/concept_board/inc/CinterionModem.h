@@ -1,52 +1,74 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#ifndef __CINTERION_MODEM_H__
-#define __CINTERION_MODEM_H__
-
-#include "ATInterface.h"
-#include "SEInterface.h"
-
-class CinterionModem: public SEInterface {
-	public:
-		// Create an instance of Cinterion Modem.
-		CinterionModem(void);
-		~CinterionModem(void);
-
-		bool open(void) {
-			return _at.open();
-		}
-
-		void close(void) {
-			_at.close();
-		}
-
-	protected:
-
-		bool transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen);
-
-	private:
-		ATInterface _at;
-};
-
-#endif /* __CINTERION_MODEM_H__ */
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __CINTERION_MODEM_H__
+#define __CINTERION_MODEM_H__
+
+#include "ATInterface.h"
+#include "LSerial.h"
+#include "SEInterface.h"
+
+class CinterionModem: public SEInterface {
+	public:
+		// Create an instance of Cinterion Modem.
+		CinterionModem(void);
+		// Create an instance of Cinterion Modem on the given serial line.
+		CinterionModem(const lserial_config_t* config);
+		~CinterionModem(void);
+
+		bool open(void) {
+			return _at.open();
+		}
+
+		void close(void) {
+			_at.close();
+		}
+
+		// Route unsolicited result codes of the modem (network registration, SIM refresh...) to
+		// handler. They are dispatched while APDU are exchanged, and by pollUrc in between.
+		// Returns true in case handler was registered, false otherwise.
+		bool addUrcHandler(const char* name, at_urc_handler_t handler, void* ctx) {
+			return _at.addUrcHandler(name, handler, ctx);
+		}
+
+		void removeUrcHandler(const char* name) {
+			_at.removeUrcHandler(name);
+		}
+
+		// Dispatch the unsolicited result codes received while no APDU is exchanged, waiting up to
+		// timeout ms for the first one.
+		// Returns true in case lines were received, false otherwise.
+		bool pollUrc(uint32_t timeout) {
+			return _at.poll(timeout);
+		}
+
+	protected:
+
+		bool transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t timeout);
+
+	private:
+		LSerial _serial;
+		ATInterface _at;
+};
+
+#endif /* __CINTERION_MODEM_H__ */
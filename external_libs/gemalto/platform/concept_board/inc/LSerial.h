@@ -1,45 +1,92 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#ifndef __LSERIAL_H__
-#define __LSERIAL_H__
-
-#include "Serial.h"
-
-class LSerial: public Serial {
-	public:
-		// Create an instance of WSerial.
-		LSerial(void);
-		~LSerial(void);
-
-		bool start(void);
-		bool send(char* data, unsigned long  int toWrite, unsigned long  int* written);
-		bool recv(char* data, unsigned long int toRead, unsigned long  int* read);
-		bool stop(void);
-
-	private:
-		int32_t m_uart;
-
-};
-
-#endif /* __LSERIAL_H__ */
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __LSERIAL_H__
+#define __LSERIAL_H__
+
+#include "Serial.h"
+
+#define LSERIAL_DEFAULT_DEVICE         "/dev/ttyACM3"
+#define LSERIAL_DEFAULT_BAUDRATE       115200
+
+// Time to wait for the modem to answer while probing the line speed, in ms.
+#ifndef LSERIAL_PROBE_TIMEOUT
+#define LSERIAL_PROBE_TIMEOUT          300
+#endif
+
+// Serial line configuration.
+typedef struct {
+	const char* device;
+	uint32_t    baudrate;      // 0 to probe the fastest line speed the modem accepts
+	uint8_t     data_bits;     // 5 to 8
+	char        parity;        // 'N', 'E' or 'O'
+	uint8_t     stop_bits;     // 1 or 2
+	bool        flow_control;  // RTS/CTS hardware flow control
+} lserial_config_t;
+
+class LSerial: public Serial {
+	public:
+		// Create an instance of LSerial, on LSERIAL_DEFAULT_DEVICE at LSERIAL_DEFAULT_BAUDRATE 8N1.
+		LSerial(void);
+		// Create an instance of LSerial with the given configuration, device path must stay valid.
+		LSerial(const lserial_config_t* config);
+		~LSerial(void);
+
+		// Open and configure the serial device, then probe the line speed if requested.
+		// Returns true in case the serial line is ready, false otherwise, also if the configured line
+		// speed is not supported.
+		bool start(void);
+		bool send(char* data, unsigned long  int toWrite, unsigned long  int* written);
+		bool stop(void);
+
+		// Change the line speed of the serial device, modem side is not changed.
+		// Returns true in case line speed is supported, false otherwise.
+		bool setBaudrate(uint32_t baudrate);
+
+		// Returns the current line speed.
+		uint32_t getBaudrate(void);
+
+		// Find the line speed the modem currently uses, then switch both sides with AT+IPR to the
+		// fastest one the modem and the serial device accept. USB CDC devices (ttyACM) run at
+		// native speed whatever the line speed, they are not probed.
+		// Returns true in case the modem answers at the selected line speed, false otherwise.
+		bool probe(void);
+
+		uint32_t getTime(void);
+
+	protected:
+		// Wait for incoming bytes with poll instead of spinning on read.
+		long int receive(char* data, unsigned long int size, uint32_t timeout);
+
+	private:
+		// Send an AT command and wait for its final result.
+		// Returns true in case the modem answered OK, false otherwise.
+		bool command(const char* cmd, uint32_t timeout);
+
+		int32_t m_uart;
+		lserial_config_t _config;
+		uint32_t _baudrate;
+
+};
+
+#endif /* __LSERIAL_H__ */
@@ -1,47 +1,83 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#ifndef __SERIAL_H__
-#define __SERIAL_H__
-
-#include <stdint.h>
-
-class Serial {
-	public:
-
-		Serial(void);
-		virtual ~Serial(void);
-
-		virtual bool start(void) = 0;
-		virtual bool send(char* data, unsigned long  int toWrite, unsigned long  int* written) = 0;
-		virtual bool recv(char* data, unsigned long int toRead, unsigned long  int* read) = 0;
-		virtual bool stop(void) = 0;
-
-	protected:
-		bool bytesArray2HexString(uint8_t* bytes, uint16_t bytesLen, uint8_t* hexstr, uint16_t* hexstrLen);
-		bool hexString2BytesArray(uint8_t* hexstr, uint16_t hexstrLen, uint8_t* bytes, uint16_t* bytesLen);
-		bool readLine(char* data, unsigned long int* len);
-
-};
-
-#endif /* __SERIAL_H__ */
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __SERIAL_H__
+#define __SERIAL_H__
+
+#include <stdint.h>
+
+// Size of the receive buffer, a power of 2. Lines are framed over the buffered bytes, so that
+// the low layer is read in chunks instead of byte by byte.
+#ifndef SERIAL_RX_BUFFER_SIZE
+#define SERIAL_RX_BUFFER_SIZE          1024
+#endif
+
+// Timeout waiting without limit.
+#define SERIAL_WAIT_FOREVER            0xFFFFFFFF
+
+class Serial {
+	public:
+
+		Serial(void);
+		virtual ~Serial(void);
+
+		virtual bool start(void) = 0;
+		virtual bool send(char* data, unsigned long  int toWrite, unsigned long  int* written) = 0;
+		virtual bool stop(void) = 0;
+
+		// Receive toRead bytes, from the receive buffer first, waiting for them as long as needed.
+		// Returns true in case reception was successful, false otherwise.
+		virtual bool recv(char* data, unsigned long int toRead, unsigned long  int* read);
+
+		// Read a line terminated by '\n' (included), waiting up to timeout ms for it.
+		// Len parameter is the data buffer size on input, the line length on output. A line longer
+		// than the data buffer or the receive buffer is returned in several parts.
+		// Returns true in case a line was read, false otherwise (timeout or error).
+		bool readLine(char* data, unsigned long int* len, uint32_t timeout);
+
+		// Drop the bytes received so far, e.g. the rest of a response which timed out.
+		void flush(void);
+
+		// Returns a monotonic timestamp in ms.
+		virtual uint32_t getTime(void) = 0;
+
+	protected:
+		// Low layer implementation to read the bytes available, waiting up to timeout ms for at least one.
+		// Returns the number of bytes read, 0 in case of timeout, -1 in case of error.
+		virtual long int receive(char* data, unsigned long int size, uint32_t timeout) = 0;
+
+	private:
+		// Receive the bytes available into the receive buffer, waiting up to timeout ms for at least one.
+		// Returns true in case bytes were received, false otherwise.
+		bool fill(uint32_t timeout);
+
+		// Move len bytes from the receive buffer to data.
+		void take(char* data, uint32_t len);
+
+		// Free running indexes, wrapped on access
+		char _rx[SERIAL_RX_BUFFER_SIZE];
+		uint32_t _rxHead;
+		uint32_t _rxTail;
+};
+
+#endif /* __SERIAL_H__ */
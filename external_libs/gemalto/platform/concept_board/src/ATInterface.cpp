@@ -1,173 +1,370 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *  
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#include "ATInterface.h"
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-
-//#define AT_DEBUG
-
-ATInterface::ATInterface(Serial* serial) {
-	_serial = serial;
-}
-
-ATInterface::~ATInterface(void) {
-
-}
-
-bool ATInterface::open(void) {
-	return _serial->start();
-}
-
-void ATInterface::close(void) {
-	_serial->stop();
-}
-
-bool ATInterface::bytesArray2HexString(uint8_t* bytes, uint16_t bytesLen, uint8_t* hexstr, uint16_t* hexstrLen) {
-	const uint8_t* hex = (const uint8_t*) "0123456789ABCDEF";
-	uint16_t i;
-
-	*hexstrLen = 0;
-	for(i = 0; i < bytesLen; i++, *hexstrLen += 2) {
-		*hexstr = hex[(bytes[i] >> 4) & 0xF];
-		hexstr++;
-		*hexstr = hex[bytes[i] & 0xF];
-		hexstr++;
-	}
-
-	return true;
-}
-
-bool ATInterface::hexString2BytesArray(uint8_t* hexstr, uint16_t hexstrLen, uint8_t* bytes, uint16_t* bytesLen) {
-	uint8_t d;
-	uint16_t i, j;
-
-	*bytesLen = 0;
-	for(i = 0; i < hexstrLen; *bytesLen += 1) {
-		d = 0;
-		for(j = i + 2; i < j; i++) {
-			d <<= 4;
-			if((hexstr[i] >= '0') && (hexstr[i] <= '9')) {
-				d |= hexstr[i] - '0';
-			}
-			else if((hexstr[i] >= 'a') && (hexstr[i] <= 'f')) {
-				d |= hexstr[i] - 'a' + 10;
-			}
-			else if((hexstr[i] >= 'A') && (hexstr[i] <= 'F')) {
-				d |= hexstr[i] - 'A' + 10;
-			}
-		}
-		*bytes = d;
-		bytes++;
-	}
-
-	return true;
-}
-
-bool ATInterface::readLine(char* data, unsigned long int* len) {
-	unsigned long int off;
-	unsigned long int read;
-
-	off = 0;
-	read = 0;
-	do {
-		if(!_serial->recv(&data[off], 1, &read)) {
-			return false;
-		}
-		if(read) {
-			off += read;
-			if(data[off - 1] == '\n') {
-				break;
-			}
-		}
-	} while(1);
-
-	*len = off;
-	return true;
-}
-
-bool ATInterface::sendATCSIM(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen) {
-	char* buf;
-	uint16_t i;
-	unsigned long int off, len;
-
-	#ifdef AT_DEBUG
-	printf("SND: ");
-	for(i=0; i<apduLen; i++) {
-		printf("%02X", apdu[i]);
-	}
-	printf("\n");
-	#endif
-
-	off = 0;
-	buf = (char*) malloc(537 * sizeof(char));
-
-	off += sprintf(&buf[off], "AT+CSIM=%d,\"", apduLen * 2);
-	for(i=0; i<apduLen; i++) {
-		off += sprintf(&buf[off], "%02X", apdu[i]);
-	}
-	off += sprintf(&buf[off], "\"\r\n");
-
-	_serial->send(buf, off, &len);
-	memset(buf, 0, sizeof(buf));
-
-	do {
-		readLine(buf, &len);
-		if(memcmp(buf, "ERROR\r\n", 7) == 0) {
-			return false;
-		}
-	} while((memcmp(buf, "+CSIM: ", 7) != 0));
-
-	off = 7;
-	*responseLen = 0;
-	while(buf[off] != ',') {
-		*responseLen *= 10;
-		*responseLen += buf[off] - '0';
-		off++;
-	}
-
-	while( !(((buf[off] >= '0') && (buf[off] <= '9')) ||
-		   ((buf[off] >= 'A') && (buf[off] <= 'F')) ||
-		   ((buf[off] >= 'a') && (buf[off] <= 'f'))
-		   )) {
-		off++;
-	}
-
-	hexString2BytesArray((uint8_t*) &buf[off], *responseLen, response, responseLen);
-
-	do {
-		readLine(buf, &len);
-	} while(memcmp(buf, "OK\r\n", 4) != 0);
-
-	#ifdef AT_DEBUG
-	printf("RCV: ");
-	for(i=0; i<*responseLen; i++) {
-		printf("%02X", response[i]);
-	}
-	printf("\n");
-	#endif
-
-	free(buf);
-	return true;
-}
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#include "ATInterface.h"
+#include "Hex.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+//#define AT_DEBUG
+
+ATInterface::ATInterface(Serial* serial) {
+	_serial = serial;
+	_bounded = false;
+	_deadline = 0;
+	_resync = false;
+	_urcCount = 0;
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_init(&_mutex, NULL);
+	#endif
+}
+
+ATInterface::~ATInterface(void) {
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_destroy(&_mutex);
+	#endif
+}
+
+bool ATInterface::open(void) {
+	return _serial->start();
+}
+
+void ATInterface::close(void) {
+	_serial->stop();
+}
+
+bool ATInterface::readLine(char* data, unsigned long int* len) {
+	unsigned long int size = *len;
+	unsigned long int part;
+	uint32_t timeout, left;
+
+	// Extended responses are longer than the serial buffer and come in several parts
+	*len = 0;
+	do {
+		// Once the deadline expired, only lines already received are returned
+		timeout = AT_RESPONSE_TIMEOUT;
+		if(_bounded) {
+			left = _deadline - _serial->getTime();
+			if((int32_t) left < 0) {
+				left = 0;
+			}
+			if(left < timeout) {
+				timeout = left;
+			}
+		}
+
+		part = size - *len;
+		if(!_serial->readLine(&data[*len], &part, timeout)) {
+			return false;
+		}
+		*len += part;
+	} while((data[*len - 1] != '\n') && (*len < size));
+
+	return true;
+}
+
+bool ATInterface::resync(void) {
+	unsigned long int len;
+
+	if(!_serial->send((char*) AT_RESYNC_COMMAND, strlen(AT_RESYNC_COMMAND), &len)) {
+		return false;
+	}
+
+	// Late response of the failed command and unsolicited result codes come first. A modem without
+	// AT+CMEE only answers an error, anything left after it is skipped by the next exchange anyway.
+	while(1) {
+		len = sizeof(_buf) - 1;
+		if(!readLine(_buf, &len)) {
+			return false;
+		}
+		_buf[len] = '\0';
+		if(isError(_buf)) {
+			_resync = false;
+			return true;
+		}
+		if(memcmp(_buf, AT_RESYNC_RESPONSE, strlen(AT_RESYNC_RESPONSE)) == 0) {
+			break;
+		}
+		dispatch(_buf, len);
+	}
+
+	while(1) {
+		len = sizeof(_buf) - 1;
+		if(!readLine(_buf, &len)) {
+			return false;
+		}
+		_buf[len] = '\0';
+		if((memcmp(_buf, "OK\r\n", 4) == 0) || isError(_buf)) {
+			break;
+		}
+		dispatch(_buf, len);
+	}
+
+	_resync = false;
+	return true;
+}
+
+bool ATInterface::isError(const char* line) {
+	return (memcmp(line, "ERROR\r\n", 7) == 0) || (memcmp(line, "+CME ERROR:", 11) == 0);
+}
+
+uint32_t ATInterface::hash(const char* line, unsigned long int len) {
+	uint32_t h = 5381;
+	unsigned long int i;
+
+	// Same DJB2 hash as the Connect Shield AT parser, over the name only
+	for(i=0; i<len; i++) {
+		h = ((h << 5) + h) + (uint8_t) line[i];
+		if(line[i] == ':') {
+			break;
+		}
+	}
+
+	return h;
+}
+
+bool ATInterface::dispatch(char* line, unsigned long int len) {
+	uint32_t h;
+	uint8_t i;
+
+	while((len > 0) && ((line[len - 1] == '\n') || (line[len - 1] == '\r'))) {
+		len--;
+	}
+	if(len == 0) {
+		return false;
+	}
+	line[len] = '\0';
+
+	h = hash(line, len);
+	for(i=0; i<_urcCount; i++) {
+		if(_urc[i].hash == h) {
+			_urc[i].handler(_urc[i].ctx, line, len);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ATInterface::addUrcHandler(const char* name, at_urc_handler_t handler, void* ctx) {
+	uint32_t h = hash(name, strlen(name));
+	uint8_t i;
+	bool ret = true;
+
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_lock(&_mutex);
+	#endif
+	for(i=0; (i<_urcCount) && (_urc[i].hash != h); i++);
+	if(i == _urcCount) {
+		if(_urcCount < AT_URC_MAX_HANDLERS) {
+			_urcCount++;
+		}
+		else {
+			ret = false;
+		}
+	}
+	if(ret) {
+		_urc[i].hash = h;
+		_urc[i].handler = handler;
+		_urc[i].ctx = ctx;
+	}
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_unlock(&_mutex);
+	#endif
+
+	return ret;
+}
+
+void ATInterface::removeUrcHandler(const char* name) {
+	uint32_t h = hash(name, strlen(name));
+	uint8_t i;
+
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_lock(&_mutex);
+	#endif
+	for(i=0; i<_urcCount; i++) {
+		if(_urc[i].hash == h) {
+			_urc[i] = _urc[--_urcCount];
+			break;
+		}
+	}
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_unlock(&_mutex);
+	#endif
+}
+
+bool ATInterface::poll(uint32_t timeout) {
+	unsigned long int len;
+	uint32_t start, elapsed, wait;
+	bool received = false;
+
+	start = _serial->getTime();
+	elapsed = 0;
+	do {
+		// Channel is released between short waits, an exchange of another thread goes first
+		wait = timeout - elapsed;
+		if(wait > AT_URC_POLL_PERIOD) {
+			wait = AT_URC_POLL_PERIOD;
+		}
+
+		#ifdef SE_THREAD_SUPPORT
+		pthread_mutex_lock(&_mutex);
+		#endif
+		_bounded = true;
+		_deadline = _serial->getTime() + wait;
+		while(1) {
+			len = sizeof(_buf) - 1;
+			if(!readLine(_buf, &len)) {
+				break;
+			}
+			_buf[len] = '\0';
+
+			// Blank lines only frame the result codes
+			if((len > 2) || ((_buf[0] != '\r') && (_buf[0] != '\n'))) {
+				dispatch(_buf, len);
+				received = true;
+			}
+		}
+		#ifdef SE_THREAD_SUPPORT
+		pthread_mutex_unlock(&_mutex);
+		#endif
+
+		elapsed = _serial->getTime() - start;
+	} while(!received && ((timeout == SERIAL_WAIT_FOREVER) || (elapsed < timeout)));
+
+	return received;
+}
+
+bool ATInterface::sendATCSIM(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t timeout) {
+	bool ret;
+
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_lock(&_mutex);
+	#endif
+	ret = exchange(apdu, apduLen, response, responseLen, timeout);
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_unlock(&_mutex);
+	#endif
+
+	return ret;
+}
+
+bool ATInterface::exchange(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t timeout) {
+	unsigned long int off, len;
+	uint16_t hexLen;
+
+	#ifdef AT_DEBUG
+	uint16_t i;
+	printf("SND: ");
+	for(i=0; i<apduLen; i++) {
+		printf("%02X", apdu[i]);
+	}
+	printf("\n");
+	#endif
+
+	// Command and response are hex encoded: "AT+CSIM=<len>,\"<apdu>\"\r\n" and "+CSIM: <len>,\"<response>\"\r\n"
+	if((32 + 2 * (unsigned long int) apduLen) > sizeof(_buf)) {
+		return false;
+	}
+
+	_bounded = (timeout != SERIAL_WAIT_FOREVER);
+	_deadline = _serial->getTime() + timeout;
+
+	// Leftovers of a previous response must not be taken for this one
+	if(_resync && !resync()) {
+		return false;
+	}
+
+	off = sprintf(_buf, "AT+CSIM=%d,\"", apduLen * 2);
+	hex_encode(apdu, apduLen, &_buf[off]);
+	off += 2 * apduLen;
+	memcpy(&_buf[off], "\"\r\n", 3);
+	off += 3;
+
+	if(!_serial->send(_buf, off, &len)) {
+		return false;
+	}
+
+	// Until OK is received, the exchange has to be drained before the next one. Unsolicited result
+	// codes received meanwhile go to their handlers.
+	_resync = true;
+	while(1) {
+		len = sizeof(_buf) - 1;
+		if(!readLine(_buf, &len)) {
+			return false;
+		}
+		_buf[len] = '\0';
+		if(isError(_buf)) {
+			_resync = false;
+			return false;
+		}
+		if(memcmp(_buf, "+CSIM: ", 7) == 0) {
+			break;
+		}
+		dispatch(_buf, len);
+	}
+
+	off = 7;
+	hexLen = 0;
+	while((_buf[off] >= '0') && (_buf[off] <= '9')) {
+		hexLen = (hexLen * 10) + (_buf[off] - '0');
+		off++;
+	}
+	while((_buf[off] == ',') || (_buf[off] == '"') || (_buf[off] == ' ')) {
+		off++;
+	}
+
+	// Response must be complete and fit the caller buffer
+	if(((off + hexLen) > len) || ((hexLen / 2) > *responseLen) || !hex_decode(&_buf[off], hexLen, response)) {
+		return false;
+	}
+	*responseLen = hexLen / 2;
+
+	while(1) {
+		len = sizeof(_buf) - 1;
+		if(!readLine(_buf, &len)) {
+			return false;
+		}
+		_buf[len] = '\0';
+		if(memcmp(_buf, "OK\r\n", 4) == 0) {
+			break;
+		}
+		if(isError(_buf)) {
+			_resync = false;
+			return false;
+		}
+		dispatch(_buf, len);
+	}
+	_resync = false;
+
+	#ifdef AT_DEBUG
+	printf("RCV: ");
+	for(i=0; i<*responseLen; i++) {
+		printf("%02X", response[i]);
+	}
+	printf("\n");
+	#endif
+
+	return true;
+}
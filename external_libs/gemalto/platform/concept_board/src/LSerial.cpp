@@ -1,158 +1,350 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *  
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#include "LSerial.h"
-#include <cstdio>
-#include <cstring>
-
-#include <termios.h>
-#include <unistd.h>
-#include <fcntl.h>
-
-//#define SERIAL_DEBUG
-
-LSerial::LSerial(void) {
-	m_uart = -1;
-}
-
-LSerial::~LSerial(void) {
-}
-
-
-bool LSerial::start(void) {
-	printf("Opening serial port...");
-
-	char* uart = (char*) "/dev/ttyACM3";
-	int port;
-	struct termios serial;
-
-	if((m_uart = open(uart, O_RDWR | O_NOCTTY | O_NDELAY)) >= 0) {
-		tcgetattr(m_uart, &serial);
-
-		serial.c_iflag = 0;
-		serial.c_oflag = 0;
-		serial.c_lflag = 0;
-		serial.c_cflag = 0;
-
-		serial.c_cc[VMIN] = 0;
-		serial.c_cc[VTIME] = 0;
-
-		serial.c_cflag = B115200 | CS8 | CREAD;
-
-		tcsetattr(m_uart, TCSANOW, &serial); // Apply configuration
-		fcntl(m_uart, F_SETFL, 0);
-
-		printf("Found serial %s %d\r\n", uart, m_uart);
-		return true;
-	}
-	
-	return false;
-}
-
-bool LSerial::send(char* data, unsigned long int toWrite, unsigned long  int* size) {
-	unsigned long int i;
-	int w;
-	
-	if(m_uart < 0) {
-		return false;
-	}
-	
-	for(i=0; i<toWrite;) {
-		w = write(m_uart, &data[i], (toWrite - i));
-		if(w == -1) {
-			return false;
-		}
-		else if(w) {
-			i += w;
-		}
-		
-	}
-
-	*size = toWrite;
-
-	
-	#ifdef SERIAL_DEBUG
-	if(*size) {
-		unsigned long int i;
-		printf("> ");
-		for(i=0; i<*size; i++) {
-			if((data[i] != '\r') && (data[i] != '\n')) {
-				printf("%c", data[i]);
-			}
-		}
-		printf("\n");
-
-	}
-	#endif
-	
-	return true;
-}
-
-bool LSerial::recv(char* data, unsigned long int toRead, unsigned long int* size) {
-	unsigned long int i;
-	int r;
-	
-	if(m_uart < 0) {
-		return false;
-	}
-	
-	for(i=0; i<toRead;) {
-		r = read(m_uart, &data[i], (toRead - i));
-		if(r == -1) {
-			return false;
-		}
-		else if(r) {
-			i += r;
-		}
-		
-	}
-
-	*size = toRead;
-
-	
-	#ifdef SERIAL_DEBUG
-	if(*size) {
-		unsigned long int i;
-		printf("< ");
-		for(i=0; i<*size; i++) {
-			if((data[i] != '\r') && (data[i] != '\n')) {
-				printf("%c", data[i]);
-			}
-		}
-		printf("\n");
-
-	}
-	#endif
-	
-	return true;
-}
-
-bool LSerial::stop(void) {
-	printf("Closing serial port...");
-	if(m_uart >= 0) {
-		close(m_uart);
-	}
-	printf("OK\n");
-	return true;
-}
-
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#include "LSerial.h"
+#include <cstdio>
+#include <cstring>
+
+#include <termios.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <time.h>
+
+//#define SERIAL_DEBUG
+
+// Line speeds tried by probe, fastest first.
+static const uint32_t LSERIAL_BAUDRATES[] = {
+	921600, 460800, 230400, 115200, 57600, 38400, 19200, 9600
+};
+
+#define LSERIAL_BAUDRATES_COUNT        (sizeof(LSERIAL_BAUDRATES) / sizeof(LSERIAL_BAUDRATES[0]))
+
+// Returns the termios speed of the given line speed, B0 in case it is not supported.
+static speed_t baudrate2speed(uint32_t baudrate) {
+	switch(baudrate) {
+		case 9600:    return B9600;
+		case 19200:   return B19200;
+		case 38400:   return B38400;
+		case 57600:   return B57600;
+		case 115200:  return B115200;
+		case 230400:  return B230400;
+		#ifdef B460800
+		case 460800:  return B460800;
+		#endif
+		#ifdef B921600
+		case 921600:  return B921600;
+		#endif
+		default:      return B0;
+	}
+}
+
+LSerial::LSerial(void) {
+	m_uart = -1;
+	_config.device = LSERIAL_DEFAULT_DEVICE;
+	_config.baudrate = LSERIAL_DEFAULT_BAUDRATE;
+	_config.data_bits = 8;
+	_config.parity = 'N';
+	_config.stop_bits = 1;
+	_config.flow_control = false;
+	_baudrate = 0;
+}
+
+LSerial::LSerial(const lserial_config_t* config) {
+	m_uart = -1;
+	_config = *config;
+	_baudrate = 0;
+}
+
+LSerial::~LSerial(void) {
+}
+
+
+bool LSerial::start(void) {
+	printf("Opening serial port...");
+
+	struct termios serial;
+	uint32_t baudrate = _config.baudrate ? _config.baudrate : LSERIAL_DEFAULT_BAUDRATE;
+
+	// B0 would hang up the line
+	if(baudrate2speed(baudrate) == B0) {
+		printf("Unsupported baudrate %lu\r\n", (unsigned long) baudrate);
+		return false;
+	}
+
+	if((m_uart = open(_config.device, O_RDWR | O_NOCTTY | O_NDELAY)) >= 0) {
+		tcgetattr(m_uart, &serial);
+
+		serial.c_iflag = 0;
+		serial.c_oflag = 0;
+		serial.c_lflag = 0;
+		serial.c_cflag = 0;
+
+		serial.c_cc[VMIN] = 0;
+		serial.c_cc[VTIME] = 0;
+
+		serial.c_cflag = CREAD;
+		switch(_config.data_bits) {
+			case 5:  serial.c_cflag |= CS5; break;
+			case 6:  serial.c_cflag |= CS6; break;
+			case 7:  serial.c_cflag |= CS7; break;
+			default: serial.c_cflag |= CS8; break;
+		}
+		if(_config.parity == 'E') {
+			serial.c_cflag |= PARENB;
+		}
+		else if(_config.parity == 'O') {
+			serial.c_cflag |= PARENB | PARODD;
+		}
+		if(_config.stop_bits == 2) {
+			serial.c_cflag |= CSTOPB;
+		}
+		if(_config.flow_control) {
+			serial.c_cflag |= CRTSCTS;
+		}
+
+		// Probing starts from the usual modem line speed
+		_baudrate = baudrate;
+		cfsetispeed(&serial, baudrate2speed(_baudrate));
+		cfsetospeed(&serial, baudrate2speed(_baudrate));
+
+		tcsetattr(m_uart, TCSANOW, &serial); // Apply configuration
+		fcntl(m_uart, F_SETFL, 0);
+
+		printf("Found serial %s %d\r\n", _config.device, m_uart);
+
+		if(_config.baudrate == 0) {
+			return probe();
+		}
+		return true;
+	}
+	
+	return false;
+}
+
+bool LSerial::setBaudrate(uint32_t baudrate) {
+	struct termios serial;
+	speed_t speed = baudrate2speed(baudrate);
+
+	if((m_uart < 0) || (speed == B0)) {
+		return false;
+	}
+
+	// Pending output is sent at the previous line speed
+	tcdrain(m_uart);
+	if(tcgetattr(m_uart, &serial) != 0) {
+		return false;
+	}
+	cfsetispeed(&serial, speed);
+	cfsetospeed(&serial, speed);
+	if(tcsetattr(m_uart, TCSANOW, &serial) != 0) {
+		return false;
+	}
+
+	_baudrate = baudrate;
+	return true;
+}
+
+uint32_t LSerial::getBaudrate(void) {
+	return _baudrate;
+}
+
+bool LSerial::command(const char* cmd, uint32_t timeout) {
+	char line[64];
+	unsigned long int len;
+	int l;
+
+	l = snprintf(line, sizeof(line), "%s\r", cmd);
+	flush();
+	if(!send(line, l, &len)) {
+		return false;
+	}
+
+	// Echo and intermediate results are skipped
+	do {
+		len = sizeof(line) - 1;
+		if(!readLine(line, &len, timeout)) {
+			return false;
+		}
+		line[len] = '\0';
+	} while((strncmp(line, "OK", 2) != 0) && (strncmp(line, "ERROR", 5) != 0));
+
+	return (line[0] == 'O');
+}
+
+bool LSerial::probe(void) {
+	char cmd[24];
+	uint32_t current;
+	unsigned long int len;
+	uint16_t i;
+
+	if(strncmp(_config.device, "/dev/ttyACM", 11) == 0) {
+		return true;
+	}
+
+	// Modem may have kept the line speed of a previous run
+	current = _baudrate;
+	if(!command("AT", LSERIAL_PROBE_TIMEOUT)) {
+		for(i=0; i<LSERIAL_BAUDRATES_COUNT; i++) {
+			if(setBaudrate(LSERIAL_BAUDRATES[i]) && command("AT", LSERIAL_PROBE_TIMEOUT)) {
+				break;
+			}
+		}
+		if(i == LSERIAL_BAUDRATES_COUNT) {
+			printf("ERROR: Modem does not answer\n");
+			setBaudrate(current);
+			return false;
+		}
+		current = _baudrate;
+	}
+
+	for(i=0; (i<LSERIAL_BAUDRATES_COUNT) && (LSERIAL_BAUDRATES[i] > current); i++) {
+		if(baudrate2speed(LSERIAL_BAUDRATES[i]) == B0) {
+			continue;
+		}
+
+		// Modem answers at the previous line speed, then switches
+		snprintf(cmd, sizeof(cmd), "AT+IPR=%lu", (unsigned long) LSERIAL_BAUDRATES[i]);
+		if(!command(cmd, LSERIAL_PROBE_TIMEOUT)) {
+			continue;
+		}
+		setBaudrate(LSERIAL_BAUDRATES[i]);
+		if(command("AT", LSERIAL_PROBE_TIMEOUT)) {
+			break;
+		}
+
+		// Line does not work at this speed, ask the modem to come back blindly
+		snprintf(cmd, sizeof(cmd), "AT+IPR=%lu\r", (unsigned long) current);
+		send(cmd, strlen(cmd), &len);
+		setBaudrate(current);
+		if(!command("AT", LSERIAL_PROBE_TIMEOUT)) {
+			printf("ERROR: Modem lost at %lu\n", (unsigned long) LSERIAL_BAUDRATES[i]);
+			return false;
+		}
+	}
+
+	printf("Serial line at %lu\r\n", (unsigned long) _baudrate);
+	return true;
+}
+
+bool LSerial::send(char* data, unsigned long int toWrite, unsigned long  int* size) {
+	unsigned long int i;
+	int w;
+	
+	if(m_uart < 0) {
+		return false;
+	}
+	
+	for(i=0; i<toWrite;) {
+		w = write(m_uart, &data[i], (toWrite - i));
+		if(w == -1) {
+			return false;
+		}
+		else if(w) {
+			i += w;
+		}
+		
+	}
+
+	*size = toWrite;
+
+	
+	#ifdef SERIAL_DEBUG
+	if(*size) {
+		unsigned long int i;
+		printf("> ");
+		for(i=0; i<*size; i++) {
+			if((data[i] != '\r') && (data[i] != '\n')) {
+				printf("%c", data[i]);
+			}
+		}
+		printf("\n");
+
+	}
+	#endif
+	
+	return true;
+}
+
+long int LSerial::receive(char* data, unsigned long int size, uint32_t timeout) {
+	struct pollfd pfd;
+	int r;
+
+	if(m_uart < 0) {
+		return -1;
+	}
+
+	pfd.fd = m_uart;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	r = poll(&pfd, 1, (timeout == SERIAL_WAIT_FOREVER) ? -1 : (int) timeout);
+	if(r < 0) {
+		return (errno == EINTR) ? 0 : -1;
+	}
+	if(r == 0) {
+		return 0;
+	}
+	if(!(pfd.revents & POLLIN)) {
+		return -1;
+	}
+
+	r = read(m_uart, data, size);
+	if(r < 0) {
+		return ((errno == EINTR) || (errno == EAGAIN)) ? 0 : -1;
+	}
+
+	#ifdef SERIAL_DEBUG
+	if(r) {
+		int i;
+		printf("< ");
+		for(i=0; i<r; i++) {
+			if((data[i] != '\r') && (data[i] != '\n')) {
+				printf("%c", data[i]);
+			}
+		}
+		printf("\n");
+
+	}
+	#endif
+
+	return r;
+}
+
+uint32_t LSerial::getTime(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t) ((ts.tv_sec * 1000) + (ts.tv_nsec / 1000000));
+}
+
+bool LSerial::stop(void) {
+	printf("Closing serial port...");
+	if(m_uart >= 0) {
+		close(m_uart);
+		m_uart = -1;
+	}
+	printf("OK\n");
+	return true;
+}
+
@@ -1,30 +1,141 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *  
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#include "Serial.h"
-
-Serial::Serial(void) {
-}
-
-Serial::~Serial(void) {
-}
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#include "Serial.h"
+#include <cstring>
+
+#define SERIAL_RX_MASK                 (SERIAL_RX_BUFFER_SIZE - 1)
+
+Serial::Serial(void) {
+	_rxHead = 0;
+	_rxTail = 0;
+}
+
+Serial::~Serial(void) {
+}
+
+bool Serial::fill(uint32_t timeout) {
+	uint32_t off, len;
+	long int r;
+
+	// Contiguous free room
+	off = _rxTail & SERIAL_RX_MASK;
+	len = SERIAL_RX_BUFFER_SIZE - off;
+	if(len > (SERIAL_RX_BUFFER_SIZE - (_rxTail - _rxHead))) {
+		len = SERIAL_RX_BUFFER_SIZE - (_rxTail - _rxHead);
+	}
+	if(len == 0) {
+		return true;
+	}
+
+	r = receive(&_rx[off], len, timeout);
+	if(r <= 0) {
+		return false;
+	}
+
+	_rxTail += r;
+	return true;
+}
+
+void Serial::take(char* data, uint32_t len) {
+	uint32_t off, first;
+
+	off = _rxHead & SERIAL_RX_MASK;
+	first = SERIAL_RX_BUFFER_SIZE - off;
+	if(first > len) {
+		first = len;
+	}
+	memcpy(data, &_rx[off], first);
+	memcpy(&data[first], _rx, len - first);
+	_rxHead += len;
+}
+
+bool Serial::recv(char* data, unsigned long int toRead, unsigned long int* read) {
+	uint32_t len;
+
+	*read = 0;
+	while(*read < toRead) {
+		if((_rxHead == _rxTail) && !fill(SERIAL_WAIT_FOREVER)) {
+			return false;
+		}
+
+		len = _rxTail - _rxHead;
+		if(len > (toRead - *read)) {
+			len = toRead - *read;
+		}
+		take(&data[*read], len);
+		*read += len;
+	}
+
+	return true;
+}
+
+bool Serial::readLine(char* data, unsigned long int* len, uint32_t timeout) {
+	unsigned long int size = *len;
+	uint32_t scanned, count, deadline, now, remaining;
+
+	*len = 0;
+	if(size == 0) {
+		return false;
+	}
+
+	deadline = getTime() + timeout;
+	scanned = 0;
+	while(1) {
+		// Bytes already scanned are not scanned again once more are received
+		count = _rxTail - _rxHead;
+		while((scanned < count) && (scanned < size)) {
+			if(_rx[(_rxHead + scanned++) & SERIAL_RX_MASK] == '\n') {
+				take(data, scanned);
+				*len = scanned;
+				return true;
+			}
+		}
+
+		// Line does not fit, return its first part
+		if((scanned == size) || (count == SERIAL_RX_BUFFER_SIZE)) {
+			take(data, scanned);
+			*len = scanned;
+			return true;
+		}
+
+		// Partial line is kept buffered in case of timeout
+		remaining = SERIAL_WAIT_FOREVER;
+		if(timeout != SERIAL_WAIT_FOREVER) {
+			now = getTime();
+			if((int32_t)(deadline - now) <= 0) {
+				return false;
+			}
+			remaining = deadline - now;
+		}
+		if(!fill(remaining)) {
+			return false;
+		}
+	}
+}
+
+void Serial::flush(void) {
+	do {
+		_rxHead = _rxTail;
+	} while(fill(0));
+}
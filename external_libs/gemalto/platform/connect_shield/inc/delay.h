@@ -1,10 +1,10 @@
-#ifndef __DELAY_H__
-#define __DELAY_H__
-
-#include <stdint.h>
-
-void delay_us(uint32_t us);
-void delay_ms(uint32_t ms);
-void delay_s(uint32_t s);
-
-#endif // __DELAY_H__
+#ifndef __DELAY_H__
+#define __DELAY_H__
+
+#include <stdint.h>
+
+void delay_us(uint32_t us);
+void delay_ms(uint32_t ms);
+void delay_s(uint32_t s);
+
+#endif // __DELAY_H__
@@ -1,10 +1,10 @@
-#ifndef __PWM_H__
-#define __PWM_H__
-
-#include <stdint.h>
-
-void pwm_init(void);
-void pwm_start(void);
-void pwm_stop(void);
-
-#endif /* __PWM_H__ */
+#ifndef __PWM_H__
+#define __PWM_H__
+
+#include <stdint.h>
+
+void pwm_init(void);
+void pwm_start(void);
+void pwm_stop(void);
+
+#endif /* __PWM_H__ */
@@ -1,60 +1,197 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#ifndef __PCSC_ACCESS_H__
-#define __PCSC_ACCESS_H__
-
-#include "SEInterface.h"
-#include <PCSC/winscard.h>
-
-class PCSCAccess: public SEInterface {
-	public:
-		// Create an instance of PCSC Access.
-		PCSCAccess(void);
-		~PCSCAccess(void);
-
-		bool open(void);
-		void close(void);
-
-		// Lock the secure element interface to prevent other thing to access the secure element.
-		// Returns true in case locking was successful, false otherwise.
-		bool lock(void) {
-			return true;
-		};
-
-		// Unlock the secure element interface to allow other thing to access the secure element.
-		// Returns true in case unlocking was successful, false otherwise.
-		bool unlock(void) {
-			return true;
-		};
-
-	protected:
-
-		bool transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen);
-
-	private:
-		SCARDCONTEXT hContext;
-		SCARDHANDLE hCard;
-};
-
-#endif /* __PCSC_ACCESS_H__ */
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __PCSC_ACCESS_H__
+#define __PCSC_ACCESS_H__
+
+#include "SEInterface.h"
+#include <PCSC/winscard.h>
+
+// Maximum number of readers handled by PCSCAccess::listReaders and PCSCMonitor.
+#ifndef PCSC_MAX_READERS
+#define PCSC_MAX_READERS               16
+#endif
+
+// Default reader sharing policy, see PCSCAccess::setFairness.
+#ifndef PCSC_MAX_HOLD
+#define PCSC_MAX_HOLD                  500
+#endif
+#ifndef PCSC_YIELD
+#define PCSC_YIELD                     150
+#endif
+
+// Reader events reported by PCSCMonitor.
+#define PCSC_READER_ADDED              0
+#define PCSC_READER_REMOVED            1
+#define PCSC_CARD_INSERTED             2
+#define PCSC_CARD_REMOVED              3
+
+// Reader event callback, ATR is only provided with PCSC_CARD_INSERTED (NULL otherwise).
+typedef void (*pcsc_event_callback_t)(void* ctx, uint8_t event, const char* reader, const uint8_t* atr, uint16_t atrLen);
+
+class PCSCAccess: public SEInterface {
+	public:
+		// Create an instance of PCSC Access. Each instance drives its own reader, so several
+		// instances can be used in parallel threads, one per reader.
+		PCSCAccess(void);
+		~PCSCAccess(void);
+
+		// Connect to the first reader with a card.
+		// Returns true in case connection was successful, false otherwise.
+		bool open(void);
+
+		// Connect to the first reader with a card whose name contains the given string, e.g. the full
+		// name returned by listReaders or reported by PCSCMonitor. Readers driven by another instance
+		// are skipped, whatever the selection.
+		// Returns true in case connection was successful, false otherwise.
+		bool open(const char* reader);
+
+		// Connect to the first reader with a card whose ATR matches the given pattern: ATR bytes
+		// are compared after being masked with mask (NULL to compare all bits), an ATR shorter
+		// than the pattern does not match.
+		// Returns true in case connection was successful, false otherwise.
+		bool open(const uint8_t* atr, const uint8_t* mask, uint16_t atrLen);
+
+		void close(void);
+
+		// Returns the name of the connected reader, empty string if not connected.
+		const char* getReaderName(void);
+
+		// Set the reader sharing policy with other processes. The reader is held by a PC/SC
+		// transaction while the SE is locked, and kept across SE transactions as long as other
+		// threads are waiting for the SE, up to maxHold ms. Once the reader was used for maxHold
+		// ms without a break of at least yield ms, it is left to other processes for yield ms
+		// before the next transaction. MaxHold 0 ends the PC/SC transaction with each SE
+		// transaction and never pauses, nor does yield 0.
+		void setFairness(uint32_t maxHold, uint32_t yield);
+
+		// List the readers known by PC/SC, up to maxReaders.
+		// Returns the number of readers, 0 in case of error or if there is none.
+		static uint16_t listReaders(char readers[][MAX_READERNAME], uint16_t maxReaders);
+
+		// List the readers known by PC/SC, up to maxReaders, setting count to their number.
+		// Returns true in case the list was retrieved, even empty, false otherwise.
+		static bool listReaders(char readers[][MAX_READERNAME], uint16_t maxReaders, uint16_t* count);
+
+	protected:
+
+		bool transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t timeout);
+
+		bool getATR(uint8_t* atr, uint16_t* atrLen);
+
+		// Extended length APDU can not be carried over T=0 without ENVELOPE.
+		uint16_t getMaxTransportLength(void);
+
+		bool beginTransaction(void);
+
+		void endTransaction(bool pending);
+
+	private:
+		// Connect to the first reader with a card accepted by the reader name and ATR filters.
+		// Returns true in case connection was successful, false otherwise.
+		bool open(const char* reader, const uint8_t* atr, const uint8_t* mask, uint16_t atrLen);
+
+		// Connect to the given reader.
+		// Returns true in case connection was successful, false otherwise.
+		bool connect(const char* reader);
+
+		SCARDCONTEXT hContext;
+		SCARDHANDLE hCard;
+		DWORD dwProtocol;
+		BYTE pbAtr[MAX_ATR_SIZE];
+		DWORD dwAtrLen;
+		char szReader[MAX_READERNAME];
+		bool bConnected;
+		bool bTransaction;
+
+		// Sharing policy, in us
+		uint32_t _maxHold;
+		uint32_t _yield;
+		uint32_t _busySince;       // Start of the current use of the reader
+		uint32_t _released;        // End of the last PC/SC transaction
+
+		// Connected instances, a reader is driven by one instance at most
+		PCSCAccess* _next;
+		static PCSCAccess* _connected;
+		#ifdef SE_THREAD_SUPPORT
+		static pthread_mutex_t _connectedMutex;
+		#endif
+};
+
+// Period of the monitor thread, which also bounds reader list refresh when PnP notification is not supported.
+#ifndef PCSC_MONITOR_PERIOD
+#define PCSC_MONITOR_PERIOD            1000
+#endif
+
+// Reader and card hot-plug monitor, based on SCardGetStatusChange. Readers and cards already
+// present when monitoring starts are reported as added and inserted.
+class PCSCMonitor {
+	public:
+		PCSCMonitor(void);
+		~PCSCMonitor(void);
+
+		// Start monitoring, callback is called from the monitor thread. Without thread support,
+		// events are reported by poll only.
+		// Returns true in case monitoring was started, false otherwise.
+		bool start(pcsc_event_callback_t callback, void* ctx);
+
+		// Stop monitoring, waiting for the monitor thread to exit.
+		void stop(void);
+
+		// Wait up to timeout ms for reader or card changes and report them to the callback, from
+		// the calling thread. Must not be used while the monitor thread runs.
+		// Returns true in case no error occurred (including timeout), false otherwise.
+		bool poll(uint32_t timeout);
+
+	private:
+		// Update the reader list, reporting added and removed readers.
+		// Returns true in case the list was retrieved, false otherwise, keeping the previous list.
+		bool refresh(void);
+
+		// Report the change of reader state, if any.
+		void report(SCARD_READERSTATE* state);
+
+		// Establish the PC/SC context and detect PnP notification support.
+		// Returns true in case the context was established, false otherwise.
+		bool establish(void);
+
+		SCARDCONTEXT hContext;
+		bool _established;
+		pcsc_event_callback_t _callback;
+		void* _ctx;
+		volatile bool _running;
+
+		// Reader states, followed by the PnP notification pseudo reader when supported
+		SCARD_READERSTATE rgReaderStates[PCSC_MAX_READERS + 1];
+		char _readers[PCSC_MAX_READERS][MAX_READERNAME];
+		uint16_t _count;
+		bool _pnp;
+
+		#ifdef SE_THREAD_SUPPORT
+		static void* serve(void* arg);
+
+		pthread_t _thread;
+		#endif
+};
+
+#endif /* __PCSC_ACCESS_H__ */
@@ -1,198 +1,640 @@
-/*
- *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
- *  This software is the confidential and proprietary information of GEMALTO.
- *  
- *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
- *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
- *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
- *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
- *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
- *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
-
- *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
- *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
- *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
- *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
- *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
- *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
- *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
- *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
- *  HIGH RISK ACTIVITIES;
- *
- */
-
-#include "PCSCAccess.h"
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-
-#define PCSC_DEBUG
-
-PCSCAccess::PCSCAccess(void) {
-}
-
-PCSCAccess::~PCSCAccess(void) {
-}
-
-bool PCSCAccess::open(void) {
-	LONG rv;
-	DWORD dwReaders;
-	LPSTR mszReaders = NULL;
-	char *ptr, **readers = NULL;
-	int nbReaders;
-	int idxReader;
-	unsigned int i;
-	DWORD dwActiveProtocol, dwReaderLen, dwState, dwProt, dwAtrLen;
-	BYTE pbAtr[MAX_ATR_SIZE] = "";
-	char pbReader[MAX_READERNAME] = "";
-	
-	rv = SCardEstablishContext(SCARD_SCOPE_SYSTEM, NULL, NULL, &hContext);
-	if(rv != SCARD_S_SUCCESS) {
-		printf("ERROR: SCardEstablishContext returned %lX\n", rv);
-		return false;
-	}
-	
-	// Retrieve the available readers list.
-	dwReaders = SCARD_AUTOALLOCATE;
-	rv = SCardListReaders(hContext, NULL, (LPSTR)&mszReaders, &dwReaders);
-	if(rv != SCARD_S_SUCCESS) {
-		printf("ERROR: SCardListReaders returned %lX\n", rv);
-		return false;
-	}
-	
-	// Extract readers from the null separated string and get the total number of readers.
-	nbReaders = 0;
-	ptr = mszReaders;
-	while(*ptr != '\0') {
-		ptr += strlen(ptr)+1;
-		nbReaders++;
-	}
-
-	if(nbReaders == 0) {
-		printf("ERROR: No reader found\n");
-		return false;
-	}
-
-	// Allocate the readers table.
-	readers = (char**) calloc(nbReaders, sizeof(char *));
-	if(NULL == readers) {
-		printf("ERROR: Not enough memory to allocate readers[]\n");
-		return false;
-	}
-
-	// Fill the readers table
-	nbReaders = 0;
-	ptr = mszReaders;
-	while(*ptr != '\0') {
-		printf("Found reader %d: %s\n", nbReaders, ptr);
-		readers[nbReaders] = ptr;
-		ptr += strlen(ptr) + 1;
-		nbReaders++;
-	}
-	
-	// By default try to connect to first available reader
-	idxReader = 0;
-	dwActiveProtocol = -1;
-	rv = SCardConnect(hContext, readers[idxReader], SCARD_SHARE_SHARED, SCARD_PROTOCOL_T0, &hCard, &dwActiveProtocol);
-	if(rv != SCARD_S_SUCCESS) {
-		printf("ERROR: SCardConnect returned %lX\n", rv);
-		return false;
-	}
-	printf(" Protocol: %ld\n", dwActiveProtocol);
-
-	SCardFreeMemory(hContext, mszReaders);
-	free(readers);
-	
-	// Get card status
-	dwAtrLen = sizeof(pbAtr);
-	dwReaderLen = sizeof(pbReader);
-	rv = SCardStatus(hCard, /*NULL*/ pbReader, &dwReaderLen, &dwState, &dwProt, pbAtr, &dwAtrLen);
-	printf(" Reader: %s (length %ld bytes)\n", pbReader, dwReaderLen);
-	printf(" State: 0x%lX\n", dwState);
-	printf(" Prot: %ld\n", dwProt);
-	printf(" ATR (length %ld bytes):", dwAtrLen);
-	for(i=0; i<dwAtrLen; i++) {
-		printf(" %02X", pbAtr[i]);
-	}
-	printf("\n");
-	if(rv != SCARD_S_SUCCESS) {
-		printf("ERROR: SCardStatus returned %lX\n", rv);
-		return false;
-	}
-
-	rv = SCardBeginTransaction(hCard);
-	if(rv != SCARD_S_SUCCESS) {
-		printf("ERROR: SCardBeginTransaction returned %lX\n", rv);
-		return false;
-	}
-	
-	return true;
-}
-
-void PCSCAccess::close(void) {
-	LONG rv;
-	
-	rv = SCardEndTransaction(hCard, SCARD_LEAVE_CARD);
-	if(rv != SCARD_S_SUCCESS) {
-		printf("ERROR: SCardEndTransaction returned %lX\n", rv);
-	}
-	
-	rv = SCardDisconnect(hCard, SCARD_LEAVE_CARD);
-	if(rv != SCARD_S_SUCCESS) {
-		printf("ERROR: SCardDisconnect returned %lX\n", rv);
-	}
-
-	rv = SCardReleaseContext(hContext);
-	if(rv != SCARD_S_SUCCESS) {
-		printf("ERROR: SCardReleaseContext returned %lX\n", rv);
-	}
-}
-
-bool PCSCAccess::transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen) {
-	uint16_t i;
-	LONG rv;
-	DWORD dwSendLength, dwRecvLength;
-	
-	#ifdef PCSC_DEBUG
-	printf("SND: ");
-	for(i=0; i<apduLen; i++) {
-		printf("%02X", apdu[i]);
-	}
-	printf("\n");
-	#endif
-
-	dwSendLength = apduLen;
-	dwRecvLength = 256 + 2;
-	rv = SCardTransmit(hCard, SCARD_PCI_T0, apdu, dwSendLength, NULL, response, &dwRecvLength);
-	*responseLen = dwRecvLength;
-	
-	#ifdef PCSC_DEBUG
-	printf("RCV: ");
-	for(i=0; i<*responseLen; i++) {
-		printf("%02X", response[i]);
-	}
-	printf("\n");
-	#endif
-		
-	if(rv != SCARD_S_SUCCESS) {
-		printf("ERROR: SCardTransmit returned %lX\n", rv);
-		return false;
-	}
-	
-	if((*responseLen == 2) && (response[0] == 0x6C)) {
-		apdu[4] = response[1];
-		return transmitApdu(apdu, apduLen, response, responseLen);
-	}
-	
-	if((*responseLen == 2) && (response[0] == 0x61)) {
-		apdu[0] = 0x00 | (apdu[0] & 0x03);
-		apdu[1] = 0xC0;
-		apdu[2] = 0x00;
-		apdu[3] = 0x00;
-		apdu[4] = response[1];
-		apduLen = 5;
-		return transmitApdu(apdu, apduLen, response, responseLen);
-	}
-	
-	return true;
-}
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#include "PCSCAccess.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#define PCSC_DEBUG
+
+#define PCSC_PNP_NOTIFICATION          "\\\\?PnP?\\Notification"
+
+PCSCAccess* PCSCAccess::_connected = NULL;
+#ifdef SE_THREAD_SUPPORT
+pthread_mutex_t PCSCAccess::_connectedMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+// Returns true in case ATR matches the pattern, false otherwise.
+static bool matchATR(const BYTE* atr, DWORD atrLen, const uint8_t* pattern, const uint8_t* mask, uint16_t patternLen) {
+	uint16_t i;
+
+	if(atrLen < patternLen) {
+		return false;
+	}
+	for(i=0; i<patternLen; i++) {
+		if(((atr[i] ^ pattern[i]) & ((mask != NULL) ? mask[i] : 0xFF)) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+PCSCAccess::PCSCAccess(void) {
+	dwProtocol = SCARD_PROTOCOL_UNDEFINED;
+	dwAtrLen = 0;
+	szReader[0] = '\0';
+	bConnected = false;
+	bTransaction = false;
+	_next = NULL;
+	setFairness(PCSC_MAX_HOLD, PCSC_YIELD);
+}
+
+PCSCAccess::~PCSCAccess(void) {
+	close();
+}
+
+uint16_t PCSCAccess::listReaders(char readers[][MAX_READERNAME], uint16_t maxReaders) {
+	uint16_t count;
+
+	listReaders(readers, maxReaders, &count);
+	return count;
+}
+
+bool PCSCAccess::listReaders(char readers[][MAX_READERNAME], uint16_t maxReaders, uint16_t* count) {
+	LONG rv;
+	SCARDCONTEXT hListContext;
+	DWORD dwReaders;
+	LPSTR mszReaders = NULL;
+	char *ptr;
+
+	*count = 0;
+
+	rv = SCardEstablishContext(SCARD_SCOPE_SYSTEM, NULL, NULL, &hListContext);
+	if(rv != SCARD_S_SUCCESS) {
+		printf("ERROR: SCardEstablishContext returned %lX\n", rv);
+		return false;
+	}
+
+	dwReaders = SCARD_AUTOALLOCATE;
+	rv = SCardListReaders(hListContext, NULL, (LPSTR)&mszReaders, &dwReaders);
+	if(rv != SCARD_S_SUCCESS) {
+		SCardReleaseContext(hListContext);
+		if(rv != SCARD_E_NO_READERS_AVAILABLE) {
+			printf("ERROR: SCardListReaders returned %lX\n", rv);
+			return false;
+		}
+		return true;
+	}
+
+	// Extract readers from the null separated string
+	ptr = mszReaders;
+	while((*ptr != '\0') && (*count < maxReaders)) {
+		strncpy(readers[*count], ptr, MAX_READERNAME - 1);
+		readers[*count][MAX_READERNAME - 1] = '\0';
+		ptr += strlen(ptr) + 1;
+		(*count)++;
+	}
+
+	SCardFreeMemory(hListContext, mszReaders);
+	SCardReleaseContext(hListContext);
+	return true;
+}
+
+bool PCSCAccess::open(void) {
+	return open(NULL, NULL, NULL, 0);
+}
+
+bool PCSCAccess::open(const char* reader) {
+	return open(reader, NULL, NULL, 0);
+}
+
+bool PCSCAccess::open(const uint8_t* atr, const uint8_t* mask, uint16_t atrLen) {
+	return open(NULL, atr, mask, atrLen);
+}
+
+bool PCSCAccess::open(const char* reader, const uint8_t* atr, const uint8_t* mask, uint16_t atrLen) {
+	LONG rv;
+	char readers[PCSC_MAX_READERS][MAX_READERNAME];
+	uint16_t nbReaders;
+	uint16_t i;
+	PCSCAccess* other;
+
+	if(bConnected) {
+		return false;
+	}
+
+	// Retrieve the available readers list.
+	nbReaders = listReaders(readers, PCSC_MAX_READERS);
+	if(nbReaders == 0) {
+		printf("ERROR: No reader found\n");
+		return false;
+	}
+
+	rv = SCardEstablishContext(SCARD_SCOPE_SYSTEM, NULL, NULL, &hContext);
+	if(rv != SCARD_S_SUCCESS) {
+		printf("ERROR: SCardEstablishContext returned %lX\n", rv);
+		return false;
+	}
+
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_lock(&_connectedMutex);
+	#endif
+	for(i=0; (i<nbReaders) && !bConnected; i++) {
+		printf("Found reader %d: %s\n", i, readers[i]);
+		if((reader != NULL) && (strstr(readers[i], reader) == NULL)) {
+			continue;
+		}
+
+		// Reader already driven by another instance
+		for(other = _connected; other != NULL; other = other->_next) {
+			if(strcmp(other->szReader, readers[i]) == 0) {
+				break;
+			}
+		}
+		if(other != NULL) {
+			continue;
+		}
+
+		if(!connect(readers[i])) {
+			continue;
+		}
+		if((atr != NULL) && !matchATR(pbAtr, dwAtrLen, atr, mask, atrLen)) {
+			SCardDisconnect(hCard, SCARD_LEAVE_CARD);
+			continue;
+		}
+
+		bConnected = true;
+		_next = _connected;
+		_connected = this;
+	}
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_unlock(&_connectedMutex);
+	#endif
+
+	if(!bConnected) {
+		printf("ERROR: No matching reader found\n");
+		szReader[0] = '\0';
+		dwAtrLen = 0;
+		SCardReleaseContext(hContext);
+		return false;
+	}
+
+	// Reader is only held during SE transactions
+	_busySince = getTimestamp();
+	_released = _busySince - _yield;
+	return true;
+}
+
+bool PCSCAccess::connect(const char* reader) {
+	LONG rv;
+	unsigned int i;
+	DWORD dwActiveProtocol, dwReaderLen, dwState, dwProt;
+
+	dwActiveProtocol = -1;
+	rv = SCardConnect(hContext, reader, SCARD_SHARE_SHARED, SCARD_PROTOCOL_T0 | SCARD_PROTOCOL_T1, &hCard, &dwActiveProtocol);
+	if(rv != SCARD_S_SUCCESS) {
+		printf("ERROR: SCardConnect returned %lX\n", rv);
+		return false;
+	}
+	printf(" Protocol: %ld\n", dwActiveProtocol);
+	dwProtocol = dwActiveProtocol;
+
+	// Get card status
+	dwAtrLen = sizeof(pbAtr);
+	dwReaderLen = sizeof(szReader);
+	rv = SCardStatus(hCard, szReader, &dwReaderLen, &dwState, &dwProt, pbAtr, &dwAtrLen);
+	if(rv != SCARD_S_SUCCESS) {
+		printf("ERROR: SCardStatus returned %lX\n", rv);
+		SCardDisconnect(hCard, SCARD_LEAVE_CARD);
+		return false;
+	}
+	printf(" Reader: %s (length %ld bytes)\n", szReader, dwReaderLen);
+	printf(" State: 0x%lX\n", dwState);
+	printf(" Prot: %ld\n", dwProt);
+	printf(" ATR (length %ld bytes):", dwAtrLen);
+	for(i=0; i<dwAtrLen; i++) {
+		printf(" %02X", pbAtr[i]);
+	}
+	printf("\n");
+
+	return true;
+}
+
+void PCSCAccess::close(void) {
+	LONG rv;
+	PCSCAccess** other;
+
+	if(!bConnected) {
+		return;
+	}
+
+	if(bTransaction) {
+		rv = SCardEndTransaction(hCard, SCARD_LEAVE_CARD);
+		if(rv != SCARD_S_SUCCESS) {
+			printf("ERROR: SCardEndTransaction returned %lX\n", rv);
+		}
+		bTransaction = false;
+	}
+	
+	rv = SCardDisconnect(hCard, SCARD_LEAVE_CARD);
+	if(rv != SCARD_S_SUCCESS) {
+		printf("ERROR: SCardDisconnect returned %lX\n", rv);
+	}
+
+	rv = SCardReleaseContext(hContext);
+	if(rv != SCARD_S_SUCCESS) {
+		printf("ERROR: SCardReleaseContext returned %lX\n", rv);
+	}
+
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_lock(&_connectedMutex);
+	#endif
+	for(other = &_connected; *other != NULL; other = &(*other)->_next) {
+		if(*other == this) {
+			*other = _next;
+			break;
+		}
+	}
+	#ifdef SE_THREAD_SUPPORT
+	pthread_mutex_unlock(&_connectedMutex);
+	#endif
+
+	_next = NULL;
+	bConnected = false;
+	szReader[0] = '\0';
+	dwAtrLen = 0;
+}
+
+const char* PCSCAccess::getReaderName(void) {
+	return szReader;
+}
+
+void PCSCAccess::setFairness(uint32_t maxHold, uint32_t yield) {
+	_maxHold = maxHold * 1000;
+	_yield = yield * 1000;
+}
+
+bool PCSCAccess::beginTransaction(void) {
+	LONG rv;
+	uint32_t now;
+	DWORD dwActiveProtocol;
+
+	if(!bConnected) {
+		return false;
+	}
+
+	// Kept from previous SE transaction
+	if(bTransaction) {
+		return true;
+	}
+
+	// Reader used for too long, leave it to other processes for a while; a long enough break
+	// starts a new use
+	now = getTimestamp();
+	if((now - _released) >= _yield) {
+		_busySince = now;
+	}
+	else if(_maxHold && ((now - _busySince) >= _maxHold)) {
+		usleep(_yield - (now - _released));
+		_busySince = getTimestamp();
+	}
+
+	rv = SCardBeginTransaction(hCard);
+
+	// Card was reset or swapped by another process: logical channels and selections are lost
+	if((rv == SCARD_W_RESET_CARD) || (rv == SCARD_W_REMOVED_CARD)) {
+		rv = SCardReconnect(hCard, SCARD_SHARE_SHARED, SCARD_PROTOCOL_T0 | SCARD_PROTOCOL_T1, SCARD_LEAVE_CARD, &dwActiveProtocol);
+		if(rv == SCARD_S_SUCCESS) {
+			dwProtocol = dwActiveProtocol;
+			resetChannels();
+			rv = SCardBeginTransaction(hCard);
+		}
+	}
+
+	if(rv != SCARD_S_SUCCESS) {
+		printf("ERROR: SCardBeginTransaction returned %lX\n", rv);
+		return false;
+	}
+
+	bTransaction = true;
+	return true;
+}
+
+void PCSCAccess::endTransaction(bool pending) {
+	LONG rv;
+
+	if(!bTransaction) {
+		return;
+	}
+
+	// Keep the reader for the next SE transaction, unless it was used for too long
+	if(pending && ((getTimestamp() - _busySince) < _maxHold)) {
+		return;
+	}
+
+	rv = SCardEndTransaction(hCard, SCARD_LEAVE_CARD);
+	if(rv != SCARD_S_SUCCESS) {
+		printf("ERROR: SCardEndTransaction returned %lX\n", rv);
+	}
+	bTransaction = false;
+	_released = getTimestamp();
+}
+
+bool PCSCAccess::transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t timeout) {
+	uint16_t i;
+	LONG rv;
+	DWORD dwSendLength, dwRecvLength;
+	
+	#ifdef PCSC_DEBUG
+	printf("SND: ");
+	for(i=0; i<apduLen; i++) {
+		printf("%02X", apdu[i]);
+	}
+	printf("\n");
+	#endif
+
+	// SCardTransmit cannot be bounded, the deadline is only checked by SEInterface between exchanges
+	(void) timeout;
+	dwSendLength = apduLen;
+	dwRecvLength = *responseLen;
+	rv = SCardTransmit(hCard, (dwProtocol == SCARD_PROTOCOL_T1) ? SCARD_PCI_T1 : SCARD_PCI_T0, apdu, dwSendLength, NULL, response, &dwRecvLength);
+	*responseLen = dwRecvLength;
+	
+	#ifdef PCSC_DEBUG
+	printf("RCV: ");
+	for(i=0; i<*responseLen; i++) {
+		printf("%02X", response[i]);
+	}
+	printf("\n");
+	#endif
+		
+	if(rv != SCARD_S_SUCCESS) {
+		printf("ERROR: SCardTransmit returned %lX\n", rv);
+		return false;
+	}
+	
+	// 61xx and 6Cxx are handled by SEInterface
+	return true;
+}
+
+bool PCSCAccess::getATR(uint8_t* atr, uint16_t* atrLen) {
+	if((dwAtrLen == 0) || (dwAtrLen > *atrLen)) {
+		return false;
+	}
+
+	memcpy(atr, pbAtr, dwAtrLen);
+	*atrLen = dwAtrLen;
+	return true;
+}
+
+uint16_t PCSCAccess::getMaxTransportLength(void) {
+	if(dwProtocol == SCARD_PROTOCOL_T1) {
+		return SE_MAX_DATA_LENGTH;
+	}
+	return SE_SHORT_MAX_DATA_LENGTH;
+}
+
+PCSCMonitor::PCSCMonitor(void) {
+	_established = false;
+	_callback = NULL;
+	_ctx = NULL;
+	_running = false;
+	_count = 0;
+	_pnp = false;
+}
+
+PCSCMonitor::~PCSCMonitor(void) {
+	stop();
+}
+
+bool PCSCMonitor::establish(void) {
+	LONG rv;
+	SCARD_READERSTATE pnp;
+
+	rv = SCardEstablishContext(SCARD_SCOPE_SYSTEM, NULL, NULL, &hContext);
+	if(rv != SCARD_S_SUCCESS) {
+		printf("ERROR: SCardEstablishContext returned %lX\n", rv);
+		return false;
+	}
+	_established = true;
+
+	// Without PnP notification, reader list is refreshed on each poll
+	memset(&pnp, 0, sizeof(pnp));
+	pnp.szReader = PCSC_PNP_NOTIFICATION;
+	pnp.dwCurrentState = SCARD_STATE_UNAWARE;
+	rv = SCardGetStatusChange(hContext, 0, &pnp, 1);
+	_pnp = ((rv == SCARD_S_SUCCESS) || (rv == SCARD_E_TIMEOUT)) && ((pnp.dwEventState & SCARD_STATE_UNKNOWN) == 0);
+
+	memset(&rgReaderStates[PCSC_MAX_READERS], 0, sizeof(SCARD_READERSTATE));
+	rgReaderStates[PCSC_MAX_READERS].szReader = PCSC_PNP_NOTIFICATION;
+	rgReaderStates[PCSC_MAX_READERS].dwCurrentState = pnp.dwEventState & ~SCARD_STATE_CHANGED;
+	return true;
+}
+
+bool PCSCMonitor::start(pcsc_event_callback_t callback, void* ctx) {
+	if(_running || _established) {
+		return false;
+	}
+
+	_callback = callback;
+	_ctx = ctx;
+	_count = 0;
+	if(!establish()) {
+		return false;
+	}
+
+	// Report readers already present, their cards are reported by the first poll
+	refresh();
+
+	_running = true;
+	#ifdef SE_THREAD_SUPPORT
+	if(pthread_create(&_thread, NULL, serve, this) != 0) {
+		_running = false;
+		SCardReleaseContext(hContext);
+		_established = false;
+		return false;
+	}
+	#endif
+	return true;
+}
+
+void PCSCMonitor::stop(void) {
+	#ifdef SE_THREAD_SUPPORT
+	if(_running) {
+		_running = false;
+		if(_established) {
+			SCardCancel(hContext);
+		}
+		pthread_join(_thread, NULL);
+	}
+	#endif
+	_running = false;
+
+	if(_established) {
+		SCardReleaseContext(hContext);
+		_established = false;
+	}
+	_count = 0;
+}
+
+bool PCSCMonitor::refresh(void) {
+	char readers[PCSC_MAX_READERS][MAX_READERNAME];
+	DWORD states[PCSC_MAX_READERS];
+	uint16_t count;
+	uint16_t i, j;
+
+	if(!PCSCAccess::listReaders(readers, PCSC_MAX_READERS, &count)) {
+		return false;
+	}
+
+	// Removed readers, with their card
+	for(i=0; i<_count; i++) {
+		for(j=0; j<count; j++) {
+			if(strcmp(_readers[i], readers[j]) == 0) {
+				break;
+			}
+		}
+		if(j == count) {
+			if((rgReaderStates[i].dwCurrentState & SCARD_STATE_PRESENT) && !(rgReaderStates[i].dwCurrentState & SCARD_STATE_MUTE)) {
+				_callback(_ctx, PCSC_CARD_REMOVED, _readers[i], NULL, 0);
+			}
+			_callback(_ctx, PCSC_READER_REMOVED, _readers[i], NULL, 0);
+		}
+	}
+
+	// Added readers start unaware of their state, so that the next poll reports their card
+	for(j=0; j<count; j++) {
+		states[j] = SCARD_STATE_UNAWARE;
+		for(i=0; i<_count; i++) {
+			if(strcmp(_readers[i], readers[j]) == 0) {
+				states[j] = rgReaderStates[i].dwCurrentState;
+				break;
+			}
+		}
+		if(i == _count) {
+			_callback(_ctx, PCSC_READER_ADDED, readers[j], NULL, 0);
+		}
+	}
+
+	memcpy(_readers, readers, count * MAX_READERNAME);
+	for(j=0; j<count; j++) {
+		memset(&rgReaderStates[j], 0, sizeof(SCARD_READERSTATE));
+		rgReaderStates[j].szReader = _readers[j];
+		rgReaderStates[j].dwCurrentState = states[j];
+	}
+	_count = count;
+	return true;
+}
+
+void PCSCMonitor::report(SCARD_READERSTATE* state) {
+	bool present, wasPresent, swapped;
+
+	if(!(state->dwEventState & SCARD_STATE_CHANGED)) {
+		return;
+	}
+
+	present = (state->dwEventState & SCARD_STATE_PRESENT) && !(state->dwEventState & SCARD_STATE_MUTE);
+	wasPresent = (state->dwCurrentState & SCARD_STATE_PRESENT) && !(state->dwCurrentState & SCARD_STATE_MUTE);
+
+	// Card swapped between two polls: upper word of the state counts card events
+	swapped = present && wasPresent && ((state->dwEventState ^ state->dwCurrentState) & 0xFFFF0000);
+
+	if(wasPresent && (!present || swapped)) {
+		_callback(_ctx, PCSC_CARD_REMOVED, state->szReader, NULL, 0);
+	}
+	if(present && (!wasPresent || swapped)) {
+		_callback(_ctx, PCSC_CARD_INSERTED, state->szReader, state->rgbAtr, state->cbAtr);
+	}
+
+	state->dwCurrentState = state->dwEventState & ~SCARD_STATE_CHANGED;
+}
+
+bool PCSCMonitor::poll(uint32_t timeout) {
+	LONG rv;
+	uint16_t i;
+	DWORD count;
+
+	if(!_established && !establish()) {
+		return false;
+	}
+
+	// Nothing to wait for: refresh reader list once timeout elapsed
+	if((_count == 0) && !_pnp) {
+		usleep(timeout * 1000);
+		return refresh();
+	}
+
+	// PnP pseudo reader follows the readers
+	count = _count;
+	if(_pnp) {
+		if(_count < PCSC_MAX_READERS) {
+			rgReaderStates[_count] = rgReaderStates[PCSC_MAX_READERS];
+		}
+		count++;
+	}
+
+	rv = SCardGetStatusChange(hContext, timeout, rgReaderStates, count);
+	if(rv == SCARD_E_TIMEOUT) {
+		return _pnp ? true : refresh();
+	}
+	if(rv == SCARD_E_CANCELLED) {
+		return true;
+	}
+	if(rv == SCARD_E_UNKNOWN_READER) {
+		// Reader removed before the PnP notification
+		return refresh();
+	}
+	if(rv != SCARD_S_SUCCESS) {
+		printf("ERROR: SCardGetStatusChange returned %lX\n", rv);
+		if((rv == SCARD_E_NO_SERVICE) || (rv == SCARD_E_SERVICE_STOPPED) || (rv == SCARD_E_INVALID_HANDLE)) {
+			// Establish context again on next poll
+			SCardReleaseContext(hContext);
+			_established = false;
+		}
+		return false;
+	}
+
+	for(i=0; i<_count; i++) {
+		report(&rgReaderStates[i]);
+	}
+
+	if(_pnp) {
+		if(_count < PCSC_MAX_READERS) {
+			rgReaderStates[PCSC_MAX_READERS] = rgReaderStates[_count];
+		}
+		if(rgReaderStates[PCSC_MAX_READERS].dwEventState & SCARD_STATE_CHANGED) {
+			// Change left pending when the list can not be retrieved, to retry on next poll
+			if(!refresh()) {
+				return false;
+			}
+			rgReaderStates[PCSC_MAX_READERS].dwCurrentState = rgReaderStates[PCSC_MAX_READERS].dwEventState & ~SCARD_STATE_CHANGED;
+		}
+	}
+	return true;
+}
+
+#ifdef SE_THREAD_SUPPORT
+void* PCSCMonitor::serve(void* arg) {
+	PCSCMonitor* monitor = (PCSCMonitor*) arg;
+
+	while(monitor->_running) {
+		if(!monitor->poll(PCSC_MONITOR_PERIOD) && monitor->_running) {
+			// Service unavailable, retry later
+			usleep(PCSC_MONITOR_PERIOD * 1000);
+		}
+	}
+	return NULL;
+}
+#endif
@@ -0,0 +1,46 @@
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __SE_TRACE_H__
+#define __SE_TRACE_H__
+
+// APDU trace file format, all integers are little endian.
+//
+// Header:
+//  - magic "SETR"
+//  - version (1 byte)
+//  - maximum transport length (2 bytes)
+//  - ATR length (1 byte), 0 if not known by the low layer, followed by the ATR
+//
+// Then one record per low layer exchange:
+//  - timestamp since the beginning of the trace in us (4 bytes)
+//  - exchange latency in us (4 bytes)
+//  - APDU length (2 bytes) followed by the APDU
+//  - response length (2 bytes), 0 in case of low layer failure, followed by the response
+
+#define SE_TRACE_MAGIC                 "SETR"
+#define SE_TRACE_VERSION               1
+#define SE_TRACE_HEADER_LENGTH         8
+#define SE_TRACE_RECORD_HEADER_LENGTH  10
+
+#endif /* __SE_TRACE_H__ */
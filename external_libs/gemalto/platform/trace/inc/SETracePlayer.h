@@ -0,0 +1,93 @@
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __SE_TRACE_PLAYER_H__
+#define __SE_TRACE_PLAYER_H__
+
+#include "SEInterface.h"
+#include "SETrace.h"
+
+// Simulated secure element answering APDU from a trace created by SETraceRecorder.
+// Each APDU is answered by the next matching record not replayed yet, looking first after the
+// last replayed one, so that the trace still applies when a cache skips part of it.
+// Exchange latency is simulated on a clock of its own, used for APDU metrics.
+class SETracePlayer: public SEInterface {
+	public:
+		// Create an instance of trace player.
+		SETracePlayer(void);
+		~SETracePlayer(void);
+
+		// Load the trace file.
+		// Returns true in case trace was loaded, false otherwise.
+		bool open(const char* path);
+
+		void close(void);
+
+		// Replay the trace from its beginning.
+		void rewind(void);
+
+		// Set the simulated latency of each exchange: latency parameter in us, plus the recorded
+		// latency scaled by scale parameter in percent. Default is the recorded latency.
+		void setLatency(uint32_t latency, uint16_t scale);
+
+		// Wait for the simulated latency of each exchange instead of only accounting it.
+		void setRealTime(bool enable);
+
+		// Returns the number of APDU answered out of the recorded order.
+		uint32_t getMismatches(void);
+
+		// Returns the number of APDU not found in the trace.
+		uint32_t getMisses(void);
+
+	protected:
+
+		bool transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t timeout);
+
+		bool getATR(uint8_t* atr, uint16_t* atrLen);
+
+		uint16_t getMaxTransportLength(void);
+
+		uint32_t getTimestamp(void);
+
+	private:
+		uint8_t* _trace;
+		uint32_t _traceLen;
+		uint32_t* _records;
+		uint8_t* _replayed;
+		uint32_t _count;
+		uint32_t _next;
+
+		uint32_t _latency;
+		uint16_t _scale;
+		bool _realTime;
+		uint32_t _clock;
+
+		uint32_t _mismatches;
+		uint32_t _misses;
+
+		// Look for the record to answer the given APDU.
+		// Returns true in case a record was found, false otherwise.
+		bool find(uint8_t* apdu, uint16_t apduLen, uint32_t* index);
+};
+
+#endif /* __SE_TRACE_PLAYER_H__ */
@@ -0,0 +1,63 @@
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#ifndef __SE_TRACE_RECORDER_H__
+#define __SE_TRACE_RECORDER_H__
+
+#include <stdio.h>
+
+#include "SEInterface.h"
+#include "SETrace.h"
+
+// Secure element interface recording each APDU exchanged with the secure element it wraps.
+class SETraceRecorder: public SEInterface {
+	public:
+		// Create an instance of trace recorder on top of the given secure element interface.
+		SETraceRecorder(SEInterface* se);
+		~SETraceRecorder(void);
+
+		// Create the trace file, and write its header.
+		// Returns true in case trace file was created, false otherwise.
+		bool open(const char* path);
+
+		void close(void);
+
+	protected:
+
+		bool transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t timeout);
+
+		bool getATR(uint8_t* atr, uint16_t* atrLen);
+
+		uint16_t getMaxTransportLength(void);
+
+		bool beginTransaction(void);
+
+		void endTransaction(bool pending);
+
+	private:
+		SEInterface* _se;
+		FILE* _file;
+		uint32_t _start;
+};
+
+#endif /* __SE_TRACE_RECORDER_H__ */
@@ -0,0 +1,245 @@
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#include "SETracePlayer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+static uint16_t read16(uint8_t* buf) {
+	return buf[0] | (buf[1] << 8);
+}
+
+static uint32_t read32(uint8_t* buf) {
+	return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t) buf[3] << 24);
+}
+
+SETracePlayer::SETracePlayer(void) {
+	_trace = NULL;
+	_traceLen = 0;
+	_records = NULL;
+	_replayed = NULL;
+	_count = 0;
+	_next = 0;
+
+	_latency = 0;
+	_scale = 100;
+	_realTime = false;
+	_clock = 0;
+
+	_mismatches = 0;
+	_misses = 0;
+}
+
+SETracePlayer::~SETracePlayer(void) {
+	close();
+}
+
+bool SETracePlayer::open(const char* path) {
+	FILE* file;
+	long size;
+	uint32_t offset, len, i;
+
+	close();
+
+	file = fopen(path, "rb");
+	if(file == NULL) {
+		return false;
+	}
+
+	if((fseek(file, 0, SEEK_END) == 0) && ((size = ftell(file)) > 0) && (fseek(file, 0, SEEK_SET) == 0)) {
+		_trace = (uint8_t*) malloc(size * sizeof(uint8_t));
+		if(_trace && (fread(_trace, 1, size, file) == (size_t) size)) {
+			_traceLen = size;
+		}
+	}
+	fclose(file);
+
+	if((_traceLen < SE_TRACE_HEADER_LENGTH) || memcmp(_trace, SE_TRACE_MAGIC, 4) || (_trace[4] != SE_TRACE_VERSION)
+	|| ((uint32_t) (SE_TRACE_HEADER_LENGTH + _trace[7]) > _traceLen)) {
+		close();
+		return false;
+	}
+
+	// First pass to count records and check their consistency, a record cut by an interrupted
+	// recording (even right after its APDU, before the response length) rejects the file
+	for(i = 0, offset = SE_TRACE_HEADER_LENGTH + _trace[7]; offset < _traceLen; i++) {
+		len = SE_TRACE_RECORD_HEADER_LENGTH;
+		if((offset + len) <= _traceLen) {
+			len += read16(&_trace[offset + 8]) + 2;
+			if((offset + len) <= _traceLen) {
+				len += read16(&_trace[offset + len - 2]);
+			}
+		}
+		if((offset + len) > _traceLen) {
+			close();
+			return false;
+		}
+		offset += len;
+	}
+
+	_count = i;
+	_records = (uint32_t*) malloc((_count + 1) * sizeof(uint32_t));
+	_replayed = (uint8_t*) calloc(_count + 1, sizeof(uint8_t));
+	if((_records == NULL) || (_replayed == NULL)) {
+		close();
+		return false;
+	}
+
+	for(i = 0, offset = SE_TRACE_HEADER_LENGTH + _trace[7]; i < _count; i++) {
+		_records[i] = offset;
+		offset += SE_TRACE_RECORD_HEADER_LENGTH + read16(&_trace[offset + 8]);
+		offset += 2 + read16(&_trace[offset]);
+	}
+
+	return true;
+}
+
+void SETracePlayer::close(void) {
+	if(_trace) {
+		free(_trace);
+		_trace = NULL;
+	}
+	if(_records) {
+		free(_records);
+		_records = NULL;
+	}
+	if(_replayed) {
+		free(_replayed);
+		_replayed = NULL;
+	}
+	_traceLen = 0;
+	_count = 0;
+	_next = 0;
+}
+
+void SETracePlayer::rewind(void) {
+	if(_replayed) {
+		memset(_replayed, 0, _count);
+	}
+	_next = 0;
+}
+
+void SETracePlayer::setLatency(uint32_t latency, uint16_t scale) {
+	_latency = latency;
+	_scale = scale;
+}
+
+void SETracePlayer::setRealTime(bool enable) {
+	_realTime = enable;
+}
+
+uint32_t SETracePlayer::getMismatches(void) {
+	return _mismatches;
+}
+
+uint32_t SETracePlayer::getMisses(void) {
+	return _misses;
+}
+
+bool SETracePlayer::find(uint8_t* apdu, uint16_t apduLen, uint32_t* index) {
+	uint32_t i, pass, offset;
+
+	// Not replayed records after the last replayed one first, then before it, then any record
+	for(pass = 0; pass < 3; pass++) {
+		for(i = (pass == 0) ? _next : 0; i < _count; i++) {
+			offset = _records[i];
+			if(((pass == 2) || !_replayed[i])
+			&& (read16(&_trace[offset + 8]) == apduLen)
+			&& (memcmp(&_trace[offset + SE_TRACE_RECORD_HEADER_LENGTH], apdu, apduLen) == 0)) {
+				*index = i;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool SETracePlayer::transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t timeout) {
+	uint32_t index, offset, latency;
+	uint16_t len;
+
+	if(!find(apdu, apduLen, &index)) {
+		_misses++;
+		return false;
+	}
+
+	if(index != _next) {
+		_mismatches++;
+	}
+	_replayed[index] = 1;
+	_next = index + 1;
+
+	offset = _records[index];
+	latency = _latency + (uint32_t) (((uint64_t) read32(&_trace[offset + 4]) * _scale) / 100);
+
+	// Exchange slower than the time left fails once the timeout elapsed, as on the low layer
+	if((timeout != SE_WAIT_FOREVER) && ((uint64_t) latency > ((uint64_t) timeout * 1000))) {
+		_clock += timeout * 1000;
+		if(_realTime) {
+			usleep(timeout * 1000);
+		}
+		return false;
+	}
+
+	_clock += latency;
+	if(_realTime && latency) {
+		usleep(latency);
+	}
+
+	offset += SE_TRACE_RECORD_HEADER_LENGTH + apduLen;
+	len = read16(&_trace[offset]);
+
+	// Recorded low layer failure
+	if((len == 0) || (len > *responseLen)) {
+		return false;
+	}
+
+	memcpy(response, &_trace[offset + 2], len);
+	*responseLen = len;
+	return true;
+}
+
+bool SETracePlayer::getATR(uint8_t* atr, uint16_t* atrLen) {
+	if((_trace == NULL) || (_trace[7] == 0) || (_trace[7] > *atrLen)) {
+		return false;
+	}
+
+	memcpy(atr, &_trace[SE_TRACE_HEADER_LENGTH], _trace[7]);
+	*atrLen = _trace[7];
+	return true;
+}
+
+uint16_t SETracePlayer::getMaxTransportLength(void) {
+	if(_trace == NULL) {
+		return SE_SHORT_MAX_DATA_LENGTH;
+	}
+
+	return read16(&_trace[5]);
+}
+
+uint32_t SETracePlayer::getTimestamp(void) {
+	return _clock;
+}
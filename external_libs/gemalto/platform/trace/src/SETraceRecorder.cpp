@@ -0,0 +1,130 @@
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+#include "SETraceRecorder.h"
+
+static bool write16(FILE* file, uint16_t value) {
+	uint8_t buf[2];
+
+	buf[0] = value;
+	buf[1] = value >> 8;
+	return fwrite(buf, 1, sizeof(buf), file) == sizeof(buf);
+}
+
+static bool write32(FILE* file, uint32_t value) {
+	uint8_t buf[4];
+
+	buf[0] = value;
+	buf[1] = value >> 8;
+	buf[2] = value >> 16;
+	buf[3] = value >> 24;
+	return fwrite(buf, 1, sizeof(buf), file) == sizeof(buf);
+}
+
+SETraceRecorder::SETraceRecorder(SEInterface* se) {
+	_se = se;
+	_file = NULL;
+	_start = 0;
+}
+
+SETraceRecorder::~SETraceRecorder(void) {
+	close();
+}
+
+bool SETraceRecorder::open(const char* path) {
+	uint8_t atr[33];
+	uint16_t atrLen;
+
+	close();
+
+	_file = fopen(path, "wb");
+	if(_file == NULL) {
+		return false;
+	}
+
+	atrLen = sizeof(atr);
+	if(!getATR(atr, &atrLen)) {
+		atrLen = 0;
+	}
+
+	if((fwrite(SE_TRACE_MAGIC, 1, 4, _file) != 4)
+	|| (fputc(SE_TRACE_VERSION, _file) == EOF)
+	|| !write16(_file, getMaxTransportLength())
+	|| (fputc(atrLen, _file) == EOF)
+	|| (fwrite(atr, 1, atrLen, _file) != atrLen)) {
+		close();
+		return false;
+	}
+
+	_start = getTimestamp();
+	return true;
+}
+
+void SETraceRecorder::close(void) {
+	if(_file) {
+		fclose(_file);
+		_file = NULL;
+	}
+}
+
+bool SETraceRecorder::transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t timeout) {
+	uint32_t start, latency;
+	bool ret;
+
+	start = getTimestamp();
+	ret = _se->transmitApdu(apdu, apduLen, response, responseLen, timeout);
+	latency = getTimestamp() - start;
+
+	if(_file) {
+		write32(_file, start - _start);
+		write32(_file, latency);
+		write16(_file, apduLen);
+		fwrite(apdu, 1, apduLen, _file);
+		if(ret) {
+			write16(_file, *responseLen);
+			fwrite(response, 1, *responseLen, _file);
+		}
+		else {
+			write16(_file, 0);
+		}
+		fflush(_file);
+	}
+
+	return ret;
+}
+
+bool SETraceRecorder::getATR(uint8_t* atr, uint16_t* atrLen) {
+	return _se->getATR(atr, atrLen);
+}
+
+uint16_t SETraceRecorder::getMaxTransportLength(void) {
+	return _se->getMaxTransportLength();
+}
+
+bool SETraceRecorder::beginTransaction(void) {
+	return _se->beginTransaction();
+}
+
+void SETraceRecorder::endTransaction(bool pending) {
+	_se->endTransaction(pending);
+}
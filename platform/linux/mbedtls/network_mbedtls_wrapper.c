@@ -18,6 +18,7 @@
  
 #ifdef MBEDTLS_SE
 #include "mbedtls_se.h"
+#include "mbedtls/ssl_internal.h"
 #endif
 // -------------- 
  
@@ -84,6 +85,42 @@ static int _iot_tls_verify_cert(void *data, mbedtls_x509_crt *crt, int depth, ui
 	return 0;
 }
 
+/*
+ * Handshake as mbedtls_ssl_handshake. With the SE, it is run step by step so that the card gets
+ * ready to sign CertificateVerify while the rest of the server flight is received and verified.
+ */
+static int _iot_tls_handshake(mbedtls_ssl_context *ssl, mbedtls_pk_context *pkey) {
+#ifdef MBEDTLS_SE
+	int ret = 0;
+	int state;
+	mbedtls_md_type_t md_alg;
+
+	while(ssl->state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+		state = ssl->state;
+		if((ret = mbedtls_ssl_handshake_step(ssl)) != 0) {
+			break;
+		}
+
+		/* ServerHello parsed, the CertificateVerify digest is known from the ciphersuite (TLS 1.2) */
+		if(state == MBEDTLS_SSL_SERVER_HELLO && ssl->state != MBEDTLS_SSL_SERVER_HELLO &&
+		   ssl->minor_ver == MBEDTLS_SSL_MINOR_VERSION_3) {
+			md_alg = (ssl->transform_negotiate->ciphersuite_info->mac == MBEDTLS_MD_SHA384) ?
+					 MBEDTLS_MD_SHA384 : MBEDTLS_MD_SHA256;
+			if((ret = mbedtls_pk_prepare_se(pkey, md_alg)) != 0) {
+				/* Not fatal, CertificateVerify sets the card up itself */
+				IOT_DEBUG("  . mbedtls_pk_prepare_se returned -0x%x\n", -ret);
+				ret = 0;
+			}
+		}
+	}
+
+	return ret;
+#else
+	((void) pkey);
+	return mbedtls_ssl_handshake(ssl);
+#endif
+}
+
 void _iot_tls_set_connect_params(Network *pNetwork, char *pRootCALocation, char *pDeviceCertLocation,
 								 char *pDevicePrivateKeyLocation, char *pDestinationURL,
 								 uint16_t destinationPort, uint32_t timeout_ms, bool ServerVerificationFlag) {
@@ -110,6 +147,12 @@ IoT_Error_t iot_tls_init(Network *pNetwork, char *pRootCALocation, char *pDevice
 	pNetwork->destroy = iot_tls_destroy;
 
 	pNetwork->tlsDataParams.flags = 0;
+	// -- Gemalto ---
+	#ifdef MBEDTLS_SE
+	pNetwork->tlsDataParams.pSEContext = NULL;
+	pNetwork->tlsDataParams.pSECert = NULL;
+	#endif
+	// --------------
 
 	return SUCCESS;
 }
@@ -128,7 +171,9 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 	// -- Gemalto --- 
 	#ifdef MBEDTLS_SE
 	int certSize, pkeySize;
+	se_deadline_t seDeadline;
 	#endif
+	mbedtls_x509_crt *clicert;
 	// -------------- 
 #ifdef IOT_DEBUG
 	unsigned char buf[MBEDTLS_SSL_MAX_CONTENT_LEN + 1];
@@ -172,13 +217,27 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 
 	IOT_DEBUG("  . Loading the client cert. and key... ^_^ PIN:  %s  Location: %s", SE_CERTIFICATE_PIN, pNetwork->tlsConnectParams.pDeviceCertLocation);
 	#ifdef MBEDTLS_SE
-	ret = mbedtls_x509_crt_parse_se(&(tlsDataParams->clicert), pNetwork->tlsConnectParams.pDeviceCertLocation, (char*) SE_CERTIFICATE_PIN);
+	if(tlsDataParams->pSEContext == NULL) {
+		IOT_ERROR(" failed\n  !  no SE context set for the device cert and key\n\n");
+		return NETWORK_X509_DEVICE_CRT_PARSE_ERROR;
+	}
+	// Device certificate is held from the SE certificate cache until the network is destroyed, it is only read
+	// again if it changed on the SE. SE exchanges of this thread are bounded by the handshake timeout, so that a
+	// modem which stopped answering does not block, then the bound set by the caller, if any, is restored.
+	mbedtls_x509_crt_release_se(tlsDataParams->pSEContext, tlsDataParams->pSECert);
+	tlsDataParams->pSECert = NULL;
+	mbedtls_se_save_timeout(tlsDataParams->pSEContext, &seDeadline);
+	mbedtls_se_set_timeout(tlsDataParams->pSEContext, pNetwork->tlsConnectParams.timeout_ms);
+	ret = mbedtls_x509_crt_get_se(tlsDataParams->pSEContext, &clicert, pNetwork->tlsConnectParams.pDeviceCertLocation, (char*) SE_CERTIFICATE_PIN);
+	mbedtls_se_restore_timeout(tlsDataParams->pSEContext, &seDeadline);
+	tlsDataParams->pSECert = clicert;
 	IOT_DEBUG("  . After loading the client cert. and key... -_-");
 	if(ret != 0) {
 		IOT_ERROR(" failed\n  !  mbedtls_se_read_cert returned -0x%x while parsing device cert\n\n", -ret);
-		return NETWORK_X509_DEVICE_CRT_PARSE_ERROR;
+		return (ret == MBEDTLS_ERR_SE_TIMEOUT_ERROR) ? NETWORK_SSL_CONNECT_TIMEOUT_ERROR : NETWORK_X509_DEVICE_CRT_PARSE_ERROR;
 	}
 	#else
+	clicert = &(tlsDataParams->clicert);
 	ret = mbedtls_x509_crt_parse(&(tlsDataParams->clicert), (const unsigned char*) pNetwork->tlsConnectParams.pDeviceCertLocation, strlen(pNetwork->tlsConnectParams.pDeviceCertLocation) + 1);
 	if(ret != 0) {
 		IOT_ERROR(" failed\n  !  mbedtls_x509_crt_parse returned -0x%x while parsing device cert\n\n", -ret);
@@ -187,10 +246,12 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 	#endif	
 	IOT_DEBUG("  . After Loading the client cert. and key. Doing mbedtls_pk_parse_se()");
 	#ifdef MBEDTLS_SE
-	ret = mbedtls_pk_parse_se(&(tlsDataParams->pkey), pNetwork->tlsConnectParams.pDevicePrivateKeyLocation, (char*) SE_PRIVATE_KEY_PIN);
+	mbedtls_se_set_timeout(tlsDataParams->pSEContext, pNetwork->tlsConnectParams.timeout_ms);
+	ret = mbedtls_pk_parse_se(tlsDataParams->pSEContext, &(tlsDataParams->pkey), pNetwork->tlsConnectParams.pDevicePrivateKeyLocation, (char*) SE_PRIVATE_KEY_PIN);
+	mbedtls_se_restore_timeout(tlsDataParams->pSEContext, &seDeadline);
 	if(ret != 0) {
 		IOT_ERROR(" failed\n  !  mbedtls_se_read_priv_key returned -0x%x while parsing private key\n\n", -ret);
-		return NETWORK_PK_PRIVATE_KEY_PARSE_ERROR;
+		return (ret == MBEDTLS_ERR_SE_TIMEOUT_ERROR) ? NETWORK_SSL_CONNECT_TIMEOUT_ERROR : NETWORK_PK_PRIVATE_KEY_PARSE_ERROR;
 	}
 	#else
 	ret = mbedtls_pk_parse_key(&(tlsDataParams->pkey), (const unsigned char*) pNetwork->tlsConnectParams.pDevicePrivateKeyLocation, strlen(pNetwork->tlsConnectParams.pDevicePrivateKeyLocation) + 1, NULL, 0);
@@ -245,7 +306,7 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 	mbedtls_ssl_conf_rng(&(tlsDataParams->conf), mbedtls_ctr_drbg_random, &(tlsDataParams->ctr_drbg));
 
 	mbedtls_ssl_conf_ca_chain(&(tlsDataParams->conf), &(tlsDataParams->cacert), NULL);
-	if((ret = mbedtls_ssl_conf_own_cert(&(tlsDataParams->conf), &(tlsDataParams->clicert), &(tlsDataParams->pkey))) !=
+	if((ret = mbedtls_ssl_conf_own_cert(&(tlsDataParams->conf), clicert, &(tlsDataParams->pkey))) !=
 	   0) {
 		IOT_ERROR(" failed\n  ! mbedtls_ssl_conf_own_cert returned %d\n\n", ret);
 		return SSL_CONNECTION_ERROR;
@@ -268,20 +329,34 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 
 	IOT_DEBUG("\n\nSSL state connect : %d ", tlsDataParams->ssl.state);
 	IOT_DEBUG("  . Performing the SSL/TLS handshake...");
-	while((ret = mbedtls_ssl_handshake(&(tlsDataParams->ssl))) != 0) {
+	#ifdef MBEDTLS_SE
+	mbedtls_se_set_timeout(tlsDataParams->pSEContext, pNetwork->tlsConnectParams.timeout_ms);
+	#endif
+	while((ret = _iot_tls_handshake(&(tlsDataParams->ssl), &(tlsDataParams->pkey))) != 0) {
 		if(ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
-			IOT_ERROR(" failed\n  ! mbedtls_ssl_handshake returned -0x%x\n", -ret);
-			if(ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
-				IOT_ERROR("    Unable to verify the server's certificate. "
-							  "Either it is invalid,\n"
-							  "    or you didn't set ca_file or ca_path "
-							  "to an appropriate value.\n"
-							  "    Alternatively, you may want to use "
-							  "auth_mode=optional for testing purposes.\n");
-			}
-			return SSL_CONNECTION_ERROR;
+			break;
 		}
 	}
+	#ifdef MBEDTLS_SE
+	mbedtls_se_restore_timeout(tlsDataParams->pSEContext, &seDeadline);
+	#endif
+	if(ret != 0) {
+		IOT_ERROR(" failed\n  ! mbedtls_ssl_handshake returned -0x%x\n", -ret);
+		if(ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
+			IOT_ERROR("    Unable to verify the server's certificate. "
+						  "Either it is invalid,\n"
+						  "    or you didn't set ca_file or ca_path "
+						  "to an appropriate value.\n"
+						  "    Alternatively, you may want to use "
+						  "auth_mode=optional for testing purposes.\n");
+		}
+		#ifdef MBEDTLS_SE
+		if(ret == MBEDTLS_ERR_SE_TIMEOUT_ERROR) {
+			return NETWORK_SSL_CONNECT_TIMEOUT_ERROR;
+		}
+		#endif
+		return SSL_CONNECTION_ERROR;
+	}
 
 	IOT_DEBUG(" ok\n    [ Protocol is %s ]\n    [ Ciphersuite is %s ]\n", mbedtls_ssl_get_version(&(tlsDataParams->ssl)),
 		  mbedtls_ssl_get_ciphersuite(&(tlsDataParams->ssl)));
@@ -408,6 +483,14 @@ IoT_Error_t iot_tls_destroy(Network *pNetwork) {
 	mbedtls_net_free(&(tlsDataParams->server_fd));
 
 	mbedtls_x509_crt_free(&(tlsDataParams->clicert));
+	// -- Gemalto ---
+	#ifdef MBEDTLS_SE
+	if(tlsDataParams->pSECert != NULL) {
+		mbedtls_x509_crt_release_se(tlsDataParams->pSEContext, tlsDataParams->pSECert);
+		tlsDataParams->pSECert = NULL;
+	}
+	#endif
+	// --------------
 	mbedtls_x509_crt_free(&(tlsDataParams->cacert));
 	mbedtls_pk_free(&(tlsDataParams->pkey));
 	mbedtls_ssl_free(&(tlsDataParams->ssl));
@@ -28,6 +28,10 @@
 #include "mbedtls/debug.h"
 #include "mbedtls/timing.h"
 
+// -- Gemalto ---
+#include "aws_iot_config.h"
+// --------------
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -48,6 +52,12 @@ typedef struct _TLSDataParams {
 	mbedtls_x509_crt clicert;
 	mbedtls_pk_context pkey;
 	mbedtls_net_context server_fd;
+	// -- Gemalto ---
+	#ifdef MBEDTLS_SE
+	mbedtls_se_context *pSEContext;	///< SE holding the device certificate and private key, set once the network is initialized
+	mbedtls_x509_crt *pSECert;	///< Device certificate held from the SE certificate cache, NULL if none
+	#endif
+	// --------------
 }TLSDataParams;
 
 #define IOTSDKC_NETWORK_MBEDTLS_PLATFORM_H_H
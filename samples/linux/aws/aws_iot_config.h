@@ -76,6 +76,13 @@
 #define SE_CERTIFICATE_PIN   "0000" // MIAS
 #define SE_PRIVATE_KEY_PIN   "0000" // MIAS
 
+// Uncomment to keep mIAS metadata (key pairs, file directory, P11 objects location)
+// on disk so that a restart does not walk the card's directory again.
+//#define SE_METADATA_CACHE_FILE "se_metadata.cache"
+
+// Uncomment to print per INS APDU metrics (count, bytes, latency) once connected.
+//#define SE_STATS_REPORT
+
 #else
 
 #define AWS_IOT_CERTIFICATE_FILENAME   (char*) AWS_IOT_CERTIFICATE
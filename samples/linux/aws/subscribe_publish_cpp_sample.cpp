@@ -43,6 +43,29 @@
 #include "mbedtls_se.h"
 
 static CinterionModem modem;
+static mbedtls_se_context se;
+
+#ifdef SE_STATS_REPORT
+static void printSEStats(SEInterface* se) {
+	const se_stats_t* stats = se->getStats();
+	uint16_t i;
+
+	if(stats == NULL) {
+		return;
+	}
+
+	IOT_INFO("SE APDU metrics: %u commands, %u exchanges, %u bytes sent, %u bytes received, %lu ms",
+		stats->total.commands, stats->total.exchanges, stats->total.bytes_sent, stats->total.bytes_received,
+		(unsigned long) (stats->total.latency_total_us / 1000));
+	for(i=0; i<stats->count; i++) {
+		IOT_INFO("  INS %02X: %u commands, %u exchanges (61xx %u, 6Cxx %u, errors %u), %u/%u bytes, total %lu ms, max %u us",
+			stats->ins[i].ins, stats->ins[i].commands, stats->ins[i].exchanges,
+			stats->ins[i].retries_61xx, stats->ins[i].retries_6cxx, stats->ins[i].errors,
+			stats->ins[i].bytes_sent, stats->ins[i].bytes_received,
+			(unsigned long) (stats->ins[i].latency_total_us / 1000), stats->ins[i].latency_max_us);
+	}
+}
+#endif
 #endif
 
 const char AWS_IOT_ROOT_CA[] = "-----BEGIN CERTIFICATE-----\n"
@@ -176,6 +199,7 @@ void disconnectCallbackHandler(AWS_IoT_Client *pClient, void *data) {
 void intHandler(int dummy) {
 	IOT_INFO("\nBye bye\n");
 	#ifdef MBEDTLS_SE
+	mbedtls_se_free(&se);
 	modem.close();
 	#endif
 	exit(0);
@@ -207,7 +231,19 @@ int main(int argc, char **argv) {
 		IOT_ERROR("\nError modem not found!\n");
 		return -1;
 	}
-	mbedtls_se_init(&modem);
+	#ifdef SE_STATS_REPORT
+	modem.enableStats(true);
+	#endif
+	mbedtls_se_init(&se, &modem);
+	#ifdef SE_METADATA_CACHE_FILE
+	if(mbedtls_se_init_cache(&se, SE_METADATA_CACHE_FILE) != 0) {
+		IOT_INFO("No valid SE metadata snapshot, card directory will be read");
+	}
+	#endif
+	// CertificateVerify key setup overlaps with the server flight
+	if(mbedtls_se_start_worker(&se) != 0) {
+		IOT_INFO("No SE worker, card is set up on the handshake critical path");
+	}
 	#endif
 
         IOT_INFO("Setting initial init params");
@@ -241,6 +277,9 @@ int main(int argc, char **argv) {
 		IOT_ERROR("aws_iot_mqtt_init returned error : %d ", rc);
 		return rc;
 	}
+	#ifdef MBEDTLS_SE
+	client.networkStack.tlsDataParams.pSEContext = &se;
+	#endif
 
 	connectParams.keepAliveIntervalInSec = 10;
 	connectParams.isCleanSession = true;
@@ -257,6 +296,9 @@ int main(int argc, char **argv) {
 		return rc;
 	}
 	IOT_INFO("Connecting complete! setting auto-reconnect");
+	#ifdef SE_STATS_REPORT
+	printSEStats(&modem);
+	#endif
 	/*
 	 * Enable Auto Reconnect functionality. Minimum and Maximum time of Exponential backoff are set in aws_iot_config.h
 	 *  #AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL
@@ -331,6 +373,7 @@ int main(int argc, char **argv) {
 	}
 	
 	#ifdef MBEDTLS_SE
+	mbedtls_se_free(&se);
 	modem.close();
 	#endif
 
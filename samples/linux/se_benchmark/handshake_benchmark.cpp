@@ -0,0 +1,222 @@
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+// Measure how much of the CertificateVerify signature leaves the TLS handshake critical path
+// once the SE is prepared during the server flight (mbedtls_pk_prepare_se).
+//
+// The card exchanges are first recorded with the modem:
+//   handshake_benchmark record <trace> [key] [pin]
+// then replayed, waiting for each recorded exchange latency:
+//   handshake_benchmark replay <trace> [flight_ms] [iterations] [key] [pin]
+//
+// Each simulated handshake starts from a cold SE session (logical channels closed). The server
+// flight (ServerHello to ServerHelloDone, plus its processing) is simulated by flight_ms.
+//  - baseline:  flight, then the whole signature sequence (SELECT, VERIFY, MSE SET, PSO)
+//  - pipelined: preparation queued on the SE worker, flight, then only PSO is left
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "CinterionModem.h"
+#include "SETracePlayer.h"
+#include "SETraceRecorder.h"
+#include "mbedtls_se.h"
+
+#define DEFAULT_KEY          MBEDTLS_SE_MIAS_KEY_NAME_PREFIX "0"
+#define DEFAULT_PIN          "0000"
+#define DEFAULT_FLIGHT_MS    150
+#define DEFAULT_ITERATIONS   10
+
+// Fixed SHA-256 digest, the trace only matches when the same data is signed
+#define HASH_LENGTH          32
+#define HASH_BYTE            0x5A
+
+typedef struct {
+	uint64_t sign_us;   // Critical path: from the end of the flight to the signature
+	uint64_t total_us;  // From ServerHello to the signature
+} handshake_timing_t;
+
+static uint64_t now_us(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t) ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+// Run the client side of a handshake from ServerHello to CertificateVerify.
+// Returns true in case the signature was computed, false otherwise.
+static bool run_handshake(mbedtls_se_context* se, mbedtls_pk_context* pk, bool pipelined, uint32_t flight_ms, handshake_timing_t* timing) {
+	unsigned char hash[HASH_LENGTH];
+	unsigned char sig[MBEDTLS_MPI_MAX_SIZE];
+	size_t sig_len;
+	uint64_t start, signing;
+	int ret;
+
+	memset(hash, HASH_BYTE, sizeof(hash));
+
+	// Cold session, as on the first connection
+	mbedtls_se_close_session(se);
+	se->iface->closeChannels();
+
+	start = now_us();
+	if(pipelined && ((ret = mbedtls_pk_prepare_se(pk, MBEDTLS_MD_SHA256)) != 0)) {
+		printf("mbedtls_pk_prepare_se returned -0x%x\n", -ret);
+		return false;
+	}
+
+	usleep(flight_ms * 1000);
+
+	signing = now_us();
+	if((ret = mbedtls_pk_sign(pk, MBEDTLS_MD_SHA256, hash, sizeof(hash), sig, &sig_len, NULL, NULL)) != 0) {
+		printf("mbedtls_pk_sign returned -0x%x\n", -ret);
+		return false;
+	}
+
+	timing->sign_us = now_us() - signing;
+	timing->total_us = now_us() - start;
+	return true;
+}
+
+static int record(const char* path, const char* key, const char* pin) {
+	CinterionModem modem;
+	SETraceRecorder recorder(&modem);
+	mbedtls_se_context se;
+	mbedtls_pk_context pk;
+	handshake_timing_t timing;
+	bool ok;
+	int ret;
+
+	if(!modem.open()) {
+		printf("Modem not found\n");
+		return -1;
+	}
+	if(!recorder.open(path)) {
+		printf("Unable to create %s\n", path);
+		modem.close();
+		return -1;
+	}
+
+	mbedtls_se_init(&se, &recorder);
+	mbedtls_pk_init(&pk);
+
+	ok = false;
+	if((ret = mbedtls_pk_parse_se(&se, &pk, (char*) key, (char*) pin)) != 0) {
+		printf("mbedtls_pk_parse_se returned -0x%x\n", -ret);
+	}
+	else {
+		// Preparation runs synchronously without the worker, the same APDU are recorded
+		ok = run_handshake(&se, &pk, false, 0, &timing) && run_handshake(&se, &pk, true, 0, &timing);
+	}
+
+	mbedtls_pk_free(&pk);
+	mbedtls_se_free(&se);
+	recorder.close();
+	modem.close();
+
+	printf("%s %s\n", ok ? "Recorded" : "Failed to record", path);
+	return ok ? 0 : -1;
+}
+
+static int replay(const char* path, uint32_t flight_ms, uint32_t iterations, const char* key, const char* pin) {
+	SETracePlayer player;
+	mbedtls_se_context se;
+	mbedtls_pk_context pk;
+	handshake_timing_t timing;
+	uint64_t sign_us[2] = {0, 0};
+	uint64_t total_us[2] = {0, 0};
+	uint32_t i, mode;
+	int ret;
+
+	if(!player.open(path)) {
+		printf("Unable to load %s\n", path);
+		return -1;
+	}
+	player.setRealTime(true);
+
+	mbedtls_se_init(&se, &player);
+	mbedtls_pk_init(&pk);
+
+	if((ret = mbedtls_pk_parse_se(&se, &pk, (char*) key, (char*) pin)) != 0) {
+		printf("mbedtls_pk_parse_se returned -0x%x\n", -ret);
+		mbedtls_pk_free(&pk);
+		mbedtls_se_free(&se);
+		return -1;
+	}
+
+	if(mbedtls_se_start_worker(&se) != 0) {
+		printf("No SE worker, preparation runs on the critical path\n");
+	}
+
+	// Trace holds one baseline then one pipelined handshake, as recorded
+	for(i = 0; i < iterations; i++) {
+		player.rewind();
+		for(mode = 0; mode < 2; mode++) {
+			if(!run_handshake(&se, &pk, mode == 1, flight_ms, &timing)) {
+				mbedtls_pk_free(&pk);
+				mbedtls_se_free(&se);
+				return -1;
+			}
+			sign_us[mode] += timing.sign_us;
+			total_us[mode] += timing.total_us;
+		}
+	}
+
+	mbedtls_pk_free(&pk);
+	mbedtls_se_free(&se);
+
+	printf("%u iterations, %u ms server flight, %u APDU out of order, %u APDU not in trace\n",
+		iterations, flight_ms, player.getMismatches(), player.getMisses());
+	printf("             critical path     total\n");
+	printf("baseline     %8lu us  %8lu us\n", (unsigned long) (sign_us[0] / iterations), (unsigned long) (total_us[0] / iterations));
+	printf("pipelined    %8lu us  %8lu us\n", (unsigned long) (sign_us[1] / iterations), (unsigned long) (total_us[1] / iterations));
+	if((sign_us[0] > 0) && (total_us[0] > 0)) {
+		printf("reduction    %8.1f %%   %8.1f %%\n",
+			100.0 * ((double) sign_us[0] - (double) sign_us[1]) / (double) sign_us[0],
+			100.0 * ((double) total_us[0] - (double) total_us[1]) / (double) total_us[0]);
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	int iterations = (argc > 4) ? atoi(argv[4]) : DEFAULT_ITERATIONS;
+
+	if((argc >= 3) && (strcmp(argv[1], "record") == 0)) {
+		return record(argv[2], (argc > 3) ? argv[3] : DEFAULT_KEY, (argc > 4) ? argv[4] : DEFAULT_PIN);
+	}
+
+	// Report averages over the iterations, at least one is needed
+	if((argc >= 3) && (strcmp(argv[1], "replay") == 0) && (iterations > 0)) {
+		return replay(argv[2],
+			(argc > 3) ? (uint32_t) atoi(argv[3]) : DEFAULT_FLIGHT_MS,
+			(uint32_t) iterations,
+			(argc > 5) ? argv[5] : DEFAULT_KEY, (argc > 6) ? argv[6] : DEFAULT_PIN);
+	}
+
+	printf("Usage: %s record <trace> [key] [pin]\n", argv[0]);
+	printf("       %s replay <trace> [flight_ms] [iterations] [key] [pin]\n", argv[0]);
+	return -1;
+}
@@ -0,0 +1,280 @@
+/*
+ *  Copyright (c) 2017 Gemalto Limited. All Rights Reserved
+ *  This software is the confidential and proprietary information of GEMALTO.
+ *  
+ *  GEMALTO MAKES NO REPRESENTATIONS OR WARRANTIES ABOUT THE SUITABILITY OF 
+ *  THE SOFTWARE, EITHER EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED
+ *  TO THE IMPLIED WARRANTIES OR MERCHANTABILITY, FITNESS FOR A
+ *  PARTICULAR PURPOSE, OR NON-INFRINGEMENT. GEMALTO SHALL NOT BE
+ *  LIABLE FOR ANY DAMAGES SUFFERED BY LICENSEE AS RESULT OF USING,
+ *  MODIFYING OR DISTRIBUTING THIS SOFTWARE OR ITS DERIVATIVES.
+
+ *  THIS SOFTWARE IS NOT DESIGNED OR INTENDED FOR USE OR RESALE AS ON-LINE
+ *  CONTROL EQUIPMENT IN HAZARDOUS ENVIRONMENTS REQUIRING FAIL-SAFE
+ *  PERFORMANCE, SUCH AS IN THE OPERATION OF NUCLEAR FACILITIES, AIRCRAFT
+ *  NAVIGATION OR COMMUNICATION SYSTEMS, AIR TRAFFIC CONTROL, DIRECT LIFE
+ *  SUPPORT MACHINES, OR WEAPONS SYSTEMS, IN WHICH THE FAILURE OF THE
+ *  SOFTWARE COULD LEAD DIRECTLY TO DEATH, PERSONAL INJURY, OR SEVERE
+ *  PHYSICAL OR ENVIRONMENTAL DAMAGE ("HIGH RISK ACTIVITIES"). GEMALTO
+ *  SPECIFICALLY DISCLAIMS ANY EXPRESS OR IMPLIED WARRANTY OF FTNESS FOR
+ *  HIGH RISK ACTIVITIES;
+ *
+ */
+
+// Measure the CPU cost of AT+CSIM framing per APDU: hex encoding of the command, line framing
+// and hex decoding of the response. The modem is replaced by an in-memory serial line which
+// answers each command with a canned response, so that only host processing is measured.
+//   hex_benchmark [iterations]
+//
+// legacy: previous ATInterface::sendATCSIM (buffer malloc, sprintf per byte, branchy decoding,
+//         one recv per byte)
+// table:  ATInterface::sendATCSIM (per interface buffer, Hex.h lookup tables, ring buffer lines)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ATInterface.h"
+#include "Hex.h"
+
+#define DEFAULT_ITERATIONS   20000
+
+// Serial line answering each command with the canned response.
+class MemorySerial: public Serial {
+	public:
+		MemorySerial(const char* response) {
+			_response = response;
+			_len = strlen(response);
+			_off = _len;
+		}
+
+		bool start(void) {
+			return true;
+		}
+
+		bool stop(void) {
+			return true;
+		}
+
+		bool send(char* data, unsigned long int toWrite, unsigned long int* written) {
+			_off = 0;
+			*written = toWrite;
+			return true;
+		}
+
+		uint32_t getTime(void) {
+			return 0;
+		}
+
+	protected:
+		long int receive(char* data, unsigned long int size, uint32_t timeout) {
+			if(size > (_len - _off)) {
+				size = _len - _off;
+			}
+			memcpy(data, &_response[_off], size);
+			_off += size;
+			return size;
+		}
+
+	private:
+		const char* _response;
+		unsigned long int _len;
+		unsigned long int _off;
+};
+
+// Previous implementation, kept for comparison.
+class LegacyATInterface {
+	public:
+		LegacyATInterface(Serial* serial) {
+			_serial = serial;
+		}
+
+		bool sendATCSIM(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen) {
+			char* buf;
+			uint16_t i;
+			unsigned long int off, len, size;
+
+			size = 32 + (2 * (apduLen > (SE_MAX_DATA_LENGTH + 2) ? apduLen : (SE_MAX_DATA_LENGTH + 2)));
+
+			off = 0;
+			buf = (char*) malloc(size * sizeof(char));
+
+			off += sprintf(&buf[off], "AT+CSIM=%d,\"", apduLen * 2);
+			for(i=0; i<apduLen; i++) {
+				off += sprintf(&buf[off], "%02X", apdu[i]);
+			}
+			off += sprintf(&buf[off], "\"\r\n");
+
+			_serial->send(buf, off, &len);
+			memset(buf, 0, size);
+
+			do {
+				readLine(buf, &len);
+				if(memcmp(buf, "ERROR\r\n", 7) == 0) {
+					free(buf);
+					return false;
+				}
+			} while((memcmp(buf, "+CSIM: ", 7) != 0));
+
+			off = 7;
+			*responseLen = 0;
+			while(buf[off] != ',') {
+				*responseLen *= 10;
+				*responseLen += buf[off] - '0';
+				off++;
+			}
+
+			while( !(((buf[off] >= '0') && (buf[off] <= '9')) ||
+				   ((buf[off] >= 'A') && (buf[off] <= 'F')) ||
+				   ((buf[off] >= 'a') && (buf[off] <= 'f'))
+				   )) {
+				off++;
+			}
+
+			hexString2BytesArray((uint8_t*) &buf[off], *responseLen, response, responseLen);
+
+			do {
+				readLine(buf, &len);
+			} while(memcmp(buf, "OK\r\n", 4) != 0);
+
+			free(buf);
+			return true;
+		}
+
+	private:
+		bool hexString2BytesArray(uint8_t* hexstr, uint16_t hexstrLen, uint8_t* bytes, uint16_t* bytesLen) {
+			uint8_t d;
+			uint16_t i, j;
+
+			*bytesLen = 0;
+			for(i = 0; i < hexstrLen; *bytesLen += 1) {
+				d = 0;
+				for(j = i + 2; i < j; i++) {
+					d <<= 4;
+					if((hexstr[i] >= '0') && (hexstr[i] <= '9')) {
+						d |= hexstr[i] - '0';
+					}
+					else if((hexstr[i] >= 'a') && (hexstr[i] <= 'f')) {
+						d |= hexstr[i] - 'a' + 10;
+					}
+					else if((hexstr[i] >= 'A') && (hexstr[i] <= 'F')) {
+						d |= hexstr[i] - 'A' + 10;
+					}
+				}
+				*bytes = d;
+				bytes++;
+			}
+
+			return true;
+		}
+
+		bool readLine(char* data, unsigned long int* len) {
+			unsigned long int off;
+			unsigned long int read;
+
+			off = 0;
+			read = 0;
+			do {
+				if(!_serial->recv(&data[off], 1, &read)) {
+					return false;
+				}
+				if(read) {
+					off += read;
+					if(data[off - 1] == '\n') {
+						break;
+					}
+				}
+			} while(1);
+
+			*len = off;
+			return true;
+		}
+
+		Serial* _serial;
+};
+
+typedef struct {
+	const char* name;
+	uint16_t    command_len;
+	uint16_t    response_len;   // Status word included
+} workload_t;
+
+static const workload_t WORKLOADS[] = {
+	{"READ BINARY 256",    5,   258},
+	{"UPDATE BINARY 255",  260, 2},
+	{"PSO 256 / 256",      261, 258},
+	{"extended 1024",      7,   1026}
+};
+
+static uint64_t cpu_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ((uint64_t) ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+// Build the modem answer to a command, response bytes are i & 0xFF, then 9000.
+static char* build_response(uint16_t responseLen) {
+	uint8_t* bytes = (uint8_t*) malloc(responseLen);
+	char* line = (char*) malloc(64 + (2 * responseLen));
+	int off;
+	uint16_t i;
+
+	for(i=0; i<(responseLen - 2); i++) {
+		bytes[i] = i;
+	}
+	bytes[responseLen - 2] = 0x90;
+	bytes[responseLen - 1] = 0x00;
+
+	off = sprintf(line, "\r\n+CSIM: %d,\"", 2 * responseLen);
+	hex_encode(bytes, responseLen, &line[off]);
+	off += 2 * responseLen;
+	strcpy(&line[off], "\"\r\n\r\nOK\r\n");
+
+	free(bytes);
+	return line;
+}
+
+int main(int argc, char** argv) {
+	int iterations = (argc > 1) ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+	uint8_t apdu[APDU_EXT_DATA_OFFSET + SE_MAX_DATA_LENGTH + 2];
+	uint8_t response[SE_MAX_DATA_LENGTH + 2];
+	uint16_t responseLen;
+	uint64_t start, legacy_ns, table_ns;
+	unsigned int w;
+	int i;
+
+	memset(apdu, 0xA5, sizeof(apdu));
+	printf("%-20s %12s %12s %8s\n", "workload", "legacy ns", "table ns", "speedup");
+
+	for(w=0; w<(sizeof(WORKLOADS) / sizeof(WORKLOADS[0])); w++) {
+		char* line = build_response(WORKLOADS[w].response_len);
+		MemorySerial legacySerial(line);
+		MemorySerial tableSerial(line);
+		LegacyATInterface legacy(&legacySerial);
+		ATInterface table(&tableSerial);
+
+		start = cpu_ns();
+		for(i=0; i<iterations; i++) {
+			responseLen = sizeof(response);
+			legacy.sendATCSIM(apdu, WORKLOADS[w].command_len, response, &responseLen);
+		}
+		legacy_ns = (cpu_ns() - start) / iterations;
+
+		start = cpu_ns();
+		for(i=0; i<iterations; i++) {
+			responseLen = sizeof(response);
+			if(!table.sendATCSIM(apdu, WORKLOADS[w].command_len, response, &responseLen, SERIAL_WAIT_FOREVER) || (responseLen != WORKLOADS[w].response_len)) {
+				printf("ERROR: %s response\n", WORKLOADS[w].name);
+				return 1;
+			}
+		}
+		table_ns = (cpu_ns() - start) / iterations;
+
+		printf("%-20s %12llu %12llu %7.1fx\n", WORKLOADS[w].name, (unsigned long long) legacy_ns, (unsigned long long) table_ns, (double) legacy_ns / table_ns);
+		free(line);
+	}
+
+	return 0;
+}
@@ -0,0 +1,345 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_se_apdu.cpp
+ * @brief IoT Client Unit Testing - Secure Element APDU Assembly Tests
+ */
+
+#include <string.h>
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+#include "SEInterface.h"
+
+#define RECORDING_SE_MAX_EXCHANGES 8
+#define RECORDING_SE_MAX_APDU      (7 + SE_MAX_DATA_LENGTH + 2)
+
+/* Records the APDUs sent and answers them with the queued responses, 9000 once none is left.
+ * An ATR announcing extended length support is given when asked for. */
+class RecordingSE : public SEInterface {
+	public:
+		RecordingSE(bool extended) {
+			_extended = extended;
+			_sent = 0;
+			_replies = 0;
+			_next = 0;
+		}
+
+		void reply(const uint8_t* response, uint16_t len) {
+			memcpy(_replyData[_replies], response, len);
+			_replyLen[_replies] = len;
+			_replies++;
+		}
+
+		void reply(uint16_t sw) {
+			uint8_t response[2] = { (uint8_t) (sw >> 8), (uint8_t) sw };
+
+			reply(response, sizeof(response));
+		}
+
+		uint8_t _apdus[RECORDING_SE_MAX_EXCHANGES][RECORDING_SE_MAX_APDU];
+		uint16_t _apduLens[RECORDING_SE_MAX_EXCHANGES];
+		uint16_t _sent;
+
+	protected:
+		bool transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t /* timeout */) {
+			if(_sent == RECORDING_SE_MAX_EXCHANGES) {
+				return false;
+			}
+
+			memcpy(_apdus[_sent], apdu, apduLen);
+			_apduLens[_sent] = apduLen;
+			_sent++;
+
+			if(_next == _replies) {
+				response[0] = 0x90;
+				response[1] = 0x00;
+				*responseLen = 2;
+			}
+			else {
+				memcpy(response, _replyData[_next], _replyLen[_next]);
+				*responseLen = _replyLen[_next];
+				_next++;
+			}
+			return true;
+		}
+
+		bool getATR(uint8_t* atr, uint16_t* atrLen) {
+			/* Card capabilities (compact-TLV tag 7) with extended Lc and Le */
+			const uint8_t extendedATR[] = { 0x3B, 0x05, 0x80, 0x73, 0x00, 0x00, 0x40 };
+
+			if(!_extended) {
+				return false;
+			}
+
+			memcpy(atr, extendedATR, sizeof(extendedATR));
+			*atrLen = sizeof(extendedATR);
+			return true;
+		}
+
+	private:
+		bool _extended;
+		uint8_t _replyData[RECORDING_SE_MAX_EXCHANGES][SE_SHORT_MAX_DATA_LENGTH + 2];
+		uint16_t _replyLen[RECORDING_SE_MAX_EXCHANGES];
+		uint16_t _replies;
+		uint16_t _next;
+};
+
+static uint8_t data[600];
+
+TEST_GROUP(SEApdu) {
+	void setup() {
+		uint16_t i;
+
+		for(i = 0; i < sizeof(data); i++) {
+			data[i] = (uint8_t) i;
+		}
+	}
+};
+
+/* Case 1: header only */
+TEST(SEApdu, Case1) {
+	RecordingSE se(false);
+	const uint8_t expected[] = { 0x80, 0xCA, 0x01, 0x02 };
+
+	CHECK(se.transmit(0x80, 0xCA, 0x01, 0x02));
+
+	LONGS_EQUAL(1, se._sent);
+	LONGS_EQUAL(sizeof(expected), se._apduLens[0]);
+	MEMCMP_EQUAL(expected, se._apdus[0], sizeof(expected));
+}
+
+/* Case 2: header and Le */
+TEST(SEApdu, Case2) {
+	RecordingSE se(false);
+	const uint8_t expected[] = { 0x00, 0xB0, 0x00, 0x00, 0x10 };
+
+	CHECK(se.transmit(0x00, 0xB0, 0x00, 0x00, 0x10));
+
+	LONGS_EQUAL(sizeof(expected), se._apduLens[0]);
+	MEMCMP_EQUAL(expected, se._apdus[0], sizeof(expected));
+}
+
+/* Case 3: header, Lc and data */
+TEST(SEApdu, Case3) {
+	RecordingSE se(false);
+	const uint8_t expected[] = { 0x00, 0xD6, 0x00, 0x00, 0x03, 0x00, 0x01, 0x02 };
+
+	CHECK(se.transmit(0x00, 0xD6, 0x00, 0x00, data, 3));
+
+	LONGS_EQUAL(sizeof(expected), se._apduLens[0]);
+	MEMCMP_EQUAL(expected, se._apdus[0], sizeof(expected));
+}
+
+/* Case 4: header, Lc, data and Le */
+TEST(SEApdu, Case4) {
+	RecordingSE se(false);
+	const uint8_t expected[] = { 0x00, 0x88, 0x00, 0x00, 0x03, 0x00, 0x01, 0x02, 0x00 };
+
+	CHECK(se.transmit(0x00, 0x88, 0x00, 0x00, data, 3, 0x00));
+
+	LONGS_EQUAL(sizeof(expected), se._apduLens[0]);
+	MEMCMP_EQUAL(expected, se._apdus[0], sizeof(expected));
+}
+
+/* 6Cxx on a command with Le: sent again once, Le replaced by the length given by the SE */
+TEST(SEApdu, WrongLeResent) {
+	RecordingSE se(false);
+	const uint8_t response[] = { 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0x90, 0x00 };
+	uint8_t received[8];
+
+	se.reply(0x6C08);
+	se.reply(response, sizeof(response));
+
+	CHECK(se.transmit(0x00, 0x88, 0x00, 0x00, data, 3, 0x00));
+
+	LONGS_EQUAL(2, se._sent);
+	LONGS_EQUAL(9, se._apduLens[1]);
+	MEMCMP_EQUAL(se._apdus[0], se._apdus[1], 8);
+	BYTES_EQUAL(0x08, se._apdus[1][8]);
+	LONGS_EQUAL(0x9000, se.getStatusWord());
+	LONGS_EQUAL(8, se.getResponse(received));
+	MEMCMP_EQUAL(response, received, 8);
+}
+
+/* 6Cxx answered again: not resent a second time */
+TEST(SEApdu, WrongLeResentOnce) {
+	RecordingSE se(false);
+
+	se.reply(0x6C08);
+	se.reply(0x6C04);
+
+	CHECK(se.transmit(0x00, 0xB0, 0x00, 0x00, 0x00));
+
+	LONGS_EQUAL(2, se._sent);
+	LONGS_EQUAL(0x6C04, se.getStatusWord());
+}
+
+/* 6Cxx on a command without Le: returned as is, nothing is patched into the command data */
+TEST(SEApdu, WrongLeNotResentWithoutLe) {
+	RecordingSE se(false);
+
+	se.reply(0x6C08);
+	CHECK(se.transmit(0x00, 0xD6, 0x00, 0x00, data, 3));
+	LONGS_EQUAL(1, se._sent);
+	LONGS_EQUAL(0x6C08, se.getStatusWord());
+
+	se.reply(0x6C08);
+	CHECK(se.transmit(0x80, 0xCA, 0x01, 0x02));
+	LONGS_EQUAL(2, se._sent);
+	LONGS_EQUAL(0x6C08, se.getStatusWord());
+}
+
+/* 61xx: response completed by GET RESPONSE on the same channel */
+TEST(SEApdu, GetResponse) {
+	RecordingSE se(false);
+	const uint8_t first[] = { 0xB0, 0xB1, 0xB2, 0xB3, 0x61, 0x02 };
+	const uint8_t last[] = { 0xB4, 0xB5, 0x90, 0x00 };
+	const uint8_t getResponse[] = { 0x01, 0xC0, 0x00, 0x00, 0x02 };
+	uint8_t received[6];
+
+	se.reply(first, sizeof(first));
+	se.reply(last, sizeof(last));
+
+	CHECK(se.transmit(0x81, 0xCA, 0x00, 0x00, 0x00));
+
+	LONGS_EQUAL(2, se._sent);
+	LONGS_EQUAL(sizeof(getResponse), se._apduLens[1]);
+	MEMCMP_EQUAL(getResponse, se._apdus[1], sizeof(getResponse));
+	LONGS_EQUAL(0x9000, se.getStatusWord());
+	LONGS_EQUAL(6, se.getResponse(received));
+	MEMCMP_EQUAL(first, received, 4);
+	MEMCMP_EQUAL(last, &received[4], 2);
+}
+
+/* Short encoding is kept when it fits, even with extended length support */
+TEST(SEApdu, ExtendedShortWhenFits) {
+	RecordingSE se(true);
+	const uint8_t expected[] = { 0x00, 0x88, 0x00, 0x00, 0x03, 0x00, 0x01, 0x02, 0x10 };
+
+	CHECK(se.detectExtendedLength());
+	CHECK(se.transmitExtended(0x00, 0x88, 0x00, 0x00, data, 3, 0x10));
+
+	LONGS_EQUAL(sizeof(expected), se._apduLens[0]);
+	MEMCMP_EQUAL(expected, se._apdus[0], sizeof(expected));
+}
+
+/* Extended case 2: 00 then two bytes Le */
+TEST(SEApdu, ExtendedCase2) {
+	RecordingSE se(true);
+	const uint8_t expected[] = { 0x00, 0xB0, 0x00, 0x00, 0x00, 0x03, 0x00 };
+
+	CHECK(se.detectExtendedLength());
+	CHECK(se.transmitExtended(0x00, 0xB0, 0x00, 0x00, NULL, 0, 0x300));
+
+	LONGS_EQUAL(sizeof(expected), se._apduLens[0]);
+	MEMCMP_EQUAL(expected, se._apdus[0], sizeof(expected));
+}
+
+/* Extended case 3: 00 then two bytes Lc and data, no Le */
+TEST(SEApdu, ExtendedCase3) {
+	RecordingSE se(true);
+	const uint8_t header[] = { 0x00, 0xD6, 0x00, 0x00, 0x00, 0x01, 0x2C };
+
+	CHECK(se.detectExtendedLength());
+	CHECK(se.transmitExtended(0x00, 0xD6, 0x00, 0x00, data, 300, 0));
+
+	LONGS_EQUAL(1, se._sent);
+	LONGS_EQUAL(sizeof(header) + 300, se._apduLens[0]);
+	MEMCMP_EQUAL(header, se._apdus[0], sizeof(header));
+	MEMCMP_EQUAL(data, &se._apdus[0][sizeof(header)], 300);
+}
+
+/* Extended case 4: 00, two bytes Lc, data and two bytes Le */
+TEST(SEApdu, ExtendedCase4) {
+	RecordingSE se(true);
+	const uint8_t header[] = { 0x00, 0x88, 0x00, 0x00, 0x00, 0x01, 0x2C };
+
+	CHECK(se.detectExtendedLength());
+	CHECK(se.transmitExtended(0x00, 0x88, 0x00, 0x00, data, 300, 0x200));
+
+	LONGS_EQUAL(sizeof(header) + 300 + 2, se._apduLens[0]);
+	MEMCMP_EQUAL(header, se._apdus[0], sizeof(header));
+	MEMCMP_EQUAL(data, &se._apdus[0][sizeof(header)], 300);
+	BYTES_EQUAL(0x02, se._apdus[0][sizeof(header) + 300]);
+	BYTES_EQUAL(0x00, se._apdus[0][sizeof(header) + 301]);
+}
+
+/* 6Cxx on an extended command: Le is two bytes, nothing is resent */
+TEST(SEApdu, ExtendedWrongLeNotResent) {
+	RecordingSE se(true);
+
+	CHECK(se.detectExtendedLength());
+	se.reply(0x6C08);
+	CHECK(se.transmitExtended(0x00, 0xB0, 0x00, 0x00, NULL, 0, 0x300));
+
+	LONGS_EQUAL(1, se._sent);
+	LONGS_EQUAL(0x6C08, se.getStatusWord());
+}
+
+/* Without extended length, data is sent in 255 byte blocks with the chaining bit, but the last one */
+TEST(SEApdu, CommandChaining) {
+	RecordingSE se(false);
+	const uint8_t block[] = { 0x10, 0xD6, 0x00, 0x00, 0xFF };
+	const uint8_t last[] = { 0x00, 0xD6, 0x00, 0x00, 0x5A, 0x10 };
+
+	CHECK(se.transmitExtended(0x00, 0xD6, 0x00, 0x00, data, 600, 0x10));
+
+	LONGS_EQUAL(3, se._sent);
+
+	LONGS_EQUAL(sizeof(block) + 255, se._apduLens[0]);
+	MEMCMP_EQUAL(block, se._apdus[0], sizeof(block));
+	MEMCMP_EQUAL(data, &se._apdus[0][5], 255);
+
+	LONGS_EQUAL(sizeof(block) + 255, se._apduLens[1]);
+	MEMCMP_EQUAL(block, se._apdus[1], sizeof(block));
+	MEMCMP_EQUAL(&data[255], &se._apdus[1][5], 255);
+
+	/* Le only on the last block */
+	LONGS_EQUAL(5 + 90 + 1, se._apduLens[2]);
+	MEMCMP_EQUAL(last, se._apdus[2], 5);
+	MEMCMP_EQUAL(&data[510], &se._apdus[2][5], 90);
+	BYTES_EQUAL(0x10, se._apdus[2][95]);
+}
+
+/* A rejected block stops the chain, its status word is returned */
+TEST(SEApdu, CommandChainingStopsOnError) {
+	RecordingSE se(false);
+
+	se.reply(0x9000);
+	se.reply(0x6A80);
+
+	CHECK(se.transmitExtended(0x00, 0xD6, 0x00, 0x00, data, 600, 0));
+
+	LONGS_EQUAL(2, se._sent);
+	LONGS_EQUAL(0x6A80, se.getStatusWord());
+}
+
+/* Ne never exceeds what the response buffer can hold */
+TEST(SEApdu, NeCappedByResponseBuffer) {
+	RecordingSE se(true);
+	const uint8_t expected[] = { 0x00, 0xB0, 0x00, 0x00, 0x10 };
+	uint8_t response[18];
+	uint16_t responseLen = sizeof(response);
+
+	CHECK(se.detectExtendedLength());
+	CHECK(se.transmitExtended(0x00, 0xB0, 0x00, 0x00, NULL, 0, 0x300, response, &responseLen));
+
+	LONGS_EQUAL(sizeof(expected), se._apduLens[0]);
+	MEMCMP_EQUAL(expected, se._apdus[0], sizeof(expected));
+	LONGS_EQUAL(0, responseLen);
+	LONGS_EQUAL(0x9000, se.getStatusWord());
+}
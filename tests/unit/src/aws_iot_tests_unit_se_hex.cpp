@@ -0,0 +1,103 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_se_hex.cpp
+ * @brief IoT Client Unit Testing - Secure Element Hex Codec Tests
+ */
+
+#include <string.h>
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+#include "Hex.h"
+
+TEST_GROUP(SEHex) {
+};
+
+/* Bytes are encoded as upper case digits, high nibble first, without terminator */
+TEST(SEHex, EncodeUpperCase) {
+	uint8_t bytes[] = { 0x00, 0x1F, 0xA5, 0xFF };
+	char hex[10];
+
+	memset(hex, '#', sizeof(hex));
+	hex_encode(bytes, sizeof(bytes), hex);
+
+	MEMCMP_EQUAL("001FA5FF", hex, 8);
+	BYTES_EQUAL('#', hex[8]);
+}
+
+/* Nothing is written for an empty input */
+TEST(SEHex, EncodeEmpty) {
+	char hex[2] = { '#', '#' };
+
+	hex_encode(NULL, 0, hex);
+
+	BYTES_EQUAL('#', hex[0]);
+}
+
+/* Every byte value survives an encode / decode round trip */
+TEST(SEHex, RoundTripAllBytes) {
+	uint8_t bytes[256], decoded[256];
+	char hex[512];
+	uint16_t i;
+
+	for(i = 0; i < 256; i++) {
+		bytes[i] = (uint8_t) i;
+	}
+
+	hex_encode(bytes, sizeof(bytes), hex);
+	CHECK(hex_decode(hex, sizeof(hex), decoded));
+
+	MEMCMP_EQUAL(bytes, decoded, sizeof(bytes));
+}
+
+/* Lower and upper case digits are both accepted */
+TEST(SEHex, DecodeMixedCase) {
+	uint8_t expected[] = { 0xAB, 0xCD, 0xEF, 0x09 };
+	uint8_t bytes[4];
+
+	CHECK(hex_decode("aBcDeF09", 8, bytes));
+
+	MEMCMP_EQUAL(expected, bytes, sizeof(expected));
+}
+
+/* Decoding in place, as done on AT+CSIM responses, reads each digit pair before overwriting it */
+TEST(SEHex, DecodeInPlace) {
+	uint8_t expected[] = { 0x90, 0x00, 0x6A, 0x82 };
+	char buf[] = "90006A82";
+
+	CHECK(hex_decode(buf, 8, (uint8_t*) buf));
+
+	MEMCMP_EQUAL(expected, buf, sizeof(expected));
+}
+
+/* An odd number of digits is rejected */
+TEST(SEHex, DecodeOddLengthFails) {
+	uint8_t bytes[2];
+
+	CHECK(!hex_decode("123", 3, bytes));
+}
+
+/* Characters next to the digit ranges in ASCII are rejected */
+TEST(SEHex, DecodeNonHexFails) {
+	const char* invalid[] = { "/0", ":0", "@0", "G0", "`0", "g0", " 0", "0\xC1" };
+	uint8_t bytes[1];
+	uint16_t i;
+
+	for(i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+		CHECK(!hex_decode(invalid[i], 2, bytes));
+	}
+}
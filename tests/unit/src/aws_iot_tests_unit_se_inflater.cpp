@@ -0,0 +1,233 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_se_inflater.cpp
+ * @brief IoT Client Unit Testing - Secure Element Inflater Tests
+ */
+
+#include <string.h>
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+#include "Applet.h"
+#include "Inflater.h"
+
+/* Applet selected on the basic channel, EF content served to READ BINARY */
+class MemoryEF : public SEInterface {
+	public:
+		MemoryEF(const uint8_t* content, uint16_t size) {
+			_content = content;
+			_size = size;
+			_reads = 0;
+		}
+
+		uint16_t _reads;
+
+	protected:
+		bool transmitApdu(uint8_t* apdu, uint16_t apduLen, uint8_t* response, uint16_t* responseLen, uint32_t /* timeout */) {
+			uint16_t offset, len;
+
+			if(apdu[1] == 0xA4) {
+				response[0] = 0x90;
+				response[1] = 0x00;
+				*responseLen = 2;
+				return true;
+			}
+
+			if((apduLen != 5) || (apdu[1] != 0xB0)) {
+				return false;
+			}
+
+			offset = (apdu[2] << 8) | apdu[3];
+			len = apdu[4] ? apdu[4] : 256;
+			_reads++;
+
+			if(offset + len > _size) {
+				response[0] = 0x6B;
+				response[1] = 0x00;
+				*responseLen = 2;
+				return true;
+			}
+
+			memcpy(response, &_content[offset], len);
+			response[len] = 0x90;
+			response[len + 1] = 0x00;
+			*responseLen = len + 2;
+			return true;
+		}
+
+	private:
+		const uint8_t* _content;
+		uint16_t _size;
+};
+
+/* zlib.compress(b"Secure element", 0): stored block */
+static const uint8_t STORED[] = {
+	0x78, 0x01, 0x01, 0x0E, 0x00, 0xF1, 0xFF, 0x53, 0x65, 0x63, 0x75, 0x72, 0x65, 0x20, 0x65, 0x6C,
+	0x65, 0x6D, 0x65, 0x6E, 0x74, 0x27, 0xDC, 0x05, 0x72
+};
+static const char STORED_TEXT[] = "Secure element";
+
+/* zlib.compress(b"abcabcabcabcabcabcabcabc", 9): fixed Huffman block with a back reference */
+static const uint8_t FIXED[] = {
+	0x78, 0xDA, 0x4B, 0x4C, 0x4A, 0x4E, 0xC4, 0x86, 0x00, 0x72, 0xE0, 0x09, 0x31
+};
+static const char FIXED_TEXT[] = "abcabcabcabcabcabcabcabc";
+
+/* zlib.compress(DYNAMIC_TEXT, 9): dynamic Huffman block */
+static const uint8_t DYNAMIC[] = {
+	0x78, 0xDA, 0x45, 0x8F, 0xD1, 0x6D, 0xC3, 0x30, 0x0C, 0x44, 0x57, 0xB9, 0x01, 0x82, 0x2C, 0xD0,
+	0xCF, 0xAC, 0xD0, 0x05, 0x58, 0xF9, 0x1C, 0x11, 0x56, 0x49, 0x83, 0x62, 0x6D, 0x64, 0xFB, 0xB2,
+	0x06, 0x82, 0xFE, 0xDE, 0xD3, 0xE9, 0x1D, 0x3F, 0x3B, 0x31, 0xD9, 0x7E, 0x82, 0xE0, 0xE0, 0x37,
+	0x2D, 0xB1, 0x91, 0xFB, 0x44, 0x16, 0xD8, 0x43, 0x0F, 0x49, 0x56, 0xF2, 0x82, 0xAF, 0x57, 0xB4,
+	0xF0, 0xD0, 0xC6, 0x3B, 0x1E, 0x8C, 0xD4, 0x55, 0x5B, 0xE1, 0x09, 0xA9, 0x76, 0x50, 0x16, 0xB8,
+	0x35, 0x42, 0x6C, 0xA9, 0xC6, 0x9E, 0x50, 0x43, 0x93, 0xD6, 0xF9, 0x51, 0xF9, 0x78, 0xFD, 0xD5,
+	0x35, 0xB0, 0xAA, 0x3D, 0x19, 0xF5, 0x73, 0x99, 0x74, 0xA2, 0x70, 0xDB, 0xB8, 0x40, 0x9E, 0x52,
+	0xCF, 0xCF, 0x4E, 0xBB, 0x34, 0xC6, 0x3C, 0x3D, 0x36, 0x34, 0x37, 0x63, 0xCB, 0x79, 0xC3, 0xF4,
+	0x02, 0x92, 0x17, 0xED, 0xA5, 0x98, 0x5D, 0xB6, 0x9A, 0xE3, 0xA5, 0x37, 0x4F, 0x9C, 0xA2, 0x89,
+	0xD5, 0xE3, 0xE2, 0x67, 0xF7, 0x41, 0xB4, 0xFF, 0x89, 0x48, 0xC7, 0xD7, 0x7B, 0xE3, 0xC1, 0x80,
+	0x60, 0x0E, 0x3F, 0xEB, 0xF2, 0x50, 0x19, 0x18, 0x6A, 0xBC, 0xFF, 0x02, 0x57, 0xAD, 0x60, 0x63
+};
+static const char DYNAMIC_TEXT[] = "The secure element keeps the private key of the device. Certificates are read once and "
+	"kept in cache; only their fingerprint is checked again when the network connects, so that the handshake "
+	"does not wait for the whole certificate to be read over a slow serial line.";
+
+static uint8_t aid[] = { 0xA0, 0x00, 0x00, 0x00, 0x18 };
+
+TEST_GROUP(SEInflater) {
+};
+
+/* Stored block is copied as is */
+TEST(SEInflater, StoredBlock) {
+	MemoryEF ef(STORED, sizeof(STORED));
+	Applet applet(aid, sizeof(aid));
+	uint8_t data[sizeof(STORED_TEXT) - 1];
+
+	applet.init(&ef);
+	CHECK(applet.select(true));
+	Inflater inflater(&applet, 0, sizeof(STORED), SE_SHORT_MAX_DATA_LENGTH);
+
+	CHECK(inflater.inflate(data, sizeof(data)));
+	MEMCMP_EQUAL(STORED_TEXT, data, sizeof(data));
+}
+
+/* Fixed Huffman block, the repeated pattern being copied from the output window */
+TEST(SEInflater, FixedHuffmanBlock) {
+	MemoryEF ef(FIXED, sizeof(FIXED));
+	Applet applet(aid, sizeof(aid));
+	uint8_t data[sizeof(FIXED_TEXT) - 1];
+
+	applet.init(&ef);
+	CHECK(applet.select(true));
+	Inflater inflater(&applet, 0, sizeof(FIXED), SE_SHORT_MAX_DATA_LENGTH);
+
+	CHECK(inflater.inflate(data, sizeof(data)));
+	MEMCMP_EQUAL(FIXED_TEXT, data, sizeof(data));
+	LONGS_EQUAL(1, ef._reads);
+}
+
+/* Dynamic Huffman block, trees decoded from the stream */
+TEST(SEInflater, DynamicHuffmanBlock) {
+	MemoryEF ef(DYNAMIC, sizeof(DYNAMIC));
+	Applet applet(aid, sizeof(aid));
+	uint8_t data[sizeof(DYNAMIC_TEXT) - 1];
+
+	applet.init(&ef);
+	CHECK(applet.select(true));
+	Inflater inflater(&applet, 0, sizeof(DYNAMIC), SE_SHORT_MAX_DATA_LENGTH);
+
+	CHECK(inflater.inflate(data, sizeof(data)));
+	MEMCMP_EQUAL(DYNAMIC_TEXT, data, sizeof(data));
+}
+
+/* Stream read by small chunks, codes straddling chunk boundaries */
+TEST(SEInflater, SmallChunks) {
+	MemoryEF ef(DYNAMIC, sizeof(DYNAMIC));
+	Applet applet(aid, sizeof(aid));
+	uint8_t data[sizeof(DYNAMIC_TEXT) - 1];
+
+	applet.init(&ef);
+	CHECK(applet.select(true));
+	Inflater inflater(&applet, 0, sizeof(DYNAMIC), 7);
+
+	CHECK(inflater.inflate(data, sizeof(data)));
+	MEMCMP_EQUAL(DYNAMIC_TEXT, data, sizeof(data));
+	LONGS_EQUAL((sizeof(DYNAMIC) + 6) / 7, ef._reads);
+}
+
+/* Output shorter or longer than expected is rejected */
+TEST(SEInflater, UnexpectedLengthFails) {
+	MemoryEF ef(FIXED, sizeof(FIXED));
+	Applet applet(aid, sizeof(aid));
+	uint8_t data[sizeof(FIXED_TEXT)];
+
+	applet.init(&ef);
+	CHECK(applet.select(true));
+
+	Inflater shorter(&applet, 0, sizeof(FIXED), SE_SHORT_MAX_DATA_LENGTH);
+	CHECK(!shorter.inflate(data, sizeof(FIXED_TEXT) - 2));
+
+	Inflater longer(&applet, 0, sizeof(FIXED), SE_SHORT_MAX_DATA_LENGTH);
+	CHECK(!longer.inflate(data, sizeof(FIXED_TEXT)));
+}
+
+/* Adler-32 mismatch is reported */
+TEST(SEInflater, BadChecksumFails) {
+	uint8_t stream[sizeof(STORED)];
+	uint8_t data[sizeof(STORED_TEXT) - 1];
+
+	memcpy(stream, STORED, sizeof(STORED));
+	stream[sizeof(stream) - 1] ^= 0x01;
+
+	MemoryEF ef(stream, sizeof(stream));
+	Applet applet(aid, sizeof(aid));
+	applet.init(&ef);
+	CHECK(applet.select(true));
+	Inflater inflater(&applet, 0, sizeof(stream), SE_SHORT_MAX_DATA_LENGTH);
+
+	CHECK(!inflater.inflate(data, sizeof(data)));
+}
+
+/* Stream ending before its checksum is reported */
+TEST(SEInflater, TruncatedStreamFails) {
+	MemoryEF ef(DYNAMIC, sizeof(DYNAMIC));
+	Applet applet(aid, sizeof(aid));
+	uint8_t data[sizeof(DYNAMIC_TEXT) - 1];
+
+	applet.init(&ef);
+	CHECK(applet.select(true));
+	Inflater inflater(&applet, 0, sizeof(DYNAMIC) - 2, SE_SHORT_MAX_DATA_LENGTH);
+
+	CHECK(!inflater.inflate(data, sizeof(data)));
+}
+
+/* Header other than deflate without preset dictionary is rejected */
+TEST(SEInflater, BadHeaderFails) {
+	uint8_t stream[sizeof(FIXED)];
+	uint8_t data[sizeof(FIXED_TEXT) - 1];
+
+	memcpy(stream, FIXED, sizeof(FIXED));
+	stream[1] = 0xBB; /* FDICT set, check bits still valid */
+
+	MemoryEF ef(stream, sizeof(stream));
+	Applet applet(aid, sizeof(aid));
+	applet.init(&ef);
+	CHECK(applet.select(true));
+	Inflater inflater(&applet, 0, sizeof(stream), SE_SHORT_MAX_DATA_LENGTH);
+
+	CHECK(!inflater.inflate(data, sizeof(data)));
+	LONGS_EQUAL(1, ef._reads);
+}
@@ -0,0 +1,287 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_se_serial.cpp
+ * @brief IoT Client Unit Testing - Secure Element Serial Line Framing Tests
+ */
+
+#include <string.h>
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+#include "Serial.h"
+
+#define MEMORY_SERIAL_MAX_CHUNKS 64
+
+/* Serial line fed from memory: each queued chunk is what one low layer read returns, at most
+ * the room left in the receive buffer. Waiting for data which never comes advances the clock. */
+class MemorySerial : public Serial {
+	public:
+		MemorySerial(void) {
+			_count = 0;
+			_next = 0;
+			_pos = 0;
+			_now = 0;
+			_receives = 0;
+		}
+
+		bool start(void) {
+			return true;
+		}
+
+		bool send(char* /* data */, unsigned long int toWrite, unsigned long int* written) {
+			*written = toWrite;
+			return true;
+		}
+
+		bool stop(void) {
+			return true;
+		}
+
+		uint32_t getTime(void) {
+			return _now;
+		}
+
+		void queue(const char* data, uint32_t len) {
+			_chunks[_count] = data;
+			_lengths[_count] = len;
+			_count++;
+		}
+
+		void queue(const char* line) {
+			queue(line, strlen(line));
+		}
+
+		uint32_t _receives;
+
+	protected:
+		long int receive(char* data, unsigned long int size, uint32_t timeout) {
+			uint32_t len;
+
+			_receives++;
+			if(_next == _count) {
+				_now += (timeout == SERIAL_WAIT_FOREVER) ? 1 : timeout;
+				return 0;
+			}
+
+			len = _lengths[_next] - _pos;
+			if(len > size) {
+				len = size;
+			}
+			memcpy(data, &_chunks[_next][_pos], len);
+			_pos += len;
+			if(_pos == _lengths[_next]) {
+				_next++;
+				_pos = 0;
+			}
+			return len;
+		}
+
+	private:
+		const char* _chunks[MEMORY_SERIAL_MAX_CHUNKS];
+		uint32_t _lengths[MEMORY_SERIAL_MAX_CHUNKS];
+		uint32_t _count;
+		uint32_t _next;
+		uint32_t _pos;
+		uint32_t _now;
+};
+
+TEST_GROUP(SESerial) {
+};
+
+/* A line received in several chunks is returned once its '\n' arrived */
+TEST(SESerial, LineAcrossChunks) {
+	MemorySerial serial;
+	char line[32];
+	unsigned long int len = sizeof(line);
+
+	serial.queue("+CSIM: 4,");
+	serial.queue("\"9000\"\r");
+	serial.queue("\n");
+
+	CHECK(serial.readLine(line, &len, 100));
+
+	LONGS_EQUAL(17, len);
+	MEMCMP_EQUAL("+CSIM: 4,\"9000\"\r\n", line, len);
+}
+
+/* Lines received within a single chunk are framed one by one from the receive buffer */
+TEST(SESerial, SeveralLinesInOneChunk) {
+	MemorySerial serial;
+	char line[32];
+	unsigned long int len;
+
+	serial.queue("\r\nOK\r\n+CREG: 1\r\n");
+
+	len = sizeof(line);
+	CHECK(serial.readLine(line, &len, 100));
+	LONGS_EQUAL(2, len);
+
+	len = sizeof(line);
+	CHECK(serial.readLine(line, &len, 100));
+	LONGS_EQUAL(4, len);
+	MEMCMP_EQUAL("OK\r\n", line, len);
+
+	len = sizeof(line);
+	CHECK(serial.readLine(line, &len, 100));
+	LONGS_EQUAL(10, len);
+	MEMCMP_EQUAL("+CREG: 1\r\n", line, len);
+
+	/* Single low layer read for the three lines */
+	LONGS_EQUAL(1, serial._receives);
+}
+
+/* A line longer than the caller buffer is returned in parts, the last one ending with '\n' */
+TEST(SESerial, LongLineInParts) {
+	MemorySerial serial;
+	char line[8];
+	unsigned long int len;
+
+	serial.queue("0123456789ABCDEF\n");
+
+	len = sizeof(line);
+	CHECK(serial.readLine(line, &len, 100));
+	LONGS_EQUAL(8, len);
+	MEMCMP_EQUAL("01234567", line, len);
+
+	len = sizeof(line);
+	CHECK(serial.readLine(line, &len, 100));
+	LONGS_EQUAL(8, len);
+	MEMCMP_EQUAL("89ABCDEF", line, len);
+
+	len = sizeof(line);
+	CHECK(serial.readLine(line, &len, 100));
+	LONGS_EQUAL(1, len);
+	BYTES_EQUAL('\n', line[0]);
+}
+
+/* A partial line is kept buffered on timeout and completed by the next read */
+TEST(SESerial, PartialLineKeptOnTimeout) {
+	MemorySerial serial;
+	char line[32];
+	unsigned long int len = sizeof(line);
+
+	serial.queue("+CSIM: 4,\"90");
+
+	CHECK(!serial.readLine(line, &len, 100));
+	LONGS_EQUAL(0, len);
+	CHECK(serial.getTime() >= 100);
+
+	serial.queue("00\"\r\n");
+	len = sizeof(line);
+	CHECK(serial.readLine(line, &len, 100));
+
+	LONGS_EQUAL(17, len);
+	MEMCMP_EQUAL("+CSIM: 4,\"9000\"\r\n", line, len);
+}
+
+/* An empty caller buffer never reads a line */
+TEST(SESerial, EmptyBufferFails) {
+	MemorySerial serial;
+	char line[1];
+	unsigned long int len = 0;
+
+	serial.queue("OK\r\n");
+
+	CHECK(!serial.readLine(line, &len, 100));
+	LONGS_EQUAL(0, serial._receives);
+}
+
+/* Raw reads take what lines left in the receive buffer first */
+TEST(SESerial, RecvAfterLine) {
+	MemorySerial serial;
+	char line[32], data[8];
+	unsigned long int len = sizeof(line), read;
+
+	serial.queue("> \r\nABC");
+	serial.queue("DEFGH");
+
+	CHECK(serial.readLine(line, &len, 100));
+	LONGS_EQUAL(4, len);
+
+	CHECK(serial.recv(data, 8, &read));
+	LONGS_EQUAL(8, read);
+	MEMCMP_EQUAL("ABCDEFGH", data, 8);
+}
+
+/* Flush drops the buffered bytes and what the low layer still has */
+TEST(SESerial, FlushDropsPending) {
+	MemorySerial serial;
+	char line[32];
+	unsigned long int len = sizeof(line);
+
+	serial.queue("late response\r\n");
+	serial.queue("+CSIM: 4,\"6F00\"\r\n");
+	serial.flush();
+	serial.queue("OK\r\n");
+
+	CHECK(serial.readLine(line, &len, 100));
+
+	LONGS_EQUAL(4, len);
+	MEMCMP_EQUAL("OK\r\n", line, len);
+}
+
+/* Lines keep their content when they wrap around the end of the receive buffer */
+TEST(SESerial, RingBufferWrapAround) {
+	MemorySerial serial;
+	static char lines[SERIAL_RX_BUFFER_SIZE / 8 * 3][8];
+	char line[16];
+	unsigned long int len;
+	uint32_t i, count = sizeof(lines) / sizeof(lines[0]);
+
+	/* 8 byte lines, fed 24 lines per chunk so that chunks straddle the end of the buffer */
+	for(i = 0; i < count; i++) {
+		memcpy(lines[i], "LINE", 4);
+		lines[i][4] = 'A' + (i % 26);
+		lines[i][5] = '0' + (i % 10);
+		lines[i][6] = '\r';
+		lines[i][7] = '\n';
+	}
+	for(i = 0; i < count; i += 24) {
+		serial.queue(lines[i], 8 * (((count - i) < 24) ? (count - i) : 24));
+	}
+
+	for(i = 0; i < count; i++) {
+		len = sizeof(line);
+		CHECK(serial.readLine(line, &len, 100));
+		LONGS_EQUAL(8, len);
+		MEMCMP_EQUAL(lines[i], line, len);
+	}
+}
+
+/* A line filling the whole receive buffer is returned in parts instead of blocking */
+TEST(SESerial, LineLongerThanReceiveBuffer) {
+	MemorySerial serial;
+	static char data[SERIAL_RX_BUFFER_SIZE + 4];
+	static char line[SERIAL_RX_BUFFER_SIZE * 2];
+	unsigned long int len, total = 0;
+
+	memset(data, 'F', sizeof(data));
+	data[sizeof(data) - 1] = '\n';
+	serial.queue(data, sizeof(data));
+
+	len = sizeof(line);
+	CHECK(serial.readLine(line, &len, 100));
+	LONGS_EQUAL(SERIAL_RX_BUFFER_SIZE, len);
+	total += len;
+
+	len = sizeof(line);
+	CHECK(serial.readLine(line, &len, 100));
+	total += len;
+
+	LONGS_EQUAL(sizeof(data), total);
+	BYTES_EQUAL('\n', line[len - 1]);
+}